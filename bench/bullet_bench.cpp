@@ -0,0 +1,178 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include "data/data.hpp"
+#include "sim/batch.hpp"
+#include "sim/bullets.hpp"
+#include "sim/game.hpp"
+
+namespace {
+
+// Counted by the replaced operator new below
+size_t allocations = 0;
+
+const size_t POOL_OPERATIONS = 1000000;
+const size_t WARMUP_STEPS = 500;
+const size_t STEPS = 5000;
+
+/**
+ * @brief Small linear congruential generator, so every run is the same.
+ */
+uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/**
+ * @brief Spawns and removes bullets at random and checks every handle
+ *        against a map of the bullets that should be in flight.
+ */
+bool checkPool()
+{
+    auto bullets = std::make_unique<data::BulletStore>();
+    std::unordered_map<data::BulletHandle, int16_t> live;
+    std::vector<data::BulletHandle> spent;
+    uint32_t state = 3;
+    for (size_t oi = 0; oi < POOL_OPERATIONS; ++oi) {
+        // Fill up and drain in turns, so the pool runs full and empty
+        const bool filling = (oi / 50000) % 2 == 0;
+        if (nextRandom(state) % 4 != 0 ? filling : !filling) {
+            int16_t x = static_cast<int16_t>(nextRandom(state) % 30000);
+            data::BulletHandle handle = sim::spawnBullet(*bullets, x, 0, 1, data::BULLET_PLAYER);
+            if ((handle == data::NO_BULLET) != (live.size() == GAME_MAX_BULLETS)) {
+                fprintf(stderr, "Spawn with %zu in flight gave handle %u.\n", live.size(), handle);
+                return false;
+            }
+            if (handle != data::NO_BULLET) {
+                live[handle] = x;
+            }
+        } else if (bullets->count) {
+            size_t bi = nextRandom(state) % bullets->count;
+            data::BulletHandle handle = sim::bulletHandle(*bullets, bi);
+            if (!live.erase(handle)) {
+                fprintf(stderr, "Entry %zu has unknown handle %u.\n", bi, handle);
+                return false;
+            }
+            sim::removeBullet(*bullets, bi);
+            if (spent.size() < 4096) {
+                spent.push_back(handle);
+            }
+        }
+
+        if (oi % 997 == 0) {
+            if (live.size() != bullets->count) {
+                fprintf(stderr, "%zu bullets in flight, expected %zu.\n", bullets->count, live.size());
+                return false;
+            }
+            for (const auto& [handle, x] : live) {
+                size_t bi = sim::findBullet(*bullets, handle);
+                if (bi == bullets->count || bullets->x[bi] != x) {
+                    fprintf(stderr, "Handle %u lost its bullet.\n", handle);
+                    return false;
+                }
+            }
+            for (data::BulletHandle handle : spent) {
+                if (!live.count(handle) && sim::findBullet(*bullets, handle) != bullets->count) {
+                    fprintf(stderr, "Spent handle %u still finds a bullet.\n", handle);
+                    return false;
+                }
+            }
+        }
+    }
+    printf("%zu spawns and removals over %zu slots, every handle checked\n", POOL_OPERATIONS, bullets->numSlots);
+    return true;
+}
+
+/**
+ * @brief Sets up a game where the formation fires a volley every step.
+ */
+void newBulletHell(data::Game& game, sim::CollisionGrid& grid)
+{
+    sim::newGame(game, 224, 256);
+    sim::buildAlienGrid(grid, game);
+    game.player.life = 1000000;
+    game.fire.period = 1;
+    game.fire.timer = 1;
+    game.fire.volley = 256;
+    game.fire.maxBullets = static_cast<uint16_t>(std::min<size_t>(GAME_MAX_BULLETS, 65535));
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC takes the free below for a mismatch once it inlines these into
+// callers of new, they do pair with the malloc above
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+#pragma GCC diagnostic pop
+
+int main()
+{
+    printf("Bullet pool of %d\n", GAME_MAX_BULLETS);
+    if (!checkPool()) {
+        return 1;
+    }
+
+    auto game = std::make_unique<data::Game>();
+    sim::CollisionGrid grid;
+    newBulletHell(*game, grid);
+
+    size_t restarts = 0;
+    size_t peak = 0;
+    size_t bulletSteps = 0;
+    size_t steadyAllocations = 0;
+    double seconds = 0.0;
+    for (size_t si = 0; si < WARMUP_STEPS + STEPS; ++si) {
+        if (si == WARMUP_STEPS) {
+            steadyAllocations = allocations;
+        }
+        // Start over once the formation is gone or has landed
+        if (!game->aliens.numAlive || !game->player.life) {
+            newBulletHell(*game, grid);
+            ++restarts;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        sim::step(*game, sim::autopilotInput(0, *game), grid);
+        if (si >= WARMUP_STEPS) {
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            bulletSteps += game->bullets.count;
+            peak = std::max(peak, game->bullets.count);
+        }
+    }
+    steadyAllocations = allocations - steadyAllocations;
+
+    printf("%zu steps, %zu restarts, %.0f bullets in flight on average, %zu at most\n",
+           STEPS, restarts, static_cast<double>(bulletSteps) / STEPS, peak);
+    printf("%.1f us/step, %.1f ns per bullet and step, %zu heap allocations\n",
+           seconds / STEPS * 1e6, seconds / bulletSteps * 1e9, steadyAllocations);
+
+    if (steadyAllocations) {
+        fprintf(stderr, "Stepping allocated from the heap\n");
+        return 1;
+    }
+    return 0;
+}
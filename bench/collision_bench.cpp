@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "data/collision_mask.hpp"
+#include "data/data.hpp"
+#include "sim/collision_grid.hpp"
+#include "sim/shields.hpp"
+#include "sprites/aliens.hpp"
+#include "sprites/player.hpp"
+#include "sprites/shield.hpp"
+#include "util/utility.hpp"
+
+namespace {
+
+const size_t AREA_WIDTH = 2048;
+const size_t AREA_HEIGHT = 1024;
+const size_t ALIEN_COLS = 100;
+const size_t ALIEN_ROWS = 40;
+const size_t MAX_TESTS = 1 << 22;
+
+/**
+ * @brief Position, sprite and mask of an alien.
+ */
+struct Alien {
+    size_t x;
+    size_t y;
+    const data::Sprite* sprite;
+    const data::CollisionMask* mask;
+};
+
+/**
+ * @brief Checks whether a bullet hits an alien, boxes first, then pixels.
+ */
+bool overlaps(const data::Location& bullet, const Alien& alien)
+{
+    return util::spriteOverlapCheck(sprites::BULLET_SPRITE, bullet.x, bullet.y, *alien.sprite, alien.x, alien.y)
+        && data::masksOverlap(sprites::BULLET_MASK, bullet.x, bullet.y, *alien.mask, alien.x, alien.y);
+}
+
+std::vector<Alien> makeAliens()
+{
+    std::vector<Alien> aliens;
+    for (size_t yi = 0; yi < ALIEN_ROWS; ++yi) {
+        for (size_t xi = 0; xi < ALIEN_COLS; ++xi) {
+            size_t frame = 2 * (yi % 3) + (xi & 1);
+            aliens.push_back({20 * xi + 8, 24 * yi + 32, &sprites::ALIEN_SPRITES[frame], &sprites::ALIEN_MASKS[frame]});
+        }
+    }
+    return aliens;
+}
+
+/**
+ * @brief Small linear congruential generator, so every run is the same.
+ */
+uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+data::CollisionMask randomMask(uint32_t& state, size_t maxWidth, size_t maxHeight)
+{
+    data::CollisionMask mask(1 + nextRandom(state) % maxWidth, 1 + nextRandom(state) % maxHeight);
+    for (size_t yi = 0; yi < mask.height; ++yi) {
+        for (size_t xi = 0; xi < mask.width; ++xi) {
+            // Sparse, so overlapping boxes often have no common pixel
+            mask.set(xi, yi, nextRandom(state) % 16 == 0);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Checks two masks pixel by pixel.
+ */
+bool masksOverlapReference(
+    const data::CollisionMask& maskA, ptrdiff_t xA, ptrdiff_t yA,
+    const data::CollisionMask& maskB, ptrdiff_t xB, ptrdiff_t yB
+){
+    for (size_t yi = 0; yi < maskA.height; ++yi) {
+        for (size_t xi = 0; xi < maskA.width; ++xi) {
+            ptrdiff_t bx = xA + static_cast<ptrdiff_t>(xi) - xB;
+            ptrdiff_t by = yA + static_cast<ptrdiff_t>(yi) - yB;
+            if (maskA.test(xi, yi) && bx >= 0 && by >= 0
+                && bx < static_cast<ptrdiff_t>(maskB.width) && by < static_cast<ptrdiff_t>(maskB.height)
+                && maskB.test(bx, by)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Tests random mask pairs against the pixel by pixel reference and times them.
+ *
+ * @return bool False if an answer differs from the reference.
+ */
+bool checkMasks(const char* name, size_t maxWidth, size_t maxHeight)
+{
+    const size_t NUM_MASKS = 64;
+    const size_t NUM_PAIRS = 20000;
+    uint32_t state = 777;
+    std::vector<data::CollisionMask> masks;
+    for (size_t i = 0; i < NUM_MASKS; ++i) {
+        masks.push_back(randomMask(state, maxWidth, maxHeight));
+    }
+
+    struct Pair {
+        size_t a;
+        size_t b;
+        ptrdiff_t dx;
+        ptrdiff_t dy;
+    };
+    std::vector<Pair> pairs;
+    size_t hits = 0;
+    for (size_t i = 0; i < NUM_PAIRS; ++i) {
+        Pair pair{nextRandom(state) % NUM_MASKS, nextRandom(state) % NUM_MASKS, 0, 0};
+        const data::CollisionMask& a = masks[pair.a];
+        const data::CollisionMask& b = masks[pair.b];
+        // Offsets where the boxes overlap, like after a passed box test
+        pair.dx = static_cast<ptrdiff_t>(nextRandom(state) % (a.width + b.width - 1)) - static_cast<ptrdiff_t>(b.width - 1);
+        pair.dy = static_cast<ptrdiff_t>(nextRandom(state) % (a.height + b.height - 1)) - static_cast<ptrdiff_t>(b.height - 1);
+        // Around 0 as well, to cover wrapped positions
+        size_t xA = 4 - nextRandom(state) % 8;
+        size_t yA = 4 - nextRandom(state) % 8;
+        bool expected = masksOverlapReference(a, xA, yA, b, xA + pair.dx, yA + pair.dy);
+        if (data::masksOverlap(a, xA, yA, b, xA + pair.dx, yA + pair.dy) != expected) {
+            fprintf(stderr, "%s masks disagree with the reference.\n", name);
+            return false;
+        }
+        hits += expected ? 1 : 0;
+        pairs.push_back(pair);
+    }
+
+    const size_t ROUNDS = 50;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t ri = 0; ri < ROUNDS; ++ri) {
+        for (const Pair& pair : pairs) {
+            found += data::masksOverlap(masks[pair.a], 100, 100, masks[pair.b], 100 + pair.dx, 100 + pair.dy);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / (ROUNDS * NUM_PAIRS);
+    printf("%-24s %6zu of %zu pairs overlap, %6.1f ns/pair\n", name, hits, NUM_PAIRS, ns);
+    return found == hits * ROUNDS;
+}
+
+/**
+ * @brief Shields with a byte per pixel, bottom row first.
+ */
+struct ShieldPixels {
+    bool lit[data::SHIELD_COUNT][data::SHIELD_HEIGHT][data::SHIELD_WIDTH];
+};
+
+ShieldPixels unpackShields(const data::ShieldStore& shields)
+{
+    ShieldPixels pixels{};
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        for (size_t bank = 0; bank < data::SHIELD_BANKS; ++bank) {
+            data::PackedSprite sprite = sim::shieldBank(shields, si, bank);
+            for (size_t yi = 0; yi < sprite.height; ++yi) {
+                for (size_t xi = 0; xi < sprite.width; ++xi) {
+                    pixels.lit[si][sprite.height - 1 - yi][data::PACKED_MAX_WIDTH * bank + xi] = (sprite.rows[yi] >> xi) & 1;
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+/**
+ * @brief Visits the lit pixels of a packed sprite at a position that fall
+ *        on a shield, with the pixel's column and row in the shield.
+ */
+template <typename Visit>
+void forShieldPixels(
+    const data::ShieldStore& shields, size_t si,
+    const data::PackedSprite& sprite, ptrdiff_t x, ptrdiff_t y, Visit visit
+){
+    for (size_t yi = 0; yi < sprite.height; ++yi) {
+        for (size_t xi = 0; xi < sprite.width; ++xi) {
+            ptrdiff_t sx = x + static_cast<ptrdiff_t>(xi) - shields.x[si];
+            ptrdiff_t sy = y + static_cast<ptrdiff_t>(sprite.height - 1 - yi) - shields.y[si];
+            if (((sprite.rows[yi] >> xi) & 1)
+                && sx >= 0 && sx < static_cast<ptrdiff_t>(data::SHIELD_WIDTH)
+                && sy >= 0 && sy < static_cast<ptrdiff_t>(data::SHIELD_HEIGHT)) {
+                visit(static_cast<size_t>(sx), static_cast<size_t>(sy));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fires bullets at the shields, checks hits and craters against
+ *        a pixel by pixel model and times the mask path on its own.
+ */
+bool checkShields()
+{
+    const size_t ROUNDS = 50;
+    const size_t BULLETS = 4000;
+    const data::PackedSprite& bullet = sprites::BULLET_SPRITE_PACKED;
+    const data::PackedSprite& crater = sprites::SHIELD_CRATER_SPRITE_PACKED;
+
+    uint32_t state = 7;
+    std::vector<data::Location> bullets(BULLETS);
+    size_t hits = 0;
+    double seconds = 0.0;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        data::ShieldStore shields{};
+        sim::resetShields(shields, 224, 48);
+        for (data::Location& location : bullets) {
+            location.x = nextRandom(state) % 232 - 4;
+            location.y = 40 + nextRandom(state) % 30;
+        }
+
+        ShieldPixels pixels = unpackShields(shields);
+        for (const data::Location& location : bullets) {
+            ptrdiff_t bx = static_cast<ptrdiff_t>(location.x);
+            ptrdiff_t by = static_cast<ptrdiff_t>(location.y);
+            size_t expected = data::SHIELD_COUNT;
+            for (size_t si = 0; si < data::SHIELD_COUNT && expected == data::SHIELD_COUNT; ++si) {
+                forShieldPixels(shields, si, bullet, bx, by, [&](size_t sx, size_t sy) {
+                    if (pixels.lit[si][sy][sx]) {
+                        expected = si;
+                    }
+                });
+            }
+
+            size_t si = sim::hitShield(shields, sprites::BULLET_MASK, location.x, location.y);
+            if (si != expected) {
+                fprintf(stderr, "Bullet at %td, %td hit shield %zu, expected %zu.\n", bx, by, si, expected);
+                return false;
+            }
+            if (si < data::SHIELD_COUNT) {
+                sim::erodeShield(shields, si, crater, bx - 4, by - 3);
+                forShieldPixels(shields, si, crater, bx - 4, by - 3, [&](size_t sx, size_t sy) {
+                    pixels.lit[si][sy][sx] = false;
+                });
+            }
+        }
+
+        ShieldPixels packed = unpackShields(shields);
+        if (!std::equal(&packed.lit[0][0][0], &packed.lit[0][0][0] + sizeof(packed.lit), &pixels.lit[0][0][0])) {
+            fprintf(stderr, "Eroded shields differ from the pixel by pixel model.\n");
+            return false;
+        }
+
+        // The same volley again, timed without the model
+        sim::resetShields(shields, 224, 48);
+        auto start = std::chrono::steady_clock::now();
+        for (const data::Location& location : bullets) {
+            size_t si = sim::hitShield(shields, sprites::BULLET_MASK, location.x, location.y);
+            if (si < data::SHIELD_COUNT) {
+                sim::erodeShield(shields, si, crater, location.x - 4, location.y - 3);
+                ++hits;
+            }
+        }
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    printf("%zu bullets at the shields, %zu hits, %.1f ns/bullet, shields match\n",
+           ROUNDS * BULLETS, hits, seconds / (ROUNDS * BULLETS) * 1e9);
+    return true;
+}
+
+std::vector<data::Location> makeBullets(size_t count)
+{
+    std::vector<data::Location> bullets(count);
+    uint32_t state = 12345;
+    for (data::Location& bullet : bullets) {
+        bullet.x = nextRandom(state) % AREA_WIDTH;
+        bullet.y = nextRandom(state) % AREA_HEIGHT;
+    }
+    return bullets;
+}
+
+size_t hitsBruteForce(const std::vector<Alien>& aliens, const std::vector<data::Location>& bullets)
+{
+    size_t hits = 0;
+    for (const data::Location& bullet : bullets) {
+        for (const Alien& alien : aliens) {
+            if (overlaps(bullet, alien)) {
+                ++hits;
+            }
+        }
+    }
+    return hits;
+}
+
+size_t hitsGrid(
+    sim::CollisionGrid& grid, const std::vector<Alien>& aliens,
+    const std::vector<data::Location>& bullets
+){
+    size_t hits = 0;
+    for (const data::Location& bullet : bullets) {
+        grid.query(bullet.x, bullet.y, sprites::BULLET_SPRITE.width, sprites::BULLET_SPRITE.height,
+            [&](size_t ai) {
+                if (overlaps(bullet, aliens[ai])) {
+                    ++hits;
+                }
+            }
+        );
+    }
+    return hits;
+}
+
+template<typename Test>
+double measure(size_t rounds, size_t numBullets, size_t& hits, Test test)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t ri = 0; ri < rounds; ++ri) {
+        hits = test();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (rounds * numBullets);
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<Alien> aliens = makeAliens();
+    sim::CollisionGrid grid;
+    grid.reset(AREA_WIDTH, AREA_HEIGHT, aliens.size());
+    for (size_t ai = 0; ai < aliens.size(); ++ai) {
+        const Alien& alien = aliens[ai];
+        grid.insert(ai, alien.x, alien.y, alien.sprite->width, alien.sprite->height);
+    }
+
+    printf("%zu aliens in %zux%zu\n", aliens.size(), AREA_WIDTH, AREA_HEIGHT);
+    printf("%8s %8s %16s %16s\n", "bullets", "hits", "brute ns/bullet", "grid ns/bullet");
+    for (size_t numBullets = 256; numBullets <= 16384; numBullets *= 4) {
+        std::vector<data::Location> bullets = makeBullets(numBullets);
+        size_t rounds = std::max<size_t>(MAX_TESTS / (numBullets * aliens.size()), 1);
+        size_t bruteHits = 0;
+        size_t gridHits = 0;
+        double brute = measure(rounds, numBullets, bruteHits, [&] { return hitsBruteForce(aliens, bullets); });
+        double fast = measure(rounds * 64, numBullets, gridHits, [&] { return hitsGrid(grid, aliens, bullets); });
+        if (bruteHits != gridHits) {
+            fprintf(stderr, "Grid found %zu hits, brute force %zu.\n", gridHits, bruteHits);
+            return -1;
+        }
+        printf("%8zu %8zu %16.1f %16.1f\n", numBullets, gridHits, brute, fast);
+    }
+
+    // Marching every alien a pixel to the side, most stay in their cells
+    const size_t MARCH_STEPS = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t si = 0; si < MARCH_STEPS; ++si) {
+        for (size_t ai = 0; ai < aliens.size(); ++ai) {
+            Alien& alien = aliens[ai];
+            alien.x += si < MARCH_STEPS / 2 ? 1 : -1;
+            grid.insert(ai, alien.x, alien.y, alien.sprite->width, alien.sprite->height);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / (MARCH_STEPS * aliens.size());
+    printf("\nMoving an alien a pixel: %.1f ns\n", ns);
+
+    // Killing every other alien, then checking against brute force again
+    for (size_t ai = 0; ai < aliens.size(); ai += 2) {
+        grid.remove(ai);
+    }
+    std::vector<Alien> alive;
+    for (size_t ai = 1; ai < aliens.size(); ai += 2) {
+        alive.push_back(aliens[ai]);
+    }
+    std::vector<data::Location> bullets = makeBullets(16384);
+    size_t bruteHits = hitsBruteForce(alive, bullets);
+    size_t gridHits = hitsGrid(grid, aliens, bullets);
+    if (bruteHits != gridHits || grid.size() != alive.size()) {
+        fprintf(stderr, "Grid found %zu hits after removals, brute force %zu.\n", gridHits, bruteHits);
+        return -1;
+    }
+    printf("After removing half the aliens: %zu hits, grid matches\n", gridHits);
+
+    printf("\nNarrow phase against a pixel by pixel check\n");
+    if (!checkMasks("Sprites up to 64 wide", 64, 16) || !checkMasks("Masks up to 256 wide", 256, 32)) {
+        return -1;
+    }
+
+    printf("\nShield hits and erosion against a pixel by pixel check\n");
+    if (!checkShields()) {
+        return -1;
+    }
+    return 0;
+}
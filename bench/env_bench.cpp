@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdio>
+#include "sim/env.hpp"
+
+namespace {
+
+const size_t STEPS = 200000;
+
+/**
+ * @brief Plays an Env with a fixed cycle of actions and reports steps per second.
+ *
+ * @return size_t Sum of the rewards, to compare runs.
+ */
+size_t measure(const char* name, const sim::EnvConfig& config)
+{
+    sim::Env env(config);
+    size_t episodes = 0;
+    size_t total = 0;
+    uint32_t check = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t si = 0; si < STEPS; ++si) {
+        // Sweep left and right, firing every few steps
+        uint8_t action = (si / 60) % 2 ? sim::ACTION_LEFT : sim::ACTION_RIGHT;
+        if (si % 7 == 0) {
+            action = action == sim::ACTION_LEFT ? sim::ACTION_LEFT_FIRE : sim::ACTION_RIGHT_FIRE;
+        }
+        sim::StepResult result = env.step(action);
+        total += static_cast<size_t>(result.reward);
+        // Touch the observation like an agent would
+        if (result.observation.pixels) {
+            check += result.observation.pixels[si % (result.observation.stride * result.observation.height)];
+        }
+        if (result.done) {
+            env.reset(++episodes);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%-26s %12.0f steps/s %8zu points %6zu episodes (%08x)\n",
+           name, STEPS / seconds, total, episodes, check);
+    return total;
+}
+
+} // namespace
+
+int main()
+{
+    sim::EnvConfig config;
+    config.maxSteps = 4000;
+
+    config.observation = sim::OBSERVATION_NONE;
+    size_t reference = measure("features only", config);
+
+    config.observation = sim::OBSERVATION_FRAME;
+    config.format = data::FORMAT_RGBA32;
+    size_t rgba = measure("frame, rgba32", config);
+    config.format = data::FORMAT_INDEXED8;
+    size_t indexed = measure("frame, indexed8", config);
+    config.format = data::FORMAT_MONO1;
+    size_t mono = measure("frame, mono1", config);
+
+    config.observation = sim::OBSERVATION_PACKED;
+    config.downsample = 2;
+    size_t packed = measure("packed, 2x2 blocks", config);
+    config.downsample = 4;
+    size_t packed4 = measure("packed, 4x4 blocks", config);
+
+    // Observations must not change how the game plays
+    if (rgba != reference || indexed != reference || mono != reference
+        || packed != reference || packed4 != reference) {
+        fprintf(stderr, "Observation modes played differently.\n");
+        return -1;
+    }
+    return 0;
+}
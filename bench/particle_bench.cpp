@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "data/data.hpp"
+#include "render/particles.hpp"
+#include "sim/batch.hpp"
+#include "sim/game.hpp"
+
+namespace {
+
+const size_t WIDTH = 224;
+const size_t HEIGHT = 256;
+const size_t CAPACITY = 65536;
+const size_t CHECK_PARTICLES = 1003;
+const size_t CHECK_STEPS = 40;
+const size_t STRESS_STEPS = 2000;
+const size_t GAME_STEPS = 6000;
+
+/**
+ * @brief Small linear congruential generator, so every run is the same.
+ */
+uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/**
+ * @brief Moves particles that never die or leave the screen and checks
+ *        the pixels drawn against a plain scalar model of the motion.
+ * @details The number of particles is not a multiple of 8, so both the
+ *          vector and the scalar path are covered.
+ */
+bool checkMotion()
+{
+    struct Model {
+        int32_t x, y, vx, vy;
+    };
+    render::ParticleSystem particles(WIDTH, HEIGHT, CAPACITY);
+    std::vector<Model> model;
+    uint32_t state = 7;
+    for (size_t pi = 0; pi < CHECK_PARTICLES; ++pi) {
+        Model m;
+        m.x = static_cast<int32_t>((64 + nextRandom(state) % 96) << render::PARTICLE_FRACTION_BITS);
+        m.y = static_cast<int32_t>((96 + nextRandom(state) % 96) << render::PARTICLE_FRACTION_BITS);
+        m.vx = static_cast<int32_t>(nextRandom(state) % 129) - 64;
+        m.vy = static_cast<int32_t>(nextRandom(state) % 129) - 64;
+        particles.spawn(m.x, m.y, m.vx, m.vy, 1000);
+        model.push_back(m);
+    }
+
+    data::Buffer drawn(WIDTH, HEIGHT);
+    data::Buffer expected(WIDTH, HEIGHT);
+    for (size_t si = 0; si < CHECK_STEPS; ++si) {
+        particles.update();
+        for (Model& m : model) {
+            m.vy -= 6;
+            m.x += m.vx;
+            m.y += m.vy;
+        }
+    }
+    drawn.clear(0);
+    expected.clear(0);
+    particles.draw(drawn, 0xFFFFFFFF);
+    for (const Model& m : model) {
+        expected.fillRect(
+            static_cast<size_t>(m.x >> render::PARTICLE_FRACTION_BITS),
+            static_cast<size_t>(m.y >> render::PARTICLE_FRACTION_BITS),
+            1, 1, 0xFFFFFFFF
+        );
+    }
+    if (particles.size() != CHECK_PARTICLES || drawn.getVector() != expected.getVector()) {
+        fprintf(stderr, "%zu particles moved differently from the model\n", CHECK_PARTICLES);
+        return false;
+    }
+
+    // Short lived ones and ones thrown off the screen are dropped
+    particles.clear();
+    particles.spawn(50 << render::PARTICLE_FRACTION_BITS, 50 << render::PARTICLE_FRACTION_BITS, 0, 0, 3);
+    particles.spawn(100 << render::PARTICLE_FRACTION_BITS, 100 << render::PARTICLE_FRACTION_BITS, -100000, 0, 1000);
+    particles.update();
+    if (particles.size() != 1) {
+        fprintf(stderr, "A particle off the screen was kept\n");
+        return false;
+    }
+    particles.update();
+    particles.update();
+    if (particles.size() != 0) {
+        fprintf(stderr, "A burnt out particle was kept\n");
+        return false;
+    }
+    printf("%zu particles over %zu steps match the scalar model\n", CHECK_PARTICLES, CHECK_STEPS);
+    return true;
+}
+
+/**
+ * @brief Keeps a number of particles alive with explosions all over the
+ *        screen and times moving and drawing them.
+ */
+void stress(size_t target)
+{
+    render::ParticleSystem particles(WIDTH, HEIGHT, CAPACITY);
+    data::Buffer buffer(WIDTH, HEIGHT);
+    uint32_t state = 11;
+    double updateSeconds = 0.0;
+    double drawSeconds = 0.0;
+    size_t particleSteps = 0;
+    for (size_t si = 0; si < STRESS_STEPS; ++si) {
+        while (particles.size() < target) {
+            data::Impact impact{};
+            impact.x = static_cast<int16_t>(16 + nextRandom(state) % (WIDTH - 32));
+            impact.y = static_cast<int16_t>(32 + nextRandom(state) % (HEIGHT - 64));
+            impact.kind = data::IMPACT_PLAYER;
+            particles.scatter(impact);
+        }
+        buffer.clear(0);
+
+        auto start = std::chrono::steady_clock::now();
+        particles.update();
+        auto updated = std::chrono::steady_clock::now();
+        particles.draw(buffer, 0xFF0000FF);
+        auto drawn = std::chrono::steady_clock::now();
+
+        updateSeconds += std::chrono::duration<double>(updated - start).count();
+        drawSeconds += std::chrono::duration<double>(drawn - updated).count();
+        particleSteps += particles.size();
+    }
+    printf("%6zu particles: update %6.1f us, draw %6.1f us, %.2f ns per particle and step\n",
+           target, updateSeconds / STRESS_STEPS * 1e6, drawSeconds / STRESS_STEPS * 1e6,
+           (updateSeconds + drawSeconds) / particleSteps * 1e9);
+}
+
+/**
+ * @brief Plays a game on autopilot and times the debris of its hits.
+ * @details Only the debris is drawn, so the damage collected each step is
+ *          what the debris alone would upload.
+ */
+void play()
+{
+    data::Game game;
+    sim::newGame(game, WIDTH, HEIGHT);
+    sim::CollisionGrid grid;
+    sim::buildAlienGrid(grid, game);
+    render::ParticleSystem particles(WIDTH, HEIGHT, CAPACITY);
+    data::Buffer buffer(WIDTH, HEIGHT, data::FORMAT_INDEXED8);
+
+    double seconds = 0.0;
+    size_t particleSteps = 0;
+    size_t peak = 0;
+    size_t damaged = 0;
+    buffer.clear(0);
+    buffer.collectDamage();
+    for (size_t si = 0; si < GAME_STEPS; ++si) {
+        sim::step(game, sim::autopilotInput(0, game), grid);
+        if (!game.aliens.numAlive || !game.player.life) {
+            sim::newGame(game, WIDTH, HEIGHT);
+            sim::buildAlienGrid(grid, game);
+        }
+        buffer.clearDamaged(0);
+
+        auto start = std::chrono::steady_clock::now();
+        particles.follow(game);
+        particles.draw(buffer, 0xFF0000FF);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (const data::Region& region : buffer.collectDamage()) {
+            damaged += region.width * region.height;
+        }
+        particleSteps += particles.size();
+        peak = std::max(peak, particles.size());
+    }
+    printf("Game of %zu steps, %llu impacts: %.0f particles on average, %zu at most, %.2f us per step, "
+           "%.1f%% of the screen damaged on average\n",
+           GAME_STEPS, static_cast<unsigned long long>(game.impacts.count),
+           static_cast<double>(particleSteps) / GAME_STEPS, peak, seconds / GAME_STEPS * 1e6,
+           100.0 * damaged / (GAME_STEPS * WIDTH * HEIGHT));
+}
+
+} // namespace
+
+int main()
+{
+    if (!checkMotion()) {
+        return 1;
+    }
+    for (size_t target : {1000, 10000, 30000, 60000}) {
+        stress(target);
+    }
+    play();
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "sim/batch.hpp"
+#include "sim/game.hpp"
+#include "sim/rewind.hpp"
+
+namespace {
+
+const size_t STEPS = 20000;
+const size_t MAX_SNAPSHOTS = 600;
+const size_t MAX_BYTES = 256 * 1024;
+
+bool sameGame(const data::Game& a, const data::Game& b)
+{
+    return memcmp(&a, &b, sizeof(data::Game)) == 0;
+}
+
+} // namespace
+
+int main()
+{
+    // Every state is kept in full as well, to check the restored ones
+    data::Game game;
+    sim::newGame(game, 224, 256);
+    sim::CollisionGrid grid;
+    sim::buildAlienGrid(grid, game);
+    std::vector<data::Game> history;
+    history.reserve(STEPS);
+
+    sim::RewindBuffer rewind(MAX_SNAPSHOTS, MAX_BYTES);
+    double pushSeconds = 0.0;
+    double maxPush = 0.0;
+    for (size_t si = 0; si < STEPS; ++si) {
+        sim::step(game, sim::autopilotInput(0, game), grid);
+        // Start over once the aliens are gone, so the states keep changing
+        if (game.aliens.numAlive == 0) {
+            sim::newGame(game, 224, 256);
+            sim::buildAlienGrid(grid, game);
+        }
+        history.push_back(game);
+
+        auto start = std::chrono::steady_clock::now();
+        rewind.push(game);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pushSeconds += seconds;
+        maxPush = std::max(maxPush, seconds);
+    }
+
+    sim::RewindStats stats = rewind.getStats();
+    printf("Snapshot: %.0f ns average, %.1f us max, %zu bytes per raw state\n",
+           pushSeconds / STEPS * 1e9, maxPush * 1e6, sizeof(data::Game));
+    printf("Held %zu states in %.1f KiB, %.0f bytes per state, %.1f KiB reserved, %.1f KiB in all\n",
+           stats.snapshots, stats.payloadBytes / 1024.0,
+           static_cast<double>(stats.payloadBytes) / stats.snapshots,
+           stats.capacityBytes / 1024.0, stats.totalBytes / 1024.0);
+
+    size_t mismatches = 0;
+    for (size_t back : {0, 1, 10, 59, 60, 100, 300, 500, 599}) {
+        if (back >= rewind.size()) {
+            fprintf(stderr, "Only %zu states held, cannot restore %zu steps back\n", rewind.size(), back);
+            ++mismatches;
+            continue;
+        }
+        const size_t repeats = 1000;
+        data::Game restored;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t ri = 0; ri < repeats; ++ri) {
+            rewind.restore(back, restored);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bool same = sameGame(restored, history[STEPS - 1 - back]);
+        mismatches += !same;
+        printf("Restore %3zu steps back: %6.2f us %s\n", back, seconds / repeats * 1e6, same ? "" : "MISMATCH");
+    }
+
+    // Popping everything walks back through every state held
+    size_t popped = 0;
+    data::Game restored;
+    while (rewind.pop(restored)) {
+        ++popped;
+        mismatches += !sameGame(restored, history[STEPS - 1 - popped]);
+    }
+    printf("Popped %zu states\n", popped);
+
+    if (mismatches) {
+        fprintf(stderr, "%zu restored states differ from the recorded ones\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
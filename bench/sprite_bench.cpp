@@ -0,0 +1,232 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "data/data.hpp"
+#include "data/draw_list.hpp"
+#include "sprites/aliens.hpp"
+#include "sprites/player.hpp"
+#include "util/thread_pool.hpp"
+
+namespace {
+
+const size_t BUFFER_WIDTH = 224;
+const size_t BUFFER_HEIGHT = 256;
+const size_t FRAMES = 20000;
+const size_t NUM_BULLETS = 64;
+const uint32_t COLOR = 0x800000FF;
+
+const size_t LARGE_WIDTH = 1920;
+const size_t LARGE_HEIGHT = 1080;
+const size_t LARGE_FRAMES = 200;
+const size_t LARGE_SPRITES = 20000;
+
+/**
+ * @brief Sprite positions of one frame, laid out like the game's start screen.
+ */
+struct Scene {
+    data::Location aliens[55];
+    size_t alienFrame[55];
+    data::Location bullets[NUM_BULLETS];
+    data::Location player;
+};
+
+Scene makeScene()
+{
+    Scene scene;
+    for (size_t yi = 0; yi < 5; ++yi) {
+        for (size_t xi = 0; xi < 11; ++xi) {
+            size_t ai = yi * 11 + xi;
+            size_t type = (5 - yi) / 2 + 1;
+            scene.alienFrame[ai] = 2 * (type - 1) + (xi & 1);
+            scene.aliens[ai] = {16 * xi + 20, 17 * yi + 128};
+        }
+    }
+    for (size_t bi = 0; bi < NUM_BULLETS; ++bi) {
+        // Some bullets sit on the top edge to exercise clipping
+        scene.bullets[bi] = {(bi * 37) % BUFFER_WIDTH, (bi * 53) % BUFFER_HEIGHT};
+    }
+    scene.player = {112 - 5, 32};
+    return scene;
+}
+
+void drawNothing([[maybe_unused]] data::Buffer& buffer, [[maybe_unused]] const Scene& scene)
+{
+}
+
+void drawGeneric(data::Buffer& buffer, const Scene& scene)
+{
+    for (size_t ai = 0; ai < 55; ++ai) {
+        buffer.drawSprite(sprites::ALIEN_SPRITES[scene.alienFrame[ai]],
+                          scene.aliens[ai].x, scene.aliens[ai].y, COLOR);
+    }
+    for (size_t bi = 0; bi < NUM_BULLETS; ++bi) {
+        buffer.drawSprite(sprites::BULLET_SPRITE, scene.bullets[bi].x, scene.bullets[bi].y, COLOR);
+    }
+    buffer.drawSprite(sprites::PLAYER_SPRITE, scene.player.x, scene.player.y, COLOR);
+}
+
+void drawPacked(data::Buffer& buffer, const Scene& scene)
+{
+    for (size_t ai = 0; ai < 55; ++ai) {
+        buffer.drawSprite(sprites::ALIEN_SPRITES_PACKED[scene.alienFrame[ai]],
+                          scene.aliens[ai].x, scene.aliens[ai].y, COLOR);
+    }
+    for (size_t bi = 0; bi < NUM_BULLETS; ++bi) {
+        buffer.drawSprite(sprites::BULLET_SPRITE_PACKED, scene.bullets[bi].x, scene.bullets[bi].y, COLOR);
+    }
+    buffer.drawSprite(sprites::PLAYER_SPRITE_PACKED, scene.player.x, scene.player.y, COLOR);
+}
+
+void drawSpecialized(data::Buffer& buffer, const Scene& scene)
+{
+    for (size_t ai = 0; ai < 55; ++ai) {
+        sprites::drawAlienSprite(buffer, scene.alienFrame[ai], scene.aliens[ai].x, scene.aliens[ai].y, COLOR);
+    }
+    for (size_t bi = 0; bi < NUM_BULLETS; ++bi) {
+        data::drawStatic<sprites::BulletSprite>(buffer, scene.bullets[bi].x, scene.bullets[bi].y, COLOR);
+    }
+    data::drawStatic<sprites::PlayerSprite, data::InBounds>(buffer, scene.player.x, scene.player.y, COLOR);
+}
+
+/**
+ * @brief Times a draw routine over FRAMES frames.
+ *
+ * @param name Name printed next to the result.
+ * @param draw Routine drawing one frame.
+ * @param buffer Buffer drawn into, holds the last frame afterwards.
+ * @param scene Scene to draw.
+ */
+void run(const char* name, void (*draw)(data::Buffer&, const Scene&),
+         data::Buffer& buffer, const Scene& scene)
+{
+    // Warm up caches and the span cache of the generic path
+    buffer.clear(0);
+    draw(buffer, scene);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < FRAMES; ++frame) {
+        buffer.clear(0);
+        draw(buffer, scene);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / FRAMES;
+    printf("%-12s %10.1f ns/frame\n", name, ns);
+}
+
+/**
+ * @brief Sprite positions of one frame of a large, crowded scene.
+ */
+struct LargeScene {
+    std::vector<data::Location> positions;
+    std::vector<size_t> frames;
+};
+
+LargeScene makeLargeScene()
+{
+    LargeScene scene;
+    uint32_t state = 12345;
+    for (size_t i = 0; i < LARGE_SPRITES; ++i) {
+        // Small LCG, positions overlap band and buffer edges on purpose
+        state = state * 1664525 + 1013904223;
+        size_t x = (state >> 8) % (LARGE_WIDTH + 16) - 8;
+        state = state * 1664525 + 1013904223;
+        size_t y = (state >> 8) % (LARGE_HEIGHT + 16) - 8;
+        scene.positions.push_back({x, y});
+        scene.frames.push_back(i % 6);
+    }
+    return scene;
+}
+
+void recordLarge(data::DrawList& list, const LargeScene& scene)
+{
+    list.reset();
+    for (size_t i = 0; i < scene.positions.size(); ++i) {
+        sprites::drawAlienSprite(list, scene.frames[i], scene.positions[i].x, scene.positions[i].y, COLOR + i);
+    }
+}
+
+/**
+ * @brief Times recording and rasterizing the large scene over LARGE_FRAMES frames.
+ *
+ * @param name Name printed next to the result.
+ * @param buffer Buffer drawn into, holds the last frame afterwards.
+ * @param scene Scene to draw.
+ * @param pool Pool to rasterize on, nullptr for the calling thread.
+ */
+void runLarge(const char* name, data::Buffer& buffer, const LargeScene& scene, util::ThreadPool* pool)
+{
+    data::DrawList list(buffer);
+    buffer.clear(0);
+    recordLarge(list, scene);
+    list.execute(pool);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < LARGE_FRAMES; ++frame) {
+        buffer.clear(0);
+        recordLarge(list, scene);
+        list.execute(pool);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double us = std::chrono::duration<double, std::micro>(end - start).count() / LARGE_FRAMES;
+    printf("%-12s %10.1f us/frame\n", name, us);
+}
+
+void drawLargeImmediate(data::Buffer& buffer, const LargeScene& scene)
+{
+    buffer.clear(0);
+    for (size_t i = 0; i < scene.positions.size(); ++i) {
+        sprites::drawAlienSprite(buffer, scene.frames[i], scene.positions[i].x, scene.positions[i].y, COLOR + i);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const Scene scene = makeScene();
+    data::Buffer generic(BUFFER_WIDTH, BUFFER_HEIGHT);
+    data::Buffer packed(BUFFER_WIDTH, BUFFER_HEIGHT);
+    data::Buffer specialized(BUFFER_WIDTH, BUFFER_HEIGHT);
+
+    printf("Sprite blitter: %s\n", data::blit::isaName());
+    printf("%zu frames of 55 aliens, %zu bullets and the player\n", FRAMES, NUM_BULLETS);
+
+    // Every frame clears the buffer, the first row is the cost of that alone
+    run("clear only", drawNothing, generic, scene);
+    run("generic", drawGeneric, generic, scene);
+    run("packed", drawPacked, packed, scene);
+    run("specialized", drawSpecialized, specialized, scene);
+
+    const size_t bytes = BUFFER_WIDTH * BUFFER_HEIGHT * sizeof(uint32_t);
+    if (memcmp(generic.getData(), packed.getData(), bytes) != 0
+        || memcmp(generic.getData(), specialized.getData(), bytes) != 0) {
+        fprintf(stderr, "Draw paths produced different frames.\n");
+        return 1;
+    }
+
+    // Every sprite has its own color, so any change in draw order between
+    // overlapping sprites shows up in the comparison
+    const LargeScene large = makeLargeScene();
+    data::Buffer immediate(LARGE_WIDTH, LARGE_HEIGHT);
+    data::Buffer serial(LARGE_WIDTH, LARGE_HEIGHT);
+    data::Buffer parallel(LARGE_WIDTH, LARGE_HEIGHT);
+    util::ThreadPool pool;
+
+    printf("\n%zu frames of %zu sprites at %zux%zu, %zu threads\n",
+           LARGE_FRAMES, LARGE_SPRITES, LARGE_WIDTH, LARGE_HEIGHT, pool.size());
+    drawLargeImmediate(immediate, large);
+    runLarge("serial", serial, large, nullptr);
+    runLarge("parallel", parallel, large, &pool);
+
+    const size_t largeBytes = LARGE_WIDTH * LARGE_HEIGHT * sizeof(uint32_t);
+    if (memcmp(immediate.getData(), serial.getData(), largeBytes) != 0
+        || memcmp(immediate.getData(), parallel.getData(), largeBytes) != 0) {
+        fprintf(stderr, "Draw list produced a different frame.\n");
+        return 1;
+    }
+
+    return 0;
+}
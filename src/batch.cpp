@@ -0,0 +1,106 @@
+#include "sim/batch.hpp"
+#include "render/game_view.hpp"
+#include "sim/game.hpp"
+#include "util/utility.hpp"
+
+namespace sim {
+
+data::Input autopilotInput(size_t index, const data::Game& game)
+{
+    // Turn around every 40 to 136 steps and fire every 6 to 17
+    const size_t period = 40 + (index * 37) % 97;
+    const size_t fireEvery = 6 + (index * 5) % 12;
+    data::Input input{};
+    input.moveDir = (game.tick / period) % 2 ? -1 : 1;
+    input.fire = game.tick % fireEvery == 0;
+    return input;
+}
+
+Batch::Batch(
+    size_t numGames, size_t width, size_t height,
+    bool render, data::PixelFormat format
+)
+    : input(autopilotInput), instances(numGames),
+      clearColor(util::rgbToUint32(0, 128, 0)), color(util::rgbToUint32(128, 0, 0))
+{
+    for (Instance& instance : instances) {
+        newGame(instance.game, width, height);
+        buildAlienGrid(instance.grid, instance.game);
+        if (render) {
+            instance.buffer = std::make_unique<data::Buffer>(width, height, format);
+            instance.buffer->setPalette({clearColor, color});
+            instance.buffer->clear(clearColor);
+        }
+    }
+}
+
+void Batch::setInputSource(InputSource source)
+{
+    input = std::move(source);
+}
+
+void Batch::reset()
+{
+    for (Instance& instance : instances) {
+        newGame(instance.game, instance.game.width, instance.game.height);
+        buildAlienGrid(instance.grid, instance.game);
+        if (instance.buffer) {
+            instance.buffer->clear(clearColor);
+        }
+    }
+    frames = 0;
+}
+
+void Batch::run(size_t steps, util::ThreadPool* pool)
+{
+    // One task per game, a game's steps stay on one thread and in its cache
+    std::function<void(size_t)> task = [this, steps](size_t index) {
+        stepInstance(index, steps);
+    };
+    if (pool) {
+        pool->parallelFor(instances.size(), task);
+    } else {
+        for (size_t i = 0; i < instances.size(); ++i) {
+            task(i);
+        }
+    }
+    frames += steps * instances.size();
+}
+
+void Batch::stepInstance(size_t index, size_t steps)
+{
+    Instance& instance = instances[index];
+    for (size_t si = 0; si < steps; ++si) {
+        step(instance.game, input(index, instance.game), instance.grid);
+        if (instance.buffer) {
+            data::Buffer& buffer = *instance.buffer;
+            buffer.clearDamaged(clearColor);
+            render::drawGame(buffer, instance.game, color);
+            // Nothing presents the damage, collecting it just keeps the
+            // buffer's lists from growing
+            buffer.collectDamage();
+        }
+    }
+}
+
+size_t Batch::size() const
+{
+    return instances.size();
+}
+
+const data::Game& Batch::getGame(size_t index) const
+{
+    return instances[index].game;
+}
+
+const data::Buffer* Batch::getBuffer(size_t index) const
+{
+    return instances[index].buffer.get();
+}
+
+size_t Batch::getFrames() const
+{
+    return frames;
+}
+
+} // sim
@@ -0,0 +1,284 @@
+#include "data/blit.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLIT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace data::blit {
+
+namespace {
+
+using PackedRowsFn = void (*)(
+    uint32_t*, ptrdiff_t, const uint16_t*, size_t,
+    unsigned, uint16_t, size_t, uint32_t
+);
+using ExpandIndexed8Fn = void (*)(const uint8_t*, size_t, const uint32_t*, uint32_t*);
+using ExpandMono1Fn = void (*)(const uint32_t*, size_t, size_t, const uint32_t*, uint32_t*);
+using CopyToArgbFn = void (*)(const uint32_t*, size_t, uint32_t*);
+
+/**
+ * @brief Reads up to 8 consecutive 1-bit pixels of a row.
+ *
+ * @param src Words of the row.
+ * @param bit Index of the first pixel to read.
+ * @param lastWord Index of the last word that may be read.
+ * @return unsigned The pixels in the low bits.
+ */
+inline unsigned monoBits(const uint32_t* src, size_t bit, size_t lastWord)
+{
+    size_t word = bit / 32;
+    uint64_t bits = src[word];
+    if (word < lastWord) {
+        bits |= static_cast<uint64_t>(src[word + 1]) << 32;
+    }
+    return static_cast<unsigned>(bits >> (bit % 32)) & 0xFF;
+}
+
+void packedRowsScalar(
+    uint32_t* dst, ptrdiff_t dstStride,
+    const uint16_t* rows, size_t numRows,
+    unsigned shift, uint16_t mask, [[maybe_unused]] size_t count,
+    uint32_t color
+){
+    for (size_t yi = 0; yi < numRows; ++yi, dst += dstStride) {
+        unsigned bits = (rows[yi] >> shift) & mask;
+        while (bits) {
+            dst[__builtin_ctz(bits)] = color;
+            bits &= bits - 1;
+        }
+    }
+}
+
+void expandIndexed8Scalar(
+    const uint8_t* src, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = palette[src[i]];
+    }
+}
+
+void expandMono1Scalar(
+    const uint32_t* src, size_t firstBit, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    for (size_t i = 0; i < count; ++i) {
+        size_t bit = firstBit + i;
+        dst[i] = palette[(src[bit / 32] >> (bit % 32)) & 1];
+    }
+}
+
+void copyToArgbScalar(const uint32_t* src, size_t count, uint32_t* dst)
+{
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = (src[i] >> 8) | (src[i] << 24);
+    }
+}
+
+#ifdef BLIT_X86
+__attribute__((target("sse2")))
+void packedRowsSse2(
+    uint32_t* dst, ptrdiff_t dstStride,
+    const uint16_t* rows, size_t numRows,
+    unsigned shift, uint16_t mask, size_t count,
+    uint32_t color
+){
+    const __m128i lanes = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i colors = _mm_set1_epi32(static_cast<int>(color));
+    // SSE2 has no masked store, so whole groups of four blend with what is
+    // already in the buffer and the tail is written pixel by pixel
+    const size_t groups = count / 4;
+
+    for (size_t yi = 0; yi < numRows; ++yi, dst += dstStride) {
+        unsigned bits = (rows[yi] >> shift) & mask;
+        size_t group = 0;
+        for (; group < groups && bits; ++group, bits >>= 4) {
+            if (!(bits & 0xF)) {
+                continue;
+            }
+            __m128i select = _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes);
+            __m128i lit = _mm_cmpeq_epi32(select, lanes);
+            __m128i* out = reinterpret_cast<__m128i*>(dst + group * 4);
+            __m128i pixels = _mm_loadu_si128(out);
+            pixels = _mm_or_si128(_mm_and_si128(lit, colors), _mm_andnot_si128(lit, pixels));
+            _mm_storeu_si128(out, pixels);
+        }
+        uint32_t* tail = dst + group * 4;
+        while (bits) {
+            tail[__builtin_ctz(bits)] = color;
+            bits &= bits - 1;
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+void expandMono1Sse2(
+    const uint32_t* src, size_t firstBit, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    const __m128i lanes = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i clear = _mm_set1_epi32(static_cast<int>(palette[0]));
+    const __m128i set = _mm_set1_epi32(static_cast<int>(palette[1]));
+    const size_t lastWord = count ? (firstBit + count - 1) / 32 : 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        unsigned bits = monoBits(src, firstBit + i, lastWord);
+        for (size_t half = 0; half < 2; ++half, bits >>= 4) {
+            __m128i select = _mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes);
+            __m128i lit = _mm_cmpeq_epi32(select, lanes);
+            __m128i pixels = _mm_or_si128(_mm_and_si128(lit, set), _mm_andnot_si128(lit, clear));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4 * half), pixels);
+        }
+    }
+    expandMono1Scalar(src, firstBit + i, count - i, palette, dst + i);
+}
+
+__attribute__((target("sse2")))
+void copyToArgbSse2(const uint32_t* src, size_t count, uint32_t* dst)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        pixels = _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pixels);
+    }
+    copyToArgbScalar(src + i, count - i, dst + i);
+}
+
+__attribute__((target("avx2")))
+void packedRowsAvx2(
+    uint32_t* dst, ptrdiff_t dstStride,
+    const uint16_t* rows, size_t numRows,
+    unsigned shift, uint16_t mask, [[maybe_unused]] size_t count,
+    uint32_t color
+){
+    const __m256i lanes = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+    const __m256i colors = _mm256_set1_epi32(static_cast<int>(color));
+
+    for (size_t yi = 0; yi < numRows; ++yi, dst += dstStride) {
+        unsigned bits = (rows[yi] >> shift) & mask;
+        // Masked stores never touch unset lanes, so a row is at most two
+        // stores and needs no tail handling
+        for (uint32_t* out = dst; bits; bits >>= 8, out += 8) {
+            if (!(bits & 0xFF)) {
+                continue;
+            }
+            __m256i select = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes);
+            __m256i lit = _mm256_cmpeq_epi32(select, lanes);
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(out), lit, colors);
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void expandIndexed8Avx2(
+    const uint8_t* src, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        __m256i indices = _mm256_cvtepu8_epi32(bytes);
+        __m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), indices, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), pixels);
+    }
+    expandIndexed8Scalar(src + i, count - i, palette, dst + i);
+}
+
+__attribute__((target("avx2")))
+void expandMono1Avx2(
+    const uint32_t* src, size_t firstBit, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    const __m256i lanes = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+    const __m256i clear = _mm256_set1_epi32(static_cast<int>(palette[0]));
+    const __m256i set = _mm256_set1_epi32(static_cast<int>(palette[1]));
+    const size_t lastWord = count ? (firstBit + count - 1) / 32 : 0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        unsigned bits = monoBits(src, firstBit + i, lastWord);
+        __m256i select = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes);
+        __m256i lit = _mm256_cmpeq_epi32(select, lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blendv_epi8(clear, set, lit));
+    }
+    expandMono1Scalar(src, firstBit + i, count - i, palette, dst + i);
+}
+
+__attribute__((target("avx2")))
+void copyToArgbAvx2(const uint32_t* src, size_t count, uint32_t* dst)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        pixels = _mm256_or_si256(_mm256_srli_epi32(pixels, 8), _mm256_slli_epi32(pixels, 24));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), pixels);
+    }
+    copyToArgbScalar(src + i, count - i, dst + i);
+}
+#endif
+
+struct Dispatch {
+    PackedRowsFn packedRows;
+    ExpandIndexed8Fn expandIndexed8;
+    ExpandMono1Fn expandMono1;
+    CopyToArgbFn copyToArgb;
+    const char* name;
+};
+
+const Dispatch& dispatch()
+{
+    static const Dispatch selected = [] {
+#ifdef BLIT_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Dispatch{packedRowsAvx2, expandIndexed8Avx2, expandMono1Avx2, copyToArgbAvx2, "AVX2"};
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            // SSE2 has no gather, indexed expansion stays scalar
+            return Dispatch{packedRowsSse2, expandIndexed8Scalar, expandMono1Sse2, copyToArgbSse2, "SSE2"};
+        }
+#endif
+        return Dispatch{packedRowsScalar, expandIndexed8Scalar, expandMono1Scalar, copyToArgbScalar, "scalar"};
+    }();
+    return selected;
+}
+
+} // namespace
+
+void packedRows(
+    uint32_t* dst, ptrdiff_t dstStride,
+    const uint16_t* rows, size_t numRows,
+    unsigned shift, uint16_t mask, size_t count,
+    uint32_t color
+){
+    dispatch().packedRows(dst, dstStride, rows, numRows, shift, mask, count, color);
+}
+
+void expandIndexed8(
+    const uint8_t* src, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    dispatch().expandIndexed8(src, count, palette, dst);
+}
+
+void expandMono1(
+    const uint32_t* src, size_t firstBit, size_t count,
+    const uint32_t* palette, uint32_t* dst
+){
+    dispatch().expandMono1(src, firstBit, count, palette, dst);
+}
+
+void copyToArgb(const uint32_t* src, size_t count, uint32_t* dst)
+{
+    dispatch().copyToArgb(src, count, dst);
+}
+
+const char* isaName()
+{
+    return dispatch().name;
+}
+
+} // data::blit
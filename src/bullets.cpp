@@ -0,0 +1,85 @@
+#include "sim/bullets.hpp"
+
+namespace sim {
+
+data::BulletHandle spawnBullet(data::BulletStore& bullets, int16_t x, int16_t y, int8_t dir, data::BulletOwner owner)
+{
+    if (bullets.count >= GAME_MAX_BULLETS) {
+        return data::NO_BULLET;
+    }
+
+    size_t slot;
+    if (bullets.numFree) {
+        slot = bullets.freeSlot;
+        bullets.freeSlot = bullets.index[slot];
+        --bullets.numFree;
+    } else {
+        slot = bullets.numSlots++;
+    }
+    // Generation 0 is left out so no handle is NO_BULLET
+    uint16_t generation = static_cast<uint16_t>(bullets.generation[slot] + 1);
+    bullets.generation[slot] = generation ? generation : 1;
+
+    size_t bi = bullets.count++;
+    bullets.x[bi] = x;
+    bullets.y[bi] = y;
+    bullets.dir[bi] = dir;
+    bullets.owner[bi] = owner;
+    bullets.slot[bi] = static_cast<uint16_t>(slot);
+    bullets.index[slot] = static_cast<uint16_t>(bi);
+    bullets.numAlien += owner == data::BULLET_ALIEN;
+    return bulletHandle(bullets, bi);
+}
+
+void removeBullet(data::BulletStore& bullets, size_t bi)
+{
+    const size_t slot = bullets.slot[bi];
+    bullets.numAlien -= bullets.owner[bi] == data::BULLET_ALIEN;
+
+    size_t last = --bullets.count;
+    bullets.x[bi] = bullets.x[last];
+    bullets.y[bi] = bullets.y[last];
+    bullets.dir[bi] = bullets.dir[last];
+    bullets.owner[bi] = bullets.owner[last];
+    bullets.slot[bi] = bullets.slot[last];
+    bullets.index[bullets.slot[bi]] = static_cast<uint16_t>(bi);
+
+    bullets.index[slot] = static_cast<uint16_t>(bullets.freeSlot);
+    bullets.freeSlot = slot;
+    ++bullets.numFree;
+}
+
+data::BulletHandle bulletHandle(const data::BulletStore& bullets, size_t bi)
+{
+    const size_t slot = bullets.slot[bi];
+    return static_cast<data::BulletHandle>(bullets.generation[slot]) << 16 | slot;
+}
+
+size_t findBullet(const data::BulletStore& bullets, data::BulletHandle handle)
+{
+    const size_t slot = handle & 0xFFFF;
+    if (handle == data::NO_BULLET || slot >= bullets.numSlots || bullets.generation[slot] != handle >> 16) {
+        return bullets.count;
+    }
+    // A free slot keeps its generation, its index must point back to it
+    const size_t bi = bullets.index[slot];
+    return bi < bullets.count && bullets.slot[bi] == slot ? bi : bullets.count;
+}
+
+void moveBullets(data::BulletStore& bullets, ptrdiff_t bottom, ptrdiff_t top)
+{
+    for (size_t bi = 0; bi < bullets.count; ++bi) {
+        bullets.y[bi] = static_cast<int16_t>(bullets.y[bi] + bullets.dir[bi]);
+    }
+
+    for (size_t bi = 0; bi < bullets.count;) {
+        if (bullets.y[bi] < bottom || bullets.y[bi] >= top) {
+            // The last bullet takes the entry and is looked at next
+            removeBullet(bullets, bi);
+            continue;
+        }
+        ++bi;
+    }
+}
+
+} // sim
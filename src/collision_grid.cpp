@@ -0,0 +1,115 @@
+#include "sim/collision_grid.hpp"
+
+namespace sim {
+
+namespace {
+
+/**
+ * @brief Gets the cell a coordinate falls in, clamped to [0, numCells).
+ */
+size_t cellOf(ptrdiff_t position, size_t cellSize, size_t numCells)
+{
+    if (position < 0) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>(position) / cellSize, numCells - 1);
+}
+
+} // namespace
+
+CollisionGrid::CollisionGrid(size_t cellSize)
+    : cellSize(cellSize ? cellSize : 1)
+{
+}
+
+void CollisionGrid::reset(size_t width, size_t height, size_t capacity)
+{
+    cols = std::max<size_t>((width + cellSize - 1) / cellSize, 1);
+    rows = std::max<size_t>((height + cellSize - 1) / cellSize, 1);
+    cells.assign(cols * rows, {});
+    spans.assign(capacity, Span{1, 0, 0, 0});
+    stamps.assign(capacity, 0);
+    stamp = 0;
+    count = 0;
+}
+
+CollisionGrid::Span CollisionGrid::cover(size_t x, size_t y, size_t width, size_t height) const
+{
+    // Positions may have wrapped below 0, treat them as signed
+    ptrdiff_t x0 = static_cast<ptrdiff_t>(x);
+    ptrdiff_t y0 = static_cast<ptrdiff_t>(y);
+    ptrdiff_t x1 = x0 + static_cast<ptrdiff_t>(std::max<size_t>(width, 1)) - 1;
+    ptrdiff_t y1 = y0 + static_cast<ptrdiff_t>(std::max<size_t>(height, 1)) - 1;
+    return {
+        static_cast<uint16_t>(cellOf(x0, cellSize, cols)),
+        static_cast<uint16_t>(cellOf(y0, cellSize, rows)),
+        static_cast<uint16_t>(cellOf(x1, cellSize, cols)),
+        static_cast<uint16_t>(cellOf(y1, cellSize, rows))
+    };
+}
+
+void CollisionGrid::link(size_t id, const Span& span)
+{
+    for (size_t ri = span.y0; ri <= span.y1; ++ri) {
+        for (size_t ci = span.x0; ci <= span.x1; ++ci) {
+            cells[ri * cols + ci].push_back(static_cast<uint32_t>(id));
+        }
+    }
+}
+
+void CollisionGrid::unlink(size_t id, const Span& span)
+{
+    for (size_t ri = span.y0; ri <= span.y1; ++ri) {
+        for (size_t ci = span.x0; ci <= span.x1; ++ci) {
+            std::vector<uint32_t>& cell = cells[ri * cols + ci];
+            auto it = std::find(cell.begin(), cell.end(), static_cast<uint32_t>(id));
+            if (it != cell.end()) {
+                // Order within a cell does not matter
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+void CollisionGrid::insert(size_t id, size_t x, size_t y, size_t width, size_t height)
+{
+    Span span = cover(x, y, width, height);
+    Span& current = spans[id];
+    bool present = current.x0 <= current.x1;
+    if (present) {
+        if (current.x0 == span.x0 && current.y0 == span.y0
+            && current.x1 == span.x1 && current.y1 == span.y1) {
+            // Still in the same cells
+            return;
+        }
+        unlink(id, current);
+    } else {
+        ++count;
+    }
+    link(id, span);
+    current = span;
+}
+
+void CollisionGrid::remove(size_t id)
+{
+    Span& current = spans[id];
+    if (current.x0 > current.x1) {
+        return;
+    }
+    unlink(id, current);
+    current = Span{1, 0, 0, 0};
+    --count;
+}
+
+bool CollisionGrid::contains(size_t id) const
+{
+    return spans[id].x0 <= spans[id].x1;
+}
+
+size_t CollisionGrid::size() const
+{
+    return count;
+}
+
+} // sim
@@ -0,0 +1,133 @@
+#include "data/collision_mask.hpp"
+#include <algorithm>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace data {
+
+namespace {
+
+/**
+ * @brief Checks whether a row of one mask overlaps a row of a mask to its right.
+ *
+ * @param left Row of the mask on the left, followed by a clear word.
+ * @param right Row of the mask on the right.
+ * @param skip Whole words of the left row before the right mask starts.
+ * @param shift Remaining columns between the masks, below 64.
+ * @param count Number of words of the right row to compare.
+ */
+bool rowsOverlap(const uint64_t* left, const uint64_t* right, size_t skip, unsigned shift, size_t count)
+{
+    left += skip;
+    size_t k = 0;
+#if defined(__SSE2__)
+    // SSE2 is part of x86-64, so no runtime check is needed. A shift by
+    // 64 clears the lanes, which covers shift == 0 without a branch.
+    const __m128i low = _mm_cvtsi32_si128(static_cast<int>(shift));
+    const __m128i high = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+    for (; k + 2 <= count; k += 2) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + k));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + k + 1));
+        __m128i aligned = _mm_or_si128(_mm_srl_epi64(a, low), _mm_sll_epi64(next, high));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + k));
+        __m128i both = _mm_and_si128(aligned, b);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(both, _mm_setzero_si128())) != 0xFFFF) {
+            return true;
+        }
+    }
+#endif
+    for (; k < count; ++k) {
+        uint64_t aligned = left[k] >> shift;
+        if (shift) {
+            aligned |= left[k + 1] << (64 - shift);
+        }
+        if (aligned & right[k]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+CollisionMask::CollisionMask()
+    : Rectangle{0, 0}, words(0)
+{
+}
+
+CollisionMask::CollisionMask(size_t width, size_t height)
+    : Rectangle{width, height}, words((width + 63) / 64), bits(height * (words + 1), 0)
+{
+}
+
+CollisionMask::CollisionMask(const Sprite& sprite)
+    : CollisionMask(sprite.width, sprite.height)
+{
+    for (size_t yi = 0; yi < height; ++yi) {
+        // Sprites store their top row first
+        const uint8_t* row = sprite.data + (height - 1 - yi) * width;
+        for (size_t xi = 0; xi < width; ++xi) {
+            if (row[xi]) {
+                set(xi, yi, true);
+            }
+        }
+    }
+}
+
+void CollisionMask::set(size_t xi, size_t yi, bool lit)
+{
+    uint64_t& word = bits[yi * (words + 1) + xi / 64];
+    uint64_t bit = uint64_t{1} << (xi % 64);
+    word = lit ? word | bit : word & ~bit;
+}
+
+bool masksOverlap(
+    const CollisionMask& maskA, size_t xA, size_t yA,
+    const CollisionMask& maskB, size_t xB, size_t yB
+){
+    // Positions may have wrapped below 0, treat them as signed
+    const CollisionMask* left = &maskA;
+    const CollisionMask* right = &maskB;
+    ptrdiff_t leftX = static_cast<ptrdiff_t>(xA);
+    ptrdiff_t leftY = static_cast<ptrdiff_t>(yA);
+    ptrdiff_t rightX = static_cast<ptrdiff_t>(xB);
+    ptrdiff_t rightY = static_cast<ptrdiff_t>(yB);
+    if (leftX > rightX) {
+        std::swap(left, right);
+        std::swap(leftX, rightX);
+        std::swap(leftY, rightY);
+    }
+
+    size_t dx = static_cast<size_t>(rightX - leftX);
+    ptrdiff_t bottom = std::max(leftY, rightY);
+    ptrdiff_t top = std::min(leftY + static_cast<ptrdiff_t>(left->height),
+                             rightY + static_cast<ptrdiff_t>(right->height));
+    if (dx >= left->width || bottom >= top) {
+        return false;
+    }
+
+    if (left->getWords() == 1 && right->getWords() == 1) {
+        // Every sprite of the game fits a word, a row is one shift and AND
+        for (ptrdiff_t y = bottom; y < top; ++y) {
+            if ((left->getRow(y - leftY)[0] >> dx) & right->getRow(y - rightY)[0]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t skip = dx / 64;
+    unsigned shift = static_cast<unsigned>(dx % 64);
+    size_t count = std::min(right->getWords(), left->getWords() - skip);
+    for (ptrdiff_t y = bottom; y < top; ++y) {
+        if (rowsOverlap(left->getRow(y - leftY), right->getRow(y - rightY), skip, shift, count)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // data
@@ -0,0 +1,141 @@
+#include "sim/controls.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace sim {
+
+namespace {
+
+/**
+ * @brief Gets the bucket of a latency, see LatencyStats.
+ */
+size_t bucketOf(uint64_t nanos)
+{
+    if (nanos < 16) {
+        return static_cast<size_t>(nanos);
+    }
+    const size_t power = 63 - __builtin_clzll(nanos);
+    return (power - 3) * 16 + ((nanos >> (power - 4)) & 15);
+}
+
+/**
+ * @brief Gets the largest latency falling into a bucket.
+ */
+uint64_t bucketTop(size_t bucket)
+{
+    if (bucket < 16) {
+        return bucket;
+    }
+    const size_t shift = bucket / 16 - 1;
+    return ((16 + uint64_t{bucket % 16}) << shift) + (uint64_t{1} << shift) - 1;
+}
+
+} // namespace
+
+int64_t inputClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+ControlWriter::ControlWriter(ControlQueue& queue)
+    : queue(queue)
+{
+}
+
+void ControlWriter::send(Control control, bool pressed, int64_t time)
+{
+    if (!queue.push({time, control, pressed})) {
+        ++dropped;
+        return;
+    }
+    held[control] = pressed;
+}
+
+void ControlWriter::send(const data::Input& input, int64_t time)
+{
+    const bool wanted[NUM_CONTROLS] = {input.moveDir < 0, input.moveDir > 0, false, input.rewind};
+    // Releases go first, so switching direction never holds both
+    for (bool pressed : {false, true}) {
+        for (Control control : {CONTROL_LEFT, CONTROL_RIGHT, CONTROL_REWIND}) {
+            if (wanted[control] == pressed && held[control] != pressed) {
+                send(control, pressed, time);
+            }
+        }
+    }
+    if (input.fire) {
+        send(CONTROL_FIRE, true, time);
+    }
+}
+
+size_t ControlWriter::getDropped() const
+{
+    return dropped;
+}
+
+void ControlState::apply(const ControlEvent& event)
+{
+    if (event.control >= NUM_CONTROLS) {
+        return;
+    }
+    held[event.control] = event.pressed;
+    if (event.pressed) {
+        pressed[event.control] = true;
+        if (event.control == CONTROL_FIRE && fires < MAX_PENDING_FIRES) {
+            ++fires;
+        }
+    }
+}
+
+data::Input ControlState::take()
+{
+    bool active[NUM_CONTROLS];
+    for (size_t ci = 0; ci < NUM_CONTROLS; ++ci) {
+        active[ci] = held[ci] || pressed[ci];
+        pressed[ci] = false;
+    }
+
+    data::Input input{};
+    input.moveDir = active[CONTROL_RIGHT] - active[CONTROL_LEFT];
+    input.rewind = active[CONTROL_REWIND];
+    input.fire = fires != 0;
+    fires -= input.fire;
+    return input;
+}
+
+void LatencyStats::record(int64_t nanos)
+{
+    const uint64_t value = static_cast<uint64_t>(std::max<int64_t>(nanos, 0));
+    ++buckets[bucketOf(value)];
+    ++count;
+    total += value;
+    max = std::max(max, value);
+}
+
+size_t LatencyStats::getCount() const
+{
+    return count;
+}
+
+double LatencyStats::getMeanMicros() const
+{
+    return count ? total / 1e3 / count : 0.0;
+}
+
+double LatencyStats::getPercentileMicros(double p) const
+{
+    if (!count) {
+        return 0.0;
+    }
+    // Rank of the value, counted from 1
+    const size_t rank = std::clamp<size_t>(static_cast<size_t>(p * count + 0.5), 1, count);
+    size_t seen = 0;
+    size_t bucket = 0;
+    while ((seen += buckets[bucket]) < rank) {
+        ++bucket;
+    }
+    return std::min(bucketTop(bucket), max) / 1e3;
+}
+
+} // sim
@@ -0,0 +1,157 @@
+#include "data/draw_list.hpp"
+
+namespace data {
+
+DrawList::DrawList(Buffer& target, size_t bandHeight)
+    : target(target), bandHeight(bandHeight)
+{
+    bins.resize((target.getHeight() + bandHeight - 1) / bandHeight);
+    commands.reserve(256);
+}
+
+void DrawList::reset()
+{
+    commands.clear();
+    for (std::vector<uint32_t>& band : bins) {
+        band.clear();
+    }
+}
+
+size_t DrawList::size() const
+{
+    return commands.size();
+}
+
+void DrawList::fillRect(
+    size_t x, size_t y,
+    size_t areaWidth, size_t areaHeight,
+    uint32_t color
+){
+    target.markDamaged(x, y, areaWidth, areaHeight);
+
+    DrawCommand command{};
+    command.x = x;
+    command.y = y;
+    command.kind = DRAW_RECT;
+    command.value = target.mapColor(color);
+    command.size = {areaWidth, areaHeight};
+    commands.push_back(command);
+    bin(commands.size() - 1);
+}
+
+void DrawList::drawSprite(const Sprite& sprite, size_t x, size_t y, uint32_t color)
+{
+    target.markDamaged(sprite, x, y);
+
+    DrawCommand command{};
+    command.x = x;
+    command.y = y;
+    command.kind = DRAW_SPANS;
+    command.value = target.mapColor(color);
+    command.size = {sprite.width, sprite.height};
+    command.spans = &target.spansFor(sprite);
+    commands.push_back(command);
+    bin(commands.size() - 1);
+}
+
+void DrawList::drawSprite(const PackedSprite& sprite, size_t x, size_t y, uint32_t color)
+{
+    target.markDamaged(sprite, x, y);
+
+    DrawCommand command{};
+    command.x = x;
+    command.y = y;
+    command.kind = DRAW_PACKED;
+    command.value = target.mapColor(color);
+    command.size = {sprite.width, sprite.height};
+    command.rows = sprite.rows;
+    commands.push_back(command);
+    bin(commands.size() - 1);
+}
+
+void DrawList::drawStatic(
+    StaticRasterFn raster, const Sprite& sprite,
+    size_t x, size_t y, uint32_t color
+){
+    target.markDamaged(sprite, x, y);
+
+    DrawCommand command{};
+    command.x = x;
+    command.y = y;
+    command.kind = DRAW_STATIC;
+    command.value = target.mapColor(color);
+    command.size = {sprite.width, sprite.height};
+    command.spans = &target.spansFor(sprite);
+    command.raster = raster;
+    commands.push_back(command);
+    bin(commands.size() - 1);
+}
+
+void DrawList::execute(util::ThreadPool* pool)
+{
+    const size_t height = target.getHeight();
+    auto rasterizeBand = [&](size_t band) {
+        size_t rowBegin = band * bandHeight;
+        size_t rowEnd = std::min(rowBegin + bandHeight, height);
+        for (uint32_t index : bins[band]) {
+            rasterize(commands[index], rowBegin, rowEnd);
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(bins.size(), rasterizeBand);
+    } else {
+        for (size_t band = 0; band < bins.size(); ++band) {
+            rasterizeBand(band);
+        }
+    }
+}
+
+void DrawList::bin(size_t index)
+{
+    const DrawCommand& command = commands[index];
+    const ptrdiff_t height = static_cast<ptrdiff_t>(target.getHeight());
+
+    // Positions may have wrapped below zero, treat them as signed
+    ptrdiff_t firstRow = static_cast<ptrdiff_t>(command.y);
+    ptrdiff_t lastRow = firstRow + static_cast<ptrdiff_t>(command.size.height);
+    if (command.kind == DRAW_RECT && command.y >= target.getHeight()) {
+        return;
+    }
+    firstRow = std::max<ptrdiff_t>(firstRow, 0);
+    lastRow = std::min<ptrdiff_t>(lastRow, height);
+    if (firstRow >= lastRow) {
+        return;
+    }
+
+    size_t firstBand = firstRow / bandHeight;
+    size_t lastBand = (lastRow - 1) / bandHeight;
+    for (size_t band = firstBand; band <= lastBand; ++band) {
+        bins[band].push_back(static_cast<uint32_t>(index));
+    }
+}
+
+void DrawList::rasterize(const DrawCommand& command, size_t rowBegin, size_t rowEnd)
+{
+    switch (command.kind) {
+        case DRAW_SPANS:
+            target.rasterSpans(*command.spans, command.x, command.y, command.value, rowBegin, rowEnd);
+            break;
+        case DRAW_PACKED: {
+            PackedSprite sprite{command.size, command.rows};
+            target.rasterPacked(sprite, command.x, command.y, command.value, rowBegin, rowEnd);
+            break;
+        }
+        case DRAW_STATIC:
+            command.raster(target, command.x, command.y, command.value, rowBegin, rowEnd, *command.spans);
+            break;
+        case DRAW_RECT:
+            target.rasterRect(
+                command.x, command.y, command.size.width, command.size.height,
+                command.value, rowBegin, rowEnd
+            );
+            break;
+    }
+}
+
+} // data
@@ -0,0 +1,301 @@
+#include "sim/env.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include "render/game_view.hpp"
+#include "sim/game.hpp"
+#include "sprites/aliens.hpp"
+#include "sprites/player.hpp"
+#include "util/utility.hpp"
+
+namespace sim {
+
+namespace {
+
+const size_t GAME_WIDTH = 224;
+const size_t GAME_HEIGHT = 256;
+
+/**
+ * @brief Advances a seed and mixes it into a well spread 64-bit value.
+ */
+uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Reads up to 32 consecutive 1-bit pixels of a row.
+ *
+ * @param row Words of the row.
+ * @param words Number of words of the row.
+ * @param bit Index of the first pixel to read.
+ * @param count Number of pixels to read.
+ * @return uint64_t The pixels in the low bits.
+ */
+uint64_t readBits(const uint32_t* row, size_t words, size_t bit, size_t count)
+{
+    size_t word = bit / 32;
+    uint64_t bits = row[word];
+    if (word + 1 < words) {
+        bits |= static_cast<uint64_t>(row[word + 1]) << 32;
+    }
+    return (bits >> (bit % 32)) & ((uint64_t{1} << count) - 1);
+}
+
+} // namespace
+
+Env::Env(const EnvConfig& config)
+    : config(config),
+      buffer(
+          config.observation == OBSERVATION_NONE ? 1 : GAME_WIDTH,
+          config.observation == OBSERVATION_NONE ? 1 : GAME_HEIGHT,
+          config.observation == OBSERVATION_PACKED ? data::FORMAT_MONO1 : config.format
+      ),
+      clearColor(util::rgbToUint32(0, 128, 0)), color(util::rgbToUint32(128, 0, 0))
+{
+    this->config.downsample = std::clamp<size_t>(config.downsample, 1, 32);
+    this->config.frameSkip = std::max<size_t>(config.frameSkip, 1);
+    buffer.setPalette({clearColor, color});
+    if (config.observation == OBSERVATION_PACKED) {
+        size_t width = (buffer.getWidth() + this->config.downsample - 1) / this->config.downsample;
+        size_t height = (buffer.getHeight() + this->config.downsample - 1) / this->config.downsample;
+        packed.assign((width + 31) / 32 * height, 0);
+        dirtyBegin.resize(height);
+        dirtyEnd.resize(height);
+        rowOr.assign(std::max(buffer.getStride(), (width + 31) / 32 * this->config.downsample), 0);
+
+        // Mask of the bits kept before each step of compactBlocks, groups
+        // of a bit per block at first
+        size_t block = this->config.downsample;
+        size_t step = 0;
+        for (size_t group = 1; group <= 32 / block; group <<= 1, ++step) {
+            uint32_t mask = 0;
+            for (size_t bi = 0; bi < 32; bi += group * block) {
+                mask |= static_cast<uint32_t>((uint64_t{1} << group) - 1) << bi;
+            }
+            compactMasks[step] = mask;
+        }
+    }
+    reset(0);
+}
+
+StepResult Env::reset(uint64_t seed)
+{
+    uint64_t state = seed;
+    newGame(game, GAME_WIDTH, GAME_HEIGHT);
+    size_t columns = game.width - sprites::PLAYER_SPRITE.width + 1;
+    game.player.x = splitMix64(state) % columns;
+    buildAlienGrid(grid, game);
+
+    size_t idleSteps = splitMix64(state) % (config.maxNoopSteps + 1);
+    for (size_t si = 0; si < idleSteps; ++si) {
+        sim::step(game, data::Input{}, grid);
+    }
+    steps = 0;
+
+    // Everything is drawn anew
+    buffer.clear(clearColor);
+    return observe(0.0f);
+}
+
+StepResult Env::step(uint8_t action)
+{
+    data::Input input{};
+    switch (action) {
+        case ACTION_LEFT:
+        case ACTION_LEFT_FIRE:
+            input.moveDir = -1;
+            break;
+        case ACTION_RIGHT:
+        case ACTION_RIGHT_FIRE:
+            input.moveDir = 1;
+            break;
+        default:
+            break;
+    }
+    input.fire = action == ACTION_FIRE || action == ACTION_LEFT_FIRE || action == ACTION_RIGHT_FIRE;
+
+    const size_t score = game.score;
+    for (size_t si = 0; si < config.frameSkip && !isDone(); ++si) {
+        sim::step(game, input, grid);
+        ++steps;
+        // A press fires once, holding the action does not fire every step
+        input.fire = false;
+    }
+    return observe(static_cast<float>(game.score - score));
+}
+
+const data::Game& Env::getGame() const
+{
+    return game;
+}
+
+StepResult Env::observe(float reward)
+{
+    computeFeatures();
+
+    Observation observation{nullptr, 0, 0, 0, buffer.getFormat()};
+    if (config.observation != OBSERVATION_NONE) {
+        // Only what moved is cleared and drawn again
+        buffer.clearDamaged(clearColor);
+        render::drawGame(buffer, game, color);
+        // Nothing is uploaded, merging the damage would cost more than
+        // packing overlapping regions twice
+        const std::vector<data::Region>& damage = buffer.collectRawDamage();
+
+        if (config.observation == OBSERVATION_FRAME) {
+            observation = {
+                buffer.getData(), buffer.getWidth(), buffer.getHeight(),
+                buffer.getStride(), buffer.getFormat()
+            };
+        } else {
+            pack(damage);
+            size_t width = (buffer.getWidth() + config.downsample - 1) / config.downsample;
+            size_t height = (buffer.getHeight() + config.downsample - 1) / config.downsample;
+            observation = {packed.data(), width, height, (width + 31) / 32, data::FORMAT_MONO1};
+        }
+    }
+
+    return {reward, isDone(), observation, features.data()};
+}
+
+void Env::pack(const std::vector<data::Region>& damage)
+{
+    const size_t block = config.downsample;
+    const size_t width = buffer.getWidth();
+    const size_t height = buffer.getHeight();
+    const size_t stride = buffer.getStride();
+    const size_t packedWidth = (width + block - 1) / block;
+    const size_t packedHeight = (height + block - 1) / block;
+    const size_t packedStride = (packedWidth + 31) / 32;
+    const uint32_t* src = buffer.getData();
+
+    // Regions overlap, so collect the changed blocks of every packed row
+    // first and pack each block once
+    std::fill(dirtyBegin.begin(), dirtyBegin.end(), packedWidth);
+    std::fill(dirtyEnd.begin(), dirtyEnd.end(), 0);
+    for (const data::Region& region : damage) {
+        if (!region.width || !region.height) {
+            continue;
+        }
+        size_t firstColumn = region.x / block;
+        size_t endColumn = (region.x + region.width - 1) / block + 1;
+        size_t endRow = std::min((region.y + region.height - 1) / block + 1, packedHeight);
+        for (size_t by = region.y / block; by < endRow; ++by) {
+            dirtyBegin[by] = std::min(dirtyBegin[by], firstColumn);
+            dirtyEnd[by] = std::max(dirtyEnd[by], std::min(endColumn, packedWidth));
+        }
+    }
+
+    // Power of two blocks are reduced 32 bits at a time, a source word
+    // then covers 32 / block bits of a packed word
+    const bool wordWise = (block & (block - 1)) == 0;
+    const size_t sourceWords = wordWise ? packedStride * block : stride;
+    for (size_t by = 0; by < packedHeight; ++by) {
+        if (dirtyBegin[by] >= dirtyEnd[by]) {
+            continue;
+        }
+
+        // Rows of a block are ORed a word at a time, then every block is
+        // read out of the combined row
+        size_t firstWord = wordWise ? dirtyBegin[by] / 32 * block : dirtyBegin[by] * block / 32;
+        size_t endWord = wordWise
+            ? (dirtyEnd[by] + 31) / 32 * block
+            : std::min((dirtyEnd[by] * block + 31) / 32 + 1, stride);
+        size_t rowEnd = std::min((by + 1) * block, height);
+        std::fill(rowOr.begin() + firstWord, rowOr.begin() + endWord, 0);
+        for (size_t yi = by * block; yi < rowEnd; ++yi) {
+            const uint32_t* row = src + yi * stride;
+            for (size_t wi = firstWord; wi < std::min(endWord, stride); ++wi) {
+                rowOr[wi] |= row[wi];
+            }
+        }
+
+        uint32_t* out = packed.data() + by * packedStride;
+        if (wordWise) {
+            for (size_t wi = firstWord; wi < endWord; wi += block) {
+                uint32_t word = 0;
+                for (size_t bi = 0; bi < block; ++bi) {
+                    word |= compactBlocks(rowOr[wi + bi]) << (bi * 32 / block);
+                }
+                out[wi / block] = word;
+            }
+            continue;
+        }
+        for (size_t bx = dirtyBegin[by]; bx < dirtyEnd[by]; ++bx) {
+            size_t column = bx * block;
+            bool lit = readBits(rowOr.data(), sourceWords, column, std::min(block, width - column)) != 0;
+            uint32_t bit = uint32_t{1} << (bx % 32);
+            out[bx / 32] = lit ? out[bx / 32] | bit : out[bx / 32] & ~bit;
+        }
+    }
+}
+
+uint32_t Env::compactBlocks(uint32_t bits) const
+{
+    const size_t block = config.downsample;
+    // Any lit pixel of a block ends up in its lowest bit
+    for (size_t shift = 1; shift < block; shift <<= 1) {
+        bits |= bits >> shift;
+    }
+    // Then neighbouring groups of those bits are pulled together until
+    // they form the low 32 / block bits
+    size_t step = 0;
+    for (size_t group = 1; group < 32 / block; group <<= 1, ++step) {
+        bits &= compactMasks[step];
+        bits = (bits | (bits >> (group * (block - 1))));
+    }
+    return bits & compactMasks[step];
+}
+
+void Env::computeFeatures()
+{
+    const float width = static_cast<float>(game.width);
+    const float height = static_cast<float>(game.height);
+    const data::AlienStore& aliens = game.aliens;
+    const ptrdiff_t playerCenter = static_cast<ptrdiff_t>(game.player.x + sprites::PLAYER_SPRITE.width / 2);
+
+    float* columns = features.data() + 6;
+    std::fill(columns, columns + FEATURE_COLUMNS, 1.0f);
+    float lowest = 1.0f;
+    float closestDistance = 0.0f;
+    float closestRow = 1.0f;
+    ptrdiff_t closest = -1;
+    for (size_t i = 0; i < aliens.numAlive; ++i) {
+        size_t ai = aliens.alive[i];
+        const data::Sprite& sprite = sprites::ALIEN_SPRITES[aliens.frame[ai]];
+        ptrdiff_t center = game.formation.x + aliens.x[ai] + static_cast<ptrdiff_t>(sprite.width / 2);
+        float row = (game.formation.y + aliens.y[ai]) / height;
+        lowest = std::min(lowest, row);
+
+        size_t column = static_cast<size_t>(std::clamp<ptrdiff_t>(
+            center * static_cast<ptrdiff_t>(FEATURE_COLUMNS) / static_cast<ptrdiff_t>(game.width),
+            0, FEATURE_COLUMNS - 1
+        ));
+        columns[column] = std::min(columns[column], row);
+
+        ptrdiff_t distance = center - playerCenter;
+        if (closest < 0 || std::abs(distance) < closest) {
+            closest = std::abs(distance);
+            closestDistance = distance / width;
+            closestRow = row;
+        }
+    }
+
+    features[0] = game.player.x / width;
+    features[1] = aliens.count ? static_cast<float>(aliens.numAlive) / aliens.count : 0.0f;
+    features[2] = static_cast<float>(game.bullets.count) / GAME_MAX_BULLETS;
+    features[3] = lowest;
+    features[4] = closestDistance;
+    features[5] = closestRow;
+}
+
+bool Env::isDone() const
+{
+    return game.aliens.numAlive == 0 || game.player.life == 0
+        || (config.maxSteps && steps >= config.maxSteps);
+}
+
+} // sim
@@ -0,0 +1,85 @@
+#include "data/font.hpp"
+
+namespace data {
+
+Font::Font(const PackedSprite& atlas, size_t numGlyphs, char firstChar)
+    : atlas(atlas), numGlyphs(numGlyphs), firstChar(firstChar)
+{
+}
+
+size_t Font::advance() const
+{
+    return atlas.width + 1;
+}
+
+PackedSprite Font::glyph(char character) const
+{
+    return data::glyph(atlas, character - firstChar);
+}
+
+const TextLayout& Font::layout(const std::string& text)
+{
+    auto found = layouts.find(text);
+    if (found != layouts.end()) {
+        return found->second;
+    }
+
+    std::vector<size_t> indices;
+    for (char character : text) {
+        int index = character - firstChar;
+        if (index >= 0 && static_cast<size_t>(index) < numGlyphs) {
+            indices.push_back(index);
+        }
+    }
+
+    TextLayout line;
+    line.width = indices.empty() ? 0 : indices.size() * advance() - 1;
+    line.height = atlas.height;
+    line.numStrips = (line.width + PACKED_MAX_WIDTH - 1) / PACKED_MAX_WIDTH;
+    line.rows.assign(line.numStrips * line.height, 0);
+
+    // Glyphs are at most one strip wide, so each one spills over into at
+    // most the next strip
+    for (size_t gi = 0; gi < indices.size(); ++gi) {
+        size_t x = gi * advance();
+        size_t strip = x / PACKED_MAX_WIDTH;
+        unsigned shift = x % PACKED_MAX_WIDTH;
+        const uint16_t* rows = atlas.rows + indices[gi] * atlas.height;
+        for (size_t yi = 0; yi < atlas.height; ++yi) {
+            uint32_t bits = static_cast<uint32_t>(rows[yi]) << shift;
+            line.rows[strip * line.height + yi] |= static_cast<uint16_t>(bits);
+            if (bits >> PACKED_MAX_WIDTH) {
+                line.rows[(strip + 1) * line.height + yi] |= static_cast<uint16_t>(bits >> PACKED_MAX_WIDTH);
+            }
+        }
+    }
+
+    return layouts.emplace(text, std::move(line)).first->second;
+}
+
+NumberLabel::NumberLabel(const Font& font, size_t x, size_t y)
+    : font(font), position{x, y}
+{
+}
+
+void NumberLabel::invalidate()
+{
+    valid = false;
+}
+
+size_t NumberLabel::toDigits(size_t value, uint8_t* out)
+{
+    uint8_t reversed[MAX_DIGITS];
+    size_t count = 0;
+    do {
+        reversed[count++] = value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = reversed[count - i - 1];
+    }
+    return count;
+}
+
+} // data
@@ -0,0 +1,270 @@
+#include "render/frame_capture.hpp"
+#include <algorithm>
+#include <chrono>
+#include "render/frame_file.hpp"
+
+namespace render {
+
+namespace {
+
+/**
+ * @brief Words of a row a region of the buffer covers.
+ *
+ * @var first First word.
+ * @var count Number of words.
+ */
+struct WordRange {
+    size_t first;
+    size_t count;
+};
+
+WordRange wordRange(data::PixelFormat format, const data::Region& region)
+{
+    size_t pixelsPerWord = 1;
+    switch (format) {
+        case data::FORMAT_RGBA32:
+            pixelsPerWord = 1;
+            break;
+        case data::FORMAT_INDEXED8:
+            pixelsPerWord = 4;
+            break;
+        case data::FORMAT_MONO1:
+            pixelsPerWord = 32;
+            break;
+    }
+    size_t first = region.x / pixelsPerWord;
+    size_t last = (region.x + region.width + pixelsPerWord - 1) / pixelsPerWord;
+    return {first, last - first};
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(
+    data::Buffer& buffer, const std::string& path,
+    double budgetMicros, size_t keyInterval, size_t numPackets
+)
+    : budgetMicros(budgetMicros), keyInterval(keyInterval ? keyInterval : 1)
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "Error opening %s for writing.\n", path.c_str());
+        return;
+    }
+
+    const size_t width = buffer.getWidth();
+    const size_t height = buffer.getHeight();
+    FrameFileHeader header{
+        static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        static_cast<uint32_t>(this->keyInterval)
+    };
+    if (!writeFrameFileHeader(file, header)) {
+        fprintf(stderr, "Error writing %s.\n", path.c_str());
+        fclose(file);
+        file = nullptr;
+        return;
+    }
+
+    mirror = std::make_unique<data::Buffer>(width, height, buffer.getFormat());
+    current.assign(width * height, 0);
+    previous.assign(width * height, 0);
+
+    // Everything a packet can hold is allocated up front, so capturing
+    // never allocates on the game thread
+    packets.resize(std::max<size_t>(numPackets, 1));
+    for (Packet& packet : packets) {
+        packet.regions.reserve(2 * data::MAX_DAMAGE_REGIONS);
+        packet.words.reserve(buffer.getStride() * height);
+        freePackets.push_back(&packet);
+    }
+    queued.reserve(packets.size());
+    missed.reserve(2 * data::MAX_DAMAGE_REGIONS);
+
+    writer = std::thread(&FrameCapture::writerLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+    finish();
+}
+
+bool FrameCapture::finish()
+{
+    if (!file) {
+        return !failed;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+    if (fclose(file) != 0 && !failed) {
+        fprintf(stderr, "Error closing frame capture file.\n");
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
+
+bool FrameCapture::isOpen() const
+{
+    return file != nullptr;
+}
+
+void FrameCapture::capture(data::Buffer& buffer, const std::vector<data::Region>& damage)
+{
+    if (!file || failed) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t frame = stats.frames++;
+
+    Packet* packet = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freePackets.empty()) {
+            packet = freePackets.back();
+            freePackets.pop_back();
+        }
+    }
+
+    if (!packet) {
+        // The writer's copy misses this frame's changes, they go out with
+        // the next frame that makes it
+        ++stats.dropped;
+        missed.insert(missed.end(), damage.begin(), damage.end());
+        data::mergeRegions(missed);
+    } else {
+        packet->frame = frame;
+        packet->regions.clear();
+        packet->words.clear();
+        bool whole = resync || damage.size() + missed.size() > packet->regions.capacity();
+        if (!whole) {
+            packet->regions.insert(packet->regions.end(), damage.begin(), damage.end());
+            if (!missed.empty()) {
+                packet->regions.insert(packet->regions.end(), missed.begin(), missed.end());
+                data::mergeRegions(packet->regions);
+            }
+
+            // Merged regions may overlap and compact formats round every
+            // row out to whole words, if they add up to more than a packet
+            // holds the whole frame goes instead
+            size_t words = 0;
+            for (const data::Region& region : packet->regions) {
+                words += wordRange(buffer.getFormat(), region).count * region.height;
+            }
+            whole = words > packet->words.capacity();
+        }
+        if (whole) {
+            packet->regions.clear();
+            packet->regions.push_back({{0, 0}, {buffer.getWidth(), buffer.getHeight()}});
+        }
+        missed.clear();
+
+        const size_t stride = buffer.getStride();
+        for (const data::Region& region : packet->regions) {
+            WordRange range = wordRange(buffer.getFormat(), region);
+            for (size_t yi = region.y; yi < region.y + region.height; ++yi) {
+                const uint32_t* row = buffer.getData() + yi * stride + range.first;
+                packet->words.insert(packet->words.end(), row, row + range.count);
+            }
+        }
+
+        packet->hasPalette = resync || buffer.getPaletteVersion() != paletteVersion;
+        if (packet->hasPalette) {
+            std::copy_n(buffer.getPalette(), packet->palette.size(), packet->palette.begin());
+            paletteVersion = buffer.getPaletteVersion();
+        }
+        resync = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(packet);
+        }
+        wake.notify_one();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double micros = std::chrono::duration<double, std::micro>(end - start).count();
+    stats.totalMicros += micros;
+    stats.maxMicros = std::max(stats.maxMicros, micros);
+    if (micros > budgetMicros) {
+        ++stats.overBudget;
+    }
+}
+
+CaptureStats FrameCapture::getStats() const
+{
+    CaptureStats result = stats;
+    result.bytes = bytesWritten;
+    result.failed = failed;
+    return result;
+}
+
+void FrameCapture::writerLoop()
+{
+    while (true) {
+        Packet* packet = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (queued.empty()) {
+                return;
+            }
+            packet = queued.front();
+            queued.erase(queued.begin());
+        }
+
+        // Packets queued after a failure are only handed back
+        if (!failed) {
+            write(*packet);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freePackets.push_back(packet);
+    }
+}
+
+void FrameCapture::write(Packet& packet)
+{
+    const size_t width = mirror->getWidth();
+    const size_t height = mirror->getHeight();
+    const size_t stride = mirror->getStride();
+
+    const uint32_t* src = packet.words.data();
+    for (const data::Region& region : packet.regions) {
+        WordRange range = wordRange(mirror->getFormat(), region);
+        for (size_t yi = region.y; yi < region.y + region.height; ++yi) {
+            std::copy_n(src, range.count, mirror->getData() + yi * stride + range.first);
+            src += range.count;
+        }
+    }
+
+    if (packet.hasPalette) {
+        // Every pixel of a compact buffer may have changed color
+        mirror->setPalette(std::vector<uint32_t>(packet.palette.begin(), packet.palette.end()));
+        mirror->expand(current.data(), width, {{0, 0}, {width, height}});
+    } else {
+        for (const data::Region& region : packet.regions) {
+            mirror->expand(current.data(), width, region);
+        }
+    }
+
+    uint8_t flags = 0;
+    if (records % keyInterval == 0) {
+        flags = FRAME_KEY;
+        std::fill(previous.begin(), previous.end(), 0);
+    }
+    payload.clear();
+    encodeDelta(current.data(), previous.data(), current.size(), payload);
+    if (!writeFrameRecord(file, packet.frame, flags, payload)) {
+        fprintf(stderr, "Error writing frame capture file, capture stopped.\n");
+        failed = true;
+        return;
+    }
+    ++records;
+    bytesWritten += 9 + payload.size();
+}
+
+} // render
@@ -0,0 +1,420 @@
+#include "render/frame_file.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace render {
+
+namespace {
+
+const char MAGIC[4] = {'S', 'I', 'F', 'C'};
+const size_t HEADER_SIZE = 20;
+const size_t RECORD_HEADER_SIZE = 9;
+
+// Runs of identical pixels at least this long are stored as a fill
+const size_t MIN_FILL = 3;
+
+// Pixels compared at once while looking for the next change
+const size_t SKIP_BLOCK = 16;
+
+void putU16(uint8_t* out, uint16_t value)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+}
+
+void putU32(uint8_t* out, uint32_t value)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = value >> (8 * i);
+    }
+}
+
+uint16_t getU16(const uint8_t* in)
+{
+    return in[0] | in[1] << 8;
+}
+
+uint32_t getU32(const uint8_t* in)
+{
+    return in[0] | in[1] << 8 | in[2] << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+void putVarint(std::vector<uint8_t>& out, size_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(value | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+bool getVarint(const uint8_t*& in, const uint8_t* end, size_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void putPixel(std::vector<uint8_t>& out, uint32_t pixel)
+{
+    size_t at = out.size();
+    out.resize(at + 4);
+    putU32(out.data() + at, pixel);
+}
+
+/**
+ * @brief Gets the length of the run of identical pixels starting at pixels.
+ */
+size_t runLength(const uint32_t* pixels, size_t count)
+{
+    size_t length = 1;
+    while (length < count && pixels[length] == pixels[0]) {
+        ++length;
+    }
+    return length;
+}
+
+/**
+ * @brief Converts a frame into top-first rows of 8-bit RGB triplets.
+ */
+std::vector<uint8_t> toRgbRows(const uint32_t* pixels, size_t width, size_t height, size_t rowPrefix)
+{
+    const size_t rowBytes = rowPrefix + 3 * width;
+    std::vector<uint8_t> rows(rowBytes * height, 0);
+    // Frame row 0 is the bottom of the screen
+    for (size_t yi = 0; yi < height; ++yi) {
+        const uint32_t* src = pixels + (height - 1 - yi) * width;
+        uint8_t* dst = rows.data() + yi * rowBytes + rowPrefix;
+        for (size_t xi = 0; xi < width; ++xi) {
+            dst[3 * xi + 0] = src[xi] >> 24;
+            dst[3 * xi + 1] = src[xi] >> 16;
+            dst[3 * xi + 2] = src[xi] >> 8;
+        }
+    }
+    return rows;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool writePngChunk(FILE* file, const char* type, const std::vector<uint8_t>& data)
+{
+    uint8_t length[4] = {
+        static_cast<uint8_t>(data.size() >> 24), static_cast<uint8_t>(data.size() >> 16),
+        static_cast<uint8_t>(data.size() >> 8), static_cast<uint8_t>(data.size())
+    };
+    uint32_t crc = crc32(reinterpret_cast<const uint8_t*>(type), 4);
+    crc = crc32(data.data(), data.size(), crc);
+    uint8_t crcBytes[4] = {
+        static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+        static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)
+    };
+    return fwrite(length, 1, 4, file) == 4
+        && fwrite(type, 1, 4, file) == 4
+        && (data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size())
+        && fwrite(crcBytes, 1, 4, file) == 4;
+}
+
+} // namespace
+
+bool writeFrameFileHeader(FILE* file, const FrameFileHeader& header)
+{
+    uint8_t bytes[HEADER_SIZE];
+    std::memcpy(bytes, MAGIC, 4);
+    putU16(bytes + 4, FRAME_FILE_VERSION);
+    putU16(bytes + 6, 0);
+    putU32(bytes + 8, header.width);
+    putU32(bytes + 12, header.height);
+    putU32(bytes + 16, header.keyInterval);
+    return fwrite(bytes, 1, HEADER_SIZE, file) == HEADER_SIZE;
+}
+
+bool writeFrameRecord(FILE* file, uint32_t frame, uint8_t flags, const std::vector<uint8_t>& payload)
+{
+    uint8_t bytes[RECORD_HEADER_SIZE];
+    putU32(bytes, payload.size());
+    putU32(bytes + 4, frame);
+    bytes[8] = flags;
+    return fwrite(bytes, 1, RECORD_HEADER_SIZE, file) == RECORD_HEADER_SIZE
+        && (payload.empty() || fwrite(payload.data(), 1, payload.size(), file) == payload.size());
+}
+
+void encodeDelta(const uint32_t* current, uint32_t* previous, size_t count, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+    while (i < count) {
+        size_t skip = 0;
+        // Most of a frame is unchanged, skip it a block at a time
+        while (i + SKIP_BLOCK <= count
+               && std::memcmp(current + i, previous + i, SKIP_BLOCK * sizeof(uint32_t)) == 0) {
+            skip += SKIP_BLOCK;
+            i += SKIP_BLOCK;
+        }
+        while (i < count && current[i] == previous[i]) {
+            ++skip;
+            ++i;
+        }
+        if (i == count) {
+            break;
+        }
+
+        // Changed stretch, split into fills and literals
+        size_t end = i;
+        while (end < count && current[end] != previous[end]) {
+            ++end;
+        }
+        while (i < end) {
+            size_t run = runLength(current + i, end - i);
+            if (run >= MIN_FILL) {
+                putVarint(out, skip);
+                putVarint(out, run << 1 | 1);
+                putPixel(out, current[i]);
+            } else {
+                // Literal up to the next run worth filling
+                size_t literal = run;
+                while (i + literal < end) {
+                    size_t next = runLength(current + i + literal, end - i - literal);
+                    if (next >= MIN_FILL) {
+                        break;
+                    }
+                    literal += next;
+                }
+                run = literal;
+                putVarint(out, skip);
+                putVarint(out, run << 1);
+                for (size_t k = 0; k < run; ++k) {
+                    putPixel(out, current[i + k]);
+                }
+            }
+            std::copy_n(current + i, run, previous + i);
+            i += run;
+            skip = 0;
+        }
+    }
+}
+
+bool decodeDelta(const uint8_t* data, size_t size, uint32_t* frame, size_t count)
+{
+    const uint8_t* in = data;
+    const uint8_t* end = data + size;
+    size_t at = 0;
+    while (in < end) {
+        size_t skip = 0;
+        size_t token = 0;
+        if (!getVarint(in, end, skip) || !getVarint(in, end, token)) {
+            return false;
+        }
+        size_t run = token >> 1;
+        if (skip > count - at || run > count - at - skip) {
+            return false;
+        }
+        at += skip;
+        size_t pixels = token & 1 ? 1 : run;
+        if (static_cast<size_t>(end - in) < 4 * pixels) {
+            return false;
+        }
+        if (token & 1) {
+            std::fill_n(frame + at, run, getU32(in));
+        } else {
+            for (size_t k = 0; k < run; ++k) {
+                frame[at + k] = getU32(in + 4 * k);
+            }
+        }
+        in += 4 * pixels;
+        at += run;
+    }
+    return true;
+}
+
+bool writePpm(const std::string& path, const uint32_t* pixels, size_t width, size_t height)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> rows = toRgbRows(pixels, width, height, 0);
+    bool ok = fprintf(file, "P6\n%zu %zu\n255\n", width, height) > 0
+           && fwrite(rows.data(), 1, rows.size(), file) == rows.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool writePng(const std::string& path, const uint32_t* pixels, size_t width, size_t height)
+{
+    // Every row starts with filter type 0
+    std::vector<uint8_t> rows = toRgbRows(pixels, width, height, 1);
+
+    // zlib stream of stored deflate blocks of at most 65535 bytes
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    for (size_t at = 0; at < rows.size() || at == 0;) {
+        size_t length = std::min<size_t>(rows.size() - at, 65535);
+        bool last = at + length == rows.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(length);
+        idat.push_back(length >> 8);
+        idat.push_back(~length);
+        idat.push_back(~length >> 8);
+        idat.insert(idat.end(), rows.begin() + at, rows.begin() + at + length);
+        at += length;
+        if (last) {
+            break;
+        }
+    }
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (uint8_t byte : rows) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = b << 16 | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        idat.push_back(adler >> shift);
+    }
+
+    std::vector<uint8_t> ihdr(13, 0);
+    for (size_t i = 0; i < 4; ++i) {
+        ihdr[i] = width >> (24 - 8 * i);
+        ihdr[4 + i] = height >> (24 - 8 * i);
+    }
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 2; // truecolor
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    bool ok = fwrite(signature, 1, 8, file) == 8
+           && writePngChunk(file, "IHDR", ihdr)
+           && writePngChunk(file, "IDAT", idat)
+           && writePngChunk(file, "IEND", {});
+    return fclose(file) == 0 && ok;
+}
+
+FrameFileReader::~FrameFileReader()
+{
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool FrameFileReader::open(const std::string& path)
+{
+    if (file) {
+        fclose(file);
+    }
+    records.clear();
+    file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    uint8_t bytes[HEADER_SIZE];
+    if (fread(bytes, 1, HEADER_SIZE, file) != HEADER_SIZE
+        || std::memcmp(bytes, MAGIC, 4) != 0
+        || getU16(bytes + 4) != FRAME_FILE_VERSION) {
+        return false;
+    }
+    header.width = getU32(bytes + 8);
+    header.height = getU32(bytes + 12);
+    header.keyInterval = getU32(bytes + 16);
+
+    uint64_t offset = HEADER_SIZE;
+    uint8_t recordBytes[RECORD_HEADER_SIZE];
+    while (fread(recordBytes, 1, RECORD_HEADER_SIZE, file) == RECORD_HEADER_SIZE) {
+        FrameRecord record;
+        record.offset = offset + RECORD_HEADER_SIZE;
+        record.size = getU32(recordBytes);
+        record.frame = getU32(recordBytes + 4);
+        record.flags = recordBytes[8];
+        if (fseek(file, record.size, SEEK_CUR) != 0) {
+            break;
+        }
+        offset = record.offset + record.size;
+        records.push_back(record);
+    }
+
+    // fseek happily moves past the end, drop a record cut short
+    if (fseek(file, 0, SEEK_END) == 0 && !records.empty()) {
+        long fileSize = ftell(file);
+        const FrameRecord& last = records.back();
+        if (fileSize >= 0 && last.offset + last.size > static_cast<uint64_t>(fileSize)) {
+            records.pop_back();
+        }
+    }
+
+    pixels.assign(static_cast<size_t>(header.width) * header.height, 0);
+    decoded = records.size();
+    return true;
+}
+
+const FrameFileHeader& FrameFileReader::getHeader() const
+{
+    return header;
+}
+
+const std::vector<FrameRecord>& FrameFileReader::getRecords() const
+{
+    return records;
+}
+
+const uint32_t* FrameFileReader::decode(size_t index)
+{
+    if (!file || index >= records.size()) {
+        return nullptr;
+    }
+
+    size_t key = index;
+    while (key > 0 && !(records[key].flags & FRAME_KEY)) {
+        --key;
+    }
+    size_t first = key;
+    if (decoded < records.size() && decoded <= index && decoded >= key) {
+        first = decoded + 1;
+    } else {
+        std::fill(pixels.begin(), pixels.end(), 0);
+    }
+
+    for (size_t i = first; i <= index; ++i) {
+        const FrameRecord& record = records[i];
+        payload.resize(record.size);
+        decoded = records.size();
+        if (fseek(file, record.offset, SEEK_SET) != 0
+            || fread(payload.data(), 1, record.size, file) != record.size) {
+            return nullptr;
+        }
+        if (record.flags & FRAME_KEY) {
+            std::fill(pixels.begin(), pixels.end(), 0);
+        }
+        if (!decodeDelta(payload.data(), payload.size(), pixels.data(), pixels.size())) {
+            return nullptr;
+        }
+        decoded = i;
+    }
+    return pixels.data();
+}
+
+} // render
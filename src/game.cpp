@@ -0,0 +1,553 @@
+#include "sim/game.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "sprites/aliens.hpp"
+#include "sprites/player.hpp"
+#include "sprites/shield.hpp"
+#include "sim/bullets.hpp"
+#include "sim/shields.hpp"
+#include "util/utility.hpp"
+
+namespace sim {
+
+namespace {
+
+// Layout of the formation, offsets are from its origin
+const int16_t COLUMN_SPACING = 16;
+const int16_t ROW_SPACING = 17;
+const int16_t FORMATION_X = 20;
+const int16_t FORMATION_Y = 128;
+
+// The formation moves MARCH_STEP pixels sideways per march step and
+// MARCH_DROP down instead when it would come closer than MARCH_MARGIN
+// to an edge of the screen
+const int16_t MARCH_STEP = 2;
+const int16_t MARCH_DROP = 8;
+const int16_t MARCH_MARGIN = 8;
+
+// Bottom row of the shields
+const size_t SHIELD_Y = 48;
+
+// A single shot every 40 steps, at most 3 in flight, falling a pixel a step
+const uint32_t FIRE_SEED = 0x9E3779B9;
+const uint16_t FIRE_PERIOD = 40;
+const uint16_t FIRE_VOLLEY = 1;
+const uint16_t FIRE_MAX_BULLETS = 3;
+const uint16_t FIRE_SPEED = 1;
+
+/**
+ * @brief Gets the steps between two march steps.
+ * @details The fewer aliens are left, the faster the formation marches,
+ *          the last one steps every step.
+ */
+uint16_t marchPeriod(size_t numAlive)
+{
+    return static_cast<uint16_t>(1 + numAlive / 4);
+}
+
+/**
+ * @brief Gets the box of a cell of the formation, large enough for every
+ *        alien sprite and the explosion.
+ */
+data::Rectangle formationCell()
+{
+    data::Rectangle cell{sprites::ALIEN_DEATH_SPRITE.width, sprites::ALIEN_DEATH_SPRITE.height};
+    for (const data::Sprite& sprite : sprites::ALIEN_SPRITES) {
+        cell.width = std::max(cell.width, sprite.width);
+        cell.height = std::max(cell.height, sprite.height);
+    }
+    return cell;
+}
+
+/**
+ * @brief Checks whether a sprite at a position overlaps a box.
+ */
+bool overlaps(const data::Region& box, size_t x, size_t y, const data::Sprite& sprite)
+{
+    return box.width
+        && x < box.x + box.width && x + sprite.width > box.x
+        && y < box.y + box.height && y + sprite.height > box.y;
+}
+
+int16_t lerp(int16_t from, int16_t to, double alpha)
+{
+    return static_cast<int16_t>(from + std::lround((to - from) * alpha));
+}
+
+size_t lerp(size_t from, size_t to, double alpha)
+{
+    // Positions may have wrapped below 0, blend them signed
+    ptrdiff_t a = static_cast<ptrdiff_t>(from);
+    ptrdiff_t b = static_cast<ptrdiff_t>(to);
+    return static_cast<size_t>(a + static_cast<ptrdiff_t>(std::lround((b - a) * alpha)));
+}
+
+/**
+ * @brief Gets the box an alien of a type is listed in the grid with.
+ * @details Large enough for every frame of its animation.
+ */
+data::Rectangle alienBounds(uint8_t type)
+{
+    const data::Sprite& a = sprites::ALIEN_SPRITES[2 * (type - 1)];
+    const data::Sprite& b = sprites::ALIEN_SPRITES[2 * (type - 1) + 1];
+    return {std::max(a.width, b.width), std::max(a.height, b.height)};
+}
+
+/**
+ * @brief Marks a living alien as dying, takes it off the alive list and
+ *        out of the formation's counts.
+ * @details The extents only move past rows and columns that emptied, at
+ *          most FORMATION_COLUMNS times in a whole game, so a kill costs
+ *          O(1) amortized.
+ */
+void killAlien(data::Game& game, size_t ai)
+{
+    data::AlienStore& aliens = game.aliens;
+    aliens.state[ai] = data::ALIEN_DYING;
+    uint16_t slot = aliens.aliveSlot[ai];
+    uint16_t last = aliens.alive[--aliens.numAlive];
+    aliens.alive[slot] = last;
+    aliens.aliveSlot[last] = slot;
+
+    data::Formation& formation = game.formation;
+    const size_t column = ai % data::FORMATION_COLUMNS;
+    const size_t row = ai / data::FORMATION_COLUMNS;
+    --formation.rowAlive[row];
+    if (--formation.columnAlive[column] && formation.columnBottom[column] == row) {
+        // The next living alien up the column becomes its lowest
+        size_t up = row + 1;
+        while (aliens.state[up * data::FORMATION_COLUMNS + column] != data::ALIEN_ALIVE) {
+            ++up;
+        }
+        formation.columnBottom[column] = static_cast<uint16_t>(up);
+    }
+    if (!aliens.numAlive) {
+        return;
+    }
+
+    while (!formation.columnAlive[formation.left]) {
+        ++formation.left;
+    }
+    while (!formation.columnAlive[formation.right]) {
+        --formation.right;
+    }
+    while (!formation.rowAlive[formation.bottom]) {
+        ++formation.bottom;
+    }
+    while (!formation.rowAlive[formation.top]) {
+        --formation.top;
+    }
+}
+
+/**
+ * @brief Clears the shield pixels under the living aliens.
+ * @details Only rows of the formation low enough to reach the shields
+ *          are looked at, each living alien clears its cell.
+ */
+void trampleShields(data::Game& game)
+{
+    const data::Formation& formation = game.formation;
+    ptrdiff_t shieldTop = 0;
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        shieldTop = std::max<ptrdiff_t>(shieldTop, game.shields.y[si] + static_cast<ptrdiff_t>(data::SHIELD_HEIGHT));
+    }
+
+    const data::Rectangle cell = formationCell();
+    for (size_t row = formation.bottom; row <= formation.top; ++row) {
+        const ptrdiff_t rowY = formation.y + static_cast<ptrdiff_t>(row) * ROW_SPACING;
+        if (rowY >= shieldTop) {
+            break;
+        }
+        for (size_t column = formation.left; column <= formation.right; ++column) {
+            if (game.aliens.state[row * data::FORMATION_COLUMNS + column] != data::ALIEN_ALIVE) {
+                continue;
+            }
+            data::Region box;
+            box.x = static_cast<size_t>(formation.x + static_cast<ptrdiff_t>(column) * COLUMN_SPACING);
+            box.y = static_cast<size_t>(rowY);
+            box.width = cell.width;
+            box.height = cell.height;
+            clearShields(game.shields, box);
+        }
+    }
+}
+
+/**
+ * @brief Moves the formation one march step once its timer runs out.
+ * @details Only the origin moves. Reaching an edge is decided from the
+ *          outermost living columns alone, the formation then drops a
+ *          row and turns around. Dropping down to the player ends the game.
+ */
+void march(data::Game& game)
+{
+    data::Formation& formation = game.formation;
+    if (!game.aliens.numAlive || !game.player.life || --formation.timer) {
+        return;
+    }
+    formation.timer = marchPeriod(game.aliens.numAlive);
+    ++formation.marches;
+
+    const data::Rectangle cell = formationCell();
+    const ptrdiff_t left = formation.x + formation.left * COLUMN_SPACING;
+    const ptrdiff_t right = formation.x + formation.right * COLUMN_SPACING + static_cast<ptrdiff_t>(cell.width);
+    const ptrdiff_t next = formation.dir * MARCH_STEP;
+    if (left + next < MARCH_MARGIN || right + next > static_cast<ptrdiff_t>(game.width) - MARCH_MARGIN) {
+        formation.y = static_cast<int16_t>(formation.y - MARCH_DROP);
+        formation.dir = static_cast<int16_t>(-formation.dir);
+    } else {
+        formation.x = static_cast<int16_t>(formation.x + next);
+    }
+    if (game.aliens.numAlive) {
+        trampleShields(game);
+    }
+
+    const ptrdiff_t bottom = formation.y + formation.bottom * ROW_SPACING;
+    if (bottom <= static_cast<ptrdiff_t>(game.player.y + sprites::PLAYER_SPRITE.height)) {
+        game.player.life = 0;
+    }
+}
+
+/**
+ * @brief Adds an impact to the log, overwriting the oldest once it is full.
+ */
+void logImpact(data::Game& game, size_t x, size_t y, int16_t dir, data::ImpactKind kind, uint8_t type = 0)
+{
+    data::ImpactLog& log = game.impacts;
+    data::Impact& impact = log.entries[log.count++ % data::IMPACT_LOG_SIZE];
+    impact.x = static_cast<int16_t>(x);
+    impact.y = static_cast<int16_t>(y);
+    impact.dir = dir;
+    impact.kind = kind;
+    impact.type = type;
+}
+
+/**
+ * @brief Draws the next number from the fire generator, xorshift32.
+ */
+uint32_t nextFireRandom(data::AlienFire& fire)
+{
+    uint32_t x = fire.seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fire.seed = x;
+    return x;
+}
+
+/**
+ * @brief Fires a volley from the formation once the fire timer runs out.
+ * @details Each shot picks a random column and leaves from its lowest
+ *          living alien, an empty column passes the shot on to the next
+ *          one to its right that has a living alien.
+ */
+void fireAliens(data::Game& game)
+{
+    data::AlienFire& fire = game.fire;
+    if (!game.aliens.numAlive || !game.player.life || --fire.timer) {
+        return;
+    }
+    fire.timer = fire.period;
+
+    const data::AlienStore& aliens = game.aliens;
+    const int16_t bulletHeight = static_cast<int16_t>(sprites::BULLET_SPRITE.height);
+    for (size_t shot = 0; shot < fire.volley && game.bullets.numAlien < fire.maxBullets; ++shot) {
+        size_t column = nextFireRandom(fire) % data::FORMATION_COLUMNS;
+        while (!game.formation.columnAlive[column]) {
+            column = (column + 1) % data::FORMATION_COLUMNS;
+        }
+        const size_t ai = columnShooter(game, column);
+        const int16_t x = static_cast<int16_t>(
+            game.formation.x + aliens.x[ai] + static_cast<int16_t>(alienBounds(aliens.type[ai]).width / 2)
+        );
+        const int16_t y = static_cast<int16_t>(game.formation.y + aliens.y[ai] - bulletHeight);
+        if (spawnBullet(game.bullets, x, y, static_cast<int8_t>(-fire.speed), data::BULLET_ALIEN) == data::NO_BULLET) {
+            break;
+        }
+        ++fire.shots;
+    }
+}
+
+} // namespace
+
+void newGame(data::Game& game, size_t width, size_t height)
+{
+    game = data::Game{};
+    game.width = width;
+    game.height = height;
+
+    game.player.x = 112 - 5;
+    game.player.y = 32;
+
+    game.player.life = 3;
+
+    resetShields(game.shields, width, SHIELD_Y);
+
+    data::AlienFire& fire = game.fire;
+    fire.seed = FIRE_SEED;
+    fire.period = FIRE_PERIOD;
+    fire.timer = FIRE_PERIOD;
+    fire.volley = FIRE_VOLLEY;
+    fire.maxBullets = FIRE_MAX_BULLETS;
+    fire.speed = FIRE_SPEED;
+
+    const size_t numAliens = data::FORMATION_COLUMNS * data::FORMATION_ROWS;
+    data::Formation& formation = game.formation;
+    formation.x = FORMATION_X;
+    formation.y = FORMATION_Y;
+    formation.dir = 1;
+    formation.timer = marchPeriod(numAliens);
+    formation.left = 0;
+    formation.right = data::FORMATION_COLUMNS - 1;
+    formation.bottom = 0;
+    formation.top = data::FORMATION_ROWS - 1;
+    std::fill(formation.columnAlive, formation.columnAlive + data::FORMATION_COLUMNS, data::FORMATION_ROWS);
+    std::fill(formation.rowAlive, formation.rowAlive + data::FORMATION_ROWS, data::FORMATION_COLUMNS);
+
+    data::AlienStore& aliens = game.aliens;
+    aliens.count = numAliens;
+    aliens.numAlive = numAliens;
+    for (size_t yi = 0; yi < data::FORMATION_ROWS; ++yi) {
+        for (size_t xi = 0; xi < data::FORMATION_COLUMNS; ++xi) {
+            size_t ai = yi * data::FORMATION_COLUMNS + xi;
+            uint8_t type = static_cast<uint8_t>((data::FORMATION_ROWS - yi) / 2 + 1);
+
+            const data::Sprite& sprite = sprites::ALIEN_SPRITES[2 * (type - 1)];
+
+            aliens.x[ai] = static_cast<int16_t>(COLUMN_SPACING * xi + (sprites::ALIEN_DEATH_SPRITE.width - sprite.width) / 2);
+            aliens.y[ai] = static_cast<int16_t>(ROW_SPACING * yi);
+            aliens.type[ai] = type;
+            aliens.state[ai] = data::ALIEN_ALIVE;
+            aliens.deathTimer[ai] = 10;
+            aliens.phase[ai] = 0;
+            aliens.frame[ai] = sprites::ALIEN_ANIMATIONS[type - 1].ticks[0];
+            aliens.alive[ai] = static_cast<uint16_t>(ai);
+            aliens.aliveSlot[ai] = static_cast<uint16_t>(ai);
+        }
+    }
+}
+
+void buildAlienGrid(CollisionGrid& grid, const data::Game& game)
+{
+    const data::AlienStore& aliens = game.aliens;
+    grid.reset(game.width, game.height, GAME_MAX_ALIENS);
+    for (size_t i = 0; i < aliens.numAlive; ++i) {
+        size_t ai = aliens.alive[i];
+        data::Rectangle bounds = alienBounds(aliens.type[ai]);
+        grid.insert(ai, static_cast<size_t>(aliens.x[ai]), static_cast<size_t>(aliens.y[ai]),
+                    bounds.width, bounds.height);
+    }
+}
+
+data::Region formationBounds(const data::Game& game)
+{
+    const data::Formation& formation = game.formation;
+    if (!game.aliens.numAlive) {
+        return {};
+    }
+    const data::Rectangle cell = formationCell();
+    data::Region bounds;
+    bounds.x = static_cast<size_t>(formation.x + formation.left * COLUMN_SPACING);
+    bounds.y = static_cast<size_t>(formation.y + formation.bottom * ROW_SPACING);
+    bounds.width = (formation.right - formation.left) * COLUMN_SPACING + cell.width;
+    bounds.height = (formation.top - formation.bottom) * ROW_SPACING + cell.height;
+    return bounds;
+}
+
+size_t columnShooter(const data::Game& game, size_t column)
+{
+    const data::Formation& formation = game.formation;
+    if (column >= data::FORMATION_COLUMNS || !formation.columnAlive[column]) {
+        return game.aliens.count;
+    }
+    return formation.columnBottom[column] * data::FORMATION_COLUMNS + column;
+}
+
+void step(data::Game& game, const data::Input& input, CollisionGrid& grid)
+{
+    data::AlienStore& aliens = game.aliens;
+    data::BulletStore& bullets = game.bullets;
+
+    ++game.tick;
+
+    // Move every alien's animation on a tick and note the frame it shows,
+    // draws and hit tests then index the sprite tables with it directly
+    for (size_t ai = 0; ai < aliens.count; ++ai) {
+        const data::Animation& animation = sprites::ALIEN_ANIMATIONS[aliens.type[ai] - 1];
+        const uint8_t phase = data::nextPhase(animation, aliens.phase[ai]);
+        aliens.phase[ai] = phase;
+        aliens.frame[ai] = animation.ticks[phase];
+    }
+
+    // Count down explosions, written without branches so the loop
+    // vectorizes. ALIEN_DYING + 1 is ALIEN_GONE.
+    for (size_t ai = 0; ai < aliens.count; ++ai) {
+        uint8_t state = aliens.state[ai];
+        uint8_t timer = aliens.deathTimer[ai];
+        uint8_t dying = state == data::ALIEN_DYING;
+        timer = static_cast<uint8_t>(timer - (dying & (timer != 0)));
+        aliens.deathTimer[ai] = timer;
+        aliens.state[ai] = static_cast<uint8_t>(state + (dying & (timer == 0)));
+    }
+
+    march(game);
+
+    // Move every bullet in one pass and drop the ones off the screen
+    moveBullets(bullets, static_cast<ptrdiff_t>(sprites::BULLET_SPRITE.height), static_cast<ptrdiff_t>(game.height));
+
+    data::Region bounds = formationBounds(game);
+    data::Region playerBox;
+    playerBox.x = game.player.x;
+    playerBox.y = game.player.y;
+    playerBox.width = sprites::PLAYER_SPRITE.width;
+    playerBox.height = sprites::PLAYER_SPRITE.height;
+    const size_t formationX = static_cast<size_t>(game.formation.x);
+    const size_t formationY = static_cast<size_t>(game.formation.y);
+    for (size_t bi = 0; bi < bullets.count;) {
+        const size_t bulletX = static_cast<size_t>(bullets.x[bi]);
+        const size_t bulletY = static_cast<size_t>(bullets.y[bi]);
+        const size_t centerX = bulletX + sprites::BULLET_SPRITE.width / 2;
+        const size_t centerY = bulletY + sprites::BULLET_SPRITE.height / 2;
+
+        // A bullet that hits a shield blows a crater into it and is spent
+        const size_t shield = hitShield(game.shields, sprites::BULLET_MASK, bulletX, bulletY);
+        if (shield < data::SHIELD_COUNT) {
+            const data::PackedSprite& crater = sprites::SHIELD_CRATER_SPRITE_PACKED;
+            erodeShield(
+                game.shields, shield, crater,
+                centerX - crater.width / 2,
+                centerY - crater.height / 2
+            );
+            logImpact(game, centerX, centerY, bullets.dir[bi], data::IMPACT_SHIELD);
+            removeBullet(bullets, bi);
+            continue;
+        }
+
+        // Alien bullets only hit the player, and only where both have
+        // lit pixels. A hit costs a life.
+        if (bullets.owner[bi] == data::BULLET_ALIEN) {
+            if (game.player.life
+                && overlaps(playerBox, bulletX, bulletY, sprites::BULLET_SPRITE)
+                && data::masksOverlap(
+                    sprites::BULLET_MASK, bulletX, bulletY,
+                    sprites::PLAYER_MASK, game.player.x, game.player.y)) {
+                --game.player.life;
+                logImpact(game, centerX, centerY, bullets.dir[bi], data::IMPACT_PLAYER);
+                removeBullet(bullets, bi);
+                continue;
+            }
+            ++bi;
+            continue;
+        }
+
+        // Check for alien collision. Bullets outside the box of the living
+        // aliens hit none, others are looked up in the grid, in formation
+        // coordinates, and only hit where both have lit pixels. Of several
+        // the lowest numbered alien is hit.
+        if (!overlaps(bounds, bulletX, bulletY, sprites::BULLET_SPRITE)) {
+            ++bi;
+            continue;
+        }
+        size_t hit = aliens.count;
+        grid.query(
+            bulletX - formationX, bulletY - formationY,
+            sprites::BULLET_SPRITE.width, sprites::BULLET_SPRITE.height,
+            [&](size_t ai) {
+                const size_t alienX = formationX + aliens.x[ai];
+                const size_t alienY = formationY + aliens.y[ai];
+                const uint8_t frame = aliens.frame[ai];
+                if (ai < hit
+                    && util::spriteOverlapCheck(
+                        sprites::BULLET_SPRITE, bulletX, bulletY,
+                        sprites::ALIEN_SPRITES[frame], alienX, alienY)
+                    && data::masksOverlap(
+                        sprites::BULLET_MASK, bulletX, bulletY,
+                        sprites::ALIEN_MASKS[frame], alienX, alienY)) {
+                    hit = ai;
+                }
+            }
+        );
+
+        if (hit < aliens.count) {
+            const data::Sprite& alienSprite = sprites::ALIEN_SPRITES[aliens.frame[hit]];
+            game.score += 10 * (4 - aliens.type[hit]);
+            logImpact(
+                game,
+                formationX + aliens.x[hit] + alienSprite.width / 2,
+                formationY + aliens.y[hit] + alienSprite.height / 2,
+                bullets.dir[bi], data::IMPACT_ALIEN, aliens.type[hit]
+            );
+            aliens.x[hit] = static_cast<int16_t>(
+                aliens.x[hit] - static_cast<int16_t>((sprites::ALIEN_DEATH_SPRITE.width - alienSprite.width) / 2)
+            );
+            killAlien(game, hit);
+            bounds = formationBounds(game);
+            grid.remove(hit);
+
+            // The bullet is spent, the last one takes its slot and is
+            // handled next without advancing bi
+            removeBullet(bullets, bi);
+            continue;
+        }
+
+        ++bi;
+    }
+
+    int playerMoveDir = 2 * input.moveDir;
+
+    if (playerMoveDir != 0) {
+        if (game.player.x + sprites::PLAYER_SPRITE.width + playerMoveDir >= game.width) {
+            game.player.x = game.width - sprites::PLAYER_SPRITE.width;
+        } else if ((int)game.player.x + playerMoveDir <= 0) {
+            game.player.x = 0;
+        } else {
+            game.player.x += playerMoveDir;
+        }
+    }
+
+    if (input.fire) {
+        spawnBullet(
+            bullets,
+            static_cast<int16_t>(game.player.x + sprites::PLAYER_SPRITE.width / 2),
+            static_cast<int16_t>(game.player.y + sprites::PLAYER_SPRITE.height),
+            2, data::BULLET_PLAYER
+        );
+    }
+
+    fireAliens(game);
+}
+
+void interpolate(const data::Game& previous, const data::Game& current, double alpha, data::Game& out)
+{
+    out = current;
+    if (alpha >= 1.0) {
+        return;
+    }
+
+    // Aliens only move with the formation, a drop snaps to current
+    if (previous.formation.y == current.formation.y) {
+        out.formation.x = lerp(previous.formation.x, current.formation.x, alpha);
+    }
+
+    out.player.x = lerp(previous.player.x, current.player.x, alpha);
+    out.player.y = lerp(previous.player.y, current.player.y, alpha);
+
+    // Bullets are matched to the previous snapshot by handle. One fired
+    // since then had no earlier position, it is drawn where it is now,
+    // moved along with the blended player or formation that fired it.
+    const ptrdiff_t playerShift = static_cast<ptrdiff_t>(out.player.x) - static_cast<ptrdiff_t>(current.player.x);
+    const ptrdiff_t formationShift = out.formation.x - current.formation.x;
+    const data::BulletStore& bullets = current.bullets;
+    for (size_t bi = 0; bi < bullets.count; ++bi) {
+        const size_t pi = findBullet(previous.bullets, bulletHandle(bullets, bi));
+        if (pi < previous.bullets.count) {
+            out.bullets.x[bi] = lerp(previous.bullets.x[pi], bullets.x[bi], alpha);
+            out.bullets.y[bi] = lerp(previous.bullets.y[pi], bullets.y[bi], alpha);
+        } else {
+            const ptrdiff_t shift = bullets.owner[bi] == data::BULLET_PLAYER ? playerShift : formationShift;
+            out.bullets.x[bi] = static_cast<int16_t>(bullets.x[bi] + shift);
+        }
+    }
+}
+
+} // sim
@@ -0,0 +1,351 @@
+#include "render/gl_presenter.hpp"
+#include <cstdio>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "render/texture_upload.hpp"
+#include "util/gl_utility.hpp"
+
+namespace render {
+
+namespace {
+
+const char* VERTEX_SHADER =
+    "\n"
+    "#version 330\n"
+    "\n"
+    "noperspective out vec2 TexCoord;\n"
+    "\n"
+    "void main(void){\n"
+    "\n"
+    "    TexCoord.x = (gl_VertexID == 2) ? 2.0 : 0.0;\n"
+    "    TexCoord.y = (gl_VertexID == 1) ? 2.0 : 0.0;\n"
+    "    \n"
+    "    gl_Position = vec4(2.0 * TexCoord - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+const char* FRAGMENT_SHADER_RGBA =
+    "\n"
+    "#version 330\n"
+    "\n"
+    "uniform sampler2D buffer;\n"
+    "noperspective in vec2 TexCoord;\n"
+    "\n"
+    "out vec3 outColor;\n"
+    "\n"
+    "void main(void) {\n"
+    "    outColor = texture(buffer, TexCoord).rgb;\n"
+    "}\n";
+
+const char* FRAGMENT_SHADER_INDEXED =
+    "\n"
+    "#version 330\n"
+    "\n"
+    "uniform usampler2D buffer;\n"
+    "uniform sampler2D palette;\n"
+    "uniform ivec2 bufferSize;\n"
+    "noperspective in vec2 TexCoord;\n"
+    "\n"
+    "out vec3 outColor;\n"
+    "\n"
+    "void main(void) {\n"
+    "    ivec2 pixel = min(ivec2(TexCoord * vec2(bufferSize)), bufferSize - 1);\n"
+    "    uint index = texelFetch(buffer, pixel, 0).r;\n"
+    "    outColor = texelFetch(palette, ivec2(int(index), 0), 0).rgb;\n"
+    "}\n";
+
+const char* FRAGMENT_SHADER_MONO =
+    "\n"
+    "#version 330\n"
+    "\n"
+    "uniform usampler2D buffer;\n"
+    "uniform sampler2D palette;\n"
+    "uniform ivec2 bufferSize;\n"
+    "noperspective in vec2 TexCoord;\n"
+    "\n"
+    "out vec3 outColor;\n"
+    "\n"
+    "void main(void) {\n"
+    "    ivec2 pixel = min(ivec2(TexCoord * vec2(bufferSize)), bufferSize - 1);\n"
+    "    uint word = texelFetch(buffer, ivec2(pixel.x / 32, pixel.y), 0).r;\n"
+    "    uint index = (word >> uint(pixel.x % 32)) & 1u;\n"
+    "    outColor = texelFetch(palette, ivec2(int(index), 0), 0).rgb;\n"
+    "}\n";
+
+/**
+ * @brief Presenter drawing the buffer as a fullscreen triangle in a GLFW window.
+ *
+ * @var window Window and context frames are shown in.
+ * @var controls Writer key events go to while events are polled.
+ * @var quit Whether escape was pressed.
+ * @var textureFormat Layout of bufferTexture.
+ * @var bufferTexture Texture holding the presented buffer.
+ * @var paletteTexture Texture compact formats are expanded through.
+ * @var paletteVersion Palette version last uploaded to paletteTexture.
+ * @var vao Empty vertex array the fullscreen triangle is drawn with.
+ * @var program Shader program for the buffer's format.
+ * @var uploader Uploads damaged regions into bufferTexture.
+ */
+class GlPresenter: public Presenter
+{
+public:
+    GlPresenter(GLFWwindow* window)
+        : window(window)
+    {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, keyCallback);
+    }
+
+    ~GlPresenter() override
+    {
+        if (uploader) {
+            const UploadStats& stats = uploader->getStats();
+            if (stats.frames) {
+                printf("Uploaded %zu frames: %.1f us average, %.1f us max, %.1f KiB average, %zu busy slots\n",
+                       stats.frames,
+                       stats.totalMicros / stats.frames,
+                       stats.maxMicros,
+                       stats.bytes / 1024.0 / stats.frames,
+                       stats.busySlots);
+            }
+        }
+
+        // GL objects go while the context still exists
+        uploader.reset();
+        glDeleteProgram(program);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteTextures(1, &bufferTexture);
+        glDeleteTextures(1, &paletteTexture);
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    /**
+     * @brief Creates the textures, shader and uploader for a buffer.
+     *
+     * @param buffer Buffer that will be presented.
+     * @param uploadRing Whether to upload through a ring of pixel buffers.
+     * @return bool True if the shader compiled and linked.
+     */
+    bool initialize(data::Buffer& buffer, bool uploadRing)
+    {
+        glClearColor(1.0, 0.0, 0.0, 1.0);
+
+        // Damaged regions are staged in a fenced ring of pixel buffers, or
+        // uploaded straight out of the full buffer with --upload=direct
+        textureFormat = textureFormatFor(buffer, uploadRing);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        // Create texture for presenting buffer to OpenGL
+        glGenTextures(1, &bufferTexture);
+        glBindTexture(GL_TEXTURE_2D, bufferTexture);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, textureFormat.internalFormat,
+            textureFormat.width, buffer.getHeight(), 0,
+            textureFormat.format, textureFormat.type, NULL
+        );
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        uploader = std::make_unique<TextureUploader>(buffer, textureFormat, uploadRing);
+        const char* uploadModes[] = {"direct", "streamed PBO ring", "persistent PBO ring"};
+        printf("Upload: %s, %s\n", uploadModes[uploader->getMode()],
+               textureFormat.argb ? "BGRA 8_8_8_8_REV" : "native layout");
+
+        // Create palette texture compact formats are expanded through
+        glGenTextures(1, &paletteTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, paletteTexture);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0,
+            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.getPalette()
+        );
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        paletteVersion = buffer.getPaletteVersion();
+        glActiveTexture(GL_TEXTURE0);
+
+        // Create vao for generating fullscreen triangle
+        glGenVertexArrays(1, &vao);
+
+        // Create shader for displaying buffer
+        const char* fragmentShaders[] = {FRAGMENT_SHADER_RGBA, FRAGMENT_SHADER_INDEXED, FRAGMENT_SHADER_MONO};
+        const char* fragmentShader = fragmentShaders[buffer.getFormat()];
+
+        program = glCreateProgram();
+        // Create vertex shader
+        {
+            GLuint shaderVp = glCreateShader(GL_VERTEX_SHADER);
+
+            glShaderSource(shaderVp, 1, &VERTEX_SHADER, 0);
+            glCompileShader(shaderVp);
+            util::validateShader(shaderVp, VERTEX_SHADER);
+            glAttachShader(program, shaderVp);
+
+            glDeleteShader(shaderVp);
+        }
+
+        // Create fragment shader
+        {
+            GLuint shaderFp = glCreateShader(GL_FRAGMENT_SHADER);
+
+            glShaderSource(shaderFp, 1, &fragmentShader, 0);
+            glCompileShader(shaderFp);
+            util::validateShader(shaderFp, fragmentShader);
+            glAttachShader(program, shaderFp);
+
+            glDeleteShader(shaderFp);
+        }
+
+        glLinkProgram(program);
+
+        if (!util::validateProgram(program)) {
+            fprintf(stderr, "Error while validating shader.\n");
+            return false;
+        }
+
+        glUseProgram(program);
+
+        GLint location = glGetUniformLocation(program, "buffer");
+        glUniform1i(location, 0);
+        location = glGetUniformLocation(program, "palette");
+        glUniform1i(location, 1);
+        location = glGetUniformLocation(program, "bufferSize");
+        glUniform2i(location, buffer.getWidth(), buffer.getHeight());
+
+        // OpenGL setup
+        glDisable(GL_DEPTH_TEST);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(vao);
+        return true;
+    }
+
+    void present(data::Buffer& buffer, const std::vector<data::Region>& damage) override
+    {
+        if (paletteVersion != buffer.getPaletteVersion()) {
+            paletteVersion = buffer.getPaletteVersion();
+            glActiveTexture(GL_TEXTURE1);
+            glTexSubImage2D(
+                GL_TEXTURE_2D, 0, 0, 0, 256, 1,
+                GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.getPalette()
+            );
+            glActiveTexture(GL_TEXTURE0);
+        }
+
+        // Only upload what changed, nothing at all if the frame is identical
+        uploader->upload(buffer, damage);
+
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        glfwSwapBuffers(window);
+    }
+
+    bool pollInput(sim::ControlWriter& controls) override
+    {
+        // The key callback runs within glfwPollEvents
+        this->controls = &controls;
+        glfwPollEvents();
+        this->controls = nullptr;
+        return !quit && !glfwWindowShouldClose(window);
+    }
+
+private:
+    static void keyCallback(GLFWwindow* window,
+                            int key,
+                            [[maybe_unused]] int scancode,
+                            int action,
+                            [[maybe_unused]] int mods)
+    {
+        GlPresenter* presenter = static_cast<GlPresenter*>(glfwGetWindowUserPointer(window));
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+            presenter->quit = true;
+        }
+        // Key repeats change nothing, holding a key is already seen
+        if (!presenter->controls || (action != GLFW_PRESS && action != GLFW_RELEASE)) {
+            return;
+        }
+
+        const int64_t time = sim::inputClock();
+        const bool pressed = action == GLFW_PRESS;
+        switch (key) {
+            case GLFW_KEY_RIGHT:
+                presenter->controls->send(sim::CONTROL_RIGHT, pressed, time);
+                break;
+            case GLFW_KEY_LEFT:
+                presenter->controls->send(sim::CONTROL_LEFT, pressed, time);
+                break;
+            case GLFW_KEY_BACKSPACE:
+                presenter->controls->send(sim::CONTROL_REWIND, pressed, time);
+                break;
+            case GLFW_KEY_SPACE:
+                // Fire on the press, waiting for the release only adds lag
+                presenter->controls->send(sim::CONTROL_FIRE, pressed, time);
+                break;
+            default:
+                break;
+        }
+    }
+
+    GLFWwindow* window;
+    sim::ControlWriter* controls = nullptr;
+    bool quit = false;
+    TextureFormat textureFormat{};
+    GLuint bufferTexture = 0;
+    GLuint paletteTexture = 0;
+    size_t paletteVersion = 0;
+    GLuint vao = 0;
+    GLuint program = 0;
+    std::unique_ptr<TextureUploader> uploader;
+};
+
+} // namespace
+
+std::unique_ptr<Presenter> createGlPresenter(data::Buffer& buffer, bool uploadRing)
+{
+    glfwSetErrorCallback(util::errorCallback);
+
+    if (!glfwInit()) {
+        return nullptr;
+    }
+
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    GLFWwindow* window = glfwCreateWindow(
+        2 * buffer.getWidth(), 2 * buffer.getHeight(), "Space Invaders", NULL, NULL
+    );
+    if (!window) {
+        glfwTerminate();
+        return nullptr;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    GLenum err = glewInit();
+    if (err != GLEW_OK) {
+        fprintf(stderr, "Error initializing GLEW.\n");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    int glVersion[2] = {-1, 1};
+    glGetIntegerv(GL_MAJOR_VERSION, &glVersion[0]);
+    glGetIntegerv(GL_MINOR_VERSION, &glVersion[1]);
+    printf("Using OpenGL: %d.%d\n", glVersion[0], glVersion[1]);
+    printf("Renderer used: %s\n", glGetString(GL_RENDERER));
+    printf("Shading Language: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
+
+    glfwSwapInterval(1);
+
+    auto presenter = std::make_unique<GlPresenter>(window);
+    if (!presenter->initialize(buffer, uploadRing)) {
+        return nullptr;
+    }
+    return presenter;
+}
+
+} // render
@@ -0,0 +1,39 @@
+#include "util/gl_utility.hpp"
+#include <cstdio>
+
+namespace util {
+
+void validateShader(GLuint shader, const char* file)
+{
+    static const unsigned int BUFFER_SIZE = 512;
+    char buffer[BUFFER_SIZE];
+    GLsizei length = 0;
+
+    glGetShaderInfoLog(shader, BUFFER_SIZE, &length, buffer);
+
+    if (length > 0) {
+        printf("Shader %d(%s) compile error: %s\n",
+               shader, (file ? file : ""), buffer);
+    }
+}
+
+bool validateProgram(GLuint program)
+{
+    static const GLsizei BUFFER_SIZE = 512;
+    GLchar buffer[BUFFER_SIZE];
+    GLsizei length = 0;
+
+    glGetProgramInfoLog(program, BUFFER_SIZE, &length, buffer);
+    if (length > 0) {
+        printf("Program %d link error: %s\n", program, buffer);
+        return false;
+    }
+    return true;
+}
+
+void errorCallback(int error, const char* description)
+{
+    fprintf(stderr, "Error %d: %s\n", error, description);
+}
+
+} // util
@@ -0,0 +1,45 @@
+#include "render/headless_presenter.hpp"
+#include <cstdio>
+#include "render/frame_file.hpp"
+
+namespace render {
+
+HeadlessPresenter::HeadlessPresenter(const std::string& dumpDir, size_t dumpEvery)
+    : dumpDir(dumpDir), dumpEvery(dumpEvery ? dumpEvery : 1)
+{
+}
+
+void HeadlessPresenter::present(data::Buffer& buffer, [[maybe_unused]] const std::vector<data::Region>& damage)
+{
+    if (!dumpDir.empty() && frames % dumpEvery == 0) {
+        dump(buffer);
+    }
+    ++frames;
+}
+
+bool HeadlessPresenter::pollInput(sim::ControlWriter& controls)
+{
+    // Turn around every 96 frames and fire every 12
+    data::Input input{};
+    input.moveDir = (frames / 96) % 2 ? -1 : 1;
+    input.fire = frames % 12 == 0;
+    controls.send(input, sim::inputClock());
+    return true;
+}
+
+void HeadlessPresenter::dump(data::Buffer& buffer)
+{
+    const size_t width = buffer.getWidth();
+    const size_t height = buffer.getHeight();
+    pixels.resize(width * height);
+    buffer.expand(pixels.data(), width, {{0, 0}, {width, height}});
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/frame_%06zu.ppm", dumpDir.c_str(), frames);
+    if (!writePpm(path, pixels.data(), width, height)) {
+        fprintf(stderr, "Error writing %s.\n", path);
+        dumpDir.clear();
+    }
+}
+
+} // render
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace data::blit {
+
+/**
+ * @brief Expands bit-packed sprite rows into 32-bit color stores.
+ * @details Bit xi of a row selects pixel xi. Each row is shifted right by
+ *          shift and masked with mask before it is expanded, which lets the
+ *          caller clip the sprite horizontally. Only pixels whose bit is set
+ *          are written, nothing outside the first count pixels of a row is
+ *          read or written. The implementation is picked at runtime from the
+ *          instruction sets supported by the CPU.
+ *
+ * @param dst Pixel the first visible bit of the first row maps to.
+ * @param dstStride Distance in pixels between consecutive rows in dst.
+ * @param rows Packed rows to draw.
+ * @param numRows Number of rows to draw.
+ * @param shift Number of clipped columns on the left of every row.
+ * @param mask Mask of the visible bits after shifting.
+ * @param count Number of visible pixels in a row.
+ * @param color 32-bit RGBA color value for the set pixels.
+ */
+void packedRows(
+    uint32_t* dst, ptrdiff_t dstStride,
+    const uint16_t* rows, size_t numRows,
+    unsigned shift, uint16_t mask, size_t count,
+    uint32_t color
+);
+
+/**
+ * @brief Expands 8-bit palette indices into 32-bit colors.
+ *
+ * @param src Palette indices to expand.
+ * @param count Number of pixels to expand.
+ * @param palette Palette of 256 32-bit RGBA colors.
+ * @param dst Output pixels, count colors are written.
+ */
+void expandIndexed8(
+    const uint8_t* src, size_t count,
+    const uint32_t* palette, uint32_t* dst
+);
+
+/**
+ * @brief Expands 1-bit pixels into 32-bit colors.
+ * @details Pixel i of a row is bit (i % 32) of word i / 32. Words past the
+ *          one holding the last expanded pixel are never read.
+ *
+ * @param src Words of the row to expand.
+ * @param firstBit Index of the first pixel to expand.
+ * @param count Number of pixels to expand.
+ * @param palette Colors of clear (index 0) and set (index 1) pixels.
+ * @param dst Output pixels, count colors are written.
+ */
+void expandMono1(
+    const uint32_t* src, size_t firstBit, size_t count,
+    const uint32_t* palette, uint32_t* dst
+);
+
+/**
+ * @brief Copies 32-bit RGBA colors converting them to ARGB.
+ * @details 0xRRGGBBAA becomes 0xAARRGGBB, the layout GL reads as
+ *          GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV.
+ *
+ * @param src Colors to convert.
+ * @param count Number of pixels to convert.
+ * @param dst Output pixels, count colors are written.
+ */
+void copyToArgb(const uint32_t* src, size_t count, uint32_t* dst);
+
+/**
+ * @brief Gets the name of the instruction set used by the blit functions.
+ *
+ * @return const char* "AVX2", "SSE2" or "scalar".
+ */
+const char* isaName();
+
+} // data::blit
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data/data.hpp"
+
+namespace data {
+
+/**
+ * @brief Lit pixels of a sprite as rows of bits, for exact collisions.
+ * @details Bit xi % 64 of word xi / 64 of a row is set when pixel xi of the
+ *          row is lit. Rows are stored bottom up like the buffer, so row yi
+ *          covers y + yi for a mask at y. Every row is followed by a clear
+ *          word, which lets overlap tests read one word past the last
+ *          without checking. Pixels can be cleared and set after
+ *          construction. Masks own their rows on the heap, so state that
+ *          has to live in data::Game, like the shields, keeps packed rows
+ *          instead and is tested against the rows of a mask, see
+ *          sim::hitShield.
+ *
+ * @inherit Rectangle
+ *    - width: Width of the mask.
+ *    - height: Height of the mask.
+ *
+ * @var words Number of words holding the pixels of a row.
+ * @var bits Rows of the mask, words + 1 words each.
+ */
+class CollisionMask final: public Rectangle
+{
+public:
+    /**
+     * @brief Constructs an empty 0x0 mask.
+     */
+    CollisionMask();
+
+    /**
+     * @brief Constructs a mask with every pixel clear.
+     *
+     * @param width Width of the mask.
+     * @param height Height of the mask.
+     */
+    CollisionMask(size_t width, size_t height);
+
+    /**
+     * @brief Constructs the mask of a sprite's lit pixels.
+     *
+     * @param sprite Sprite whose pixels are read, first row at the top.
+     */
+    explicit CollisionMask(const Sprite& sprite);
+
+    /**
+     * @brief Gets the words of a row.
+     *
+     * @param yi Row, counted from the bottom.
+     * @return const uint64_t* Words of the row followed by a clear word.
+     */
+    const uint64_t* getRow(size_t yi) const
+    {
+        return bits.data() + yi * (words + 1);
+    }
+
+    /**
+     * @brief Gets the number of words holding the pixels of a row.
+     */
+    size_t getWords() const
+    {
+        return words;
+    }
+
+    /**
+     * @brief Checks whether a pixel is lit.
+     *
+     * @param xi Column of the pixel.
+     * @param yi Row of the pixel, counted from the bottom.
+     */
+    bool test(size_t xi, size_t yi) const
+    {
+        return getRow(yi)[xi / 64] >> (xi % 64) & 1;
+    }
+
+    /**
+     * @brief Lights or clears a pixel.
+     *
+     * @param xi Column of the pixel.
+     * @param yi Row of the pixel, counted from the bottom.
+     * @param lit True to light the pixel, false to clear it.
+     */
+    void set(size_t xi, size_t yi, bool lit);
+
+private:
+    size_t words;
+    std::vector<uint64_t> bits;
+};
+
+/**
+ * @brief Checks whether any lit pixels of two masks overlap.
+ * @details Meant as the narrow phase after a bounding box test passed,
+ *          but gives the right answer for masks that do not touch too.
+ *          Each overlapping row costs a shift and an AND for masks up to
+ *          64 pixels wide, wider masks compare two words per instruction
+ *          where SSE2 is available. Positions may have wrapped below 0.
+ *
+ * @param maskA First mask.
+ * @param xA X-coordinate of the first mask's left column.
+ * @param yA Y-coordinate of the first mask's bottom row.
+ * @param maskB Second mask.
+ * @param xB X-coordinate of the second mask's left column.
+ * @param yB Y-coordinate of the second mask's bottom row.
+ * @return bool True if a pixel is lit in both masks.
+ */
+bool masksOverlap(
+    const CollisionMask& maskA, size_t xA, size_t yA,
+    const CollisionMask& maskB, size_t xB, size_t yB
+);
+
+} // data
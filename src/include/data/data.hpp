@@ -1,12 +1,23 @@
 #pragma once
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <vector>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include "data/blit.hpp"
 
 namespace data {
 
+// Both limits may be raised from the build, see CollisionGrid
+#ifndef GAME_MAX_BULLETS
 #define GAME_MAX_BULLETS 128
+#endif
+#ifndef GAME_MAX_ALIENS
+#define GAME_MAX_ALIENS 55
+#endif
 
 /**
  * @brief Represents a rectangular shape with width and height.
@@ -30,6 +41,184 @@ struct Location {
     size_t y;
 };
 
+/**
+ * @brief Represents a rectangular area at a 2D position.
+ * @details Inherits from Location and Rectangle.
+ *
+ * @inherit Location
+ *    - x: X-coordinate of the first column of the area.
+ *    - y: Y-coordinate of the first row of the area.
+ *
+ * @inherit Rectangle
+ *    - width: Width of the area.
+ *    - height: Height of the area.
+ */
+struct Region final: Location, Rectangle
+{
+};
+
+/**
+ * @brief Maximum number of regions collectDamage hands out per frame.
+ */
+constexpr size_t MAX_DAMAGE_REGIONS = 32;
+
+/**
+ * @brief Extra pixels two regions may waste and still be merged into one.
+ */
+constexpr size_t DAMAGE_MERGE_SLACK = 64;
+
+/**
+ * @brief Computes the smallest region containing two regions.
+ *
+ * @param a First region.
+ * @param b Second region.
+ * @return Region Bounding region of a and b.
+ */
+inline Region unite(const Region& a, const Region& b)
+{
+    size_t x0 = std::min(a.x, b.x);
+    size_t y0 = std::min(a.y, b.y);
+    size_t x1 = std::max(a.x + a.width, b.x + b.width);
+    size_t y1 = std::max(a.y + a.height, b.y + b.height);
+    return {{x0, y0}, {x1 - x0, y1 - y0}};
+}
+
+/**
+ * @brief Number of merged regions a region is compared with, see mergeRegions.
+ */
+constexpr size_t DAMAGE_MERGE_WINDOW = 8;
+
+/**
+ * @brief Height of the bands regions are ordered in before they are
+ *        paired up, see mergeRegions.
+ */
+constexpr size_t DAMAGE_BAND_HEIGHT = 16;
+
+/**
+ * @brief Width of the tiles scattered points are marked damaged in, which
+ *        are DAMAGE_BAND_HEIGHT rows high, see Buffer::plotPoints.
+ */
+constexpr size_t DAMAGE_TILE_WIDTH = 32;
+
+/**
+ * @brief Gets the pixels the bounding region of two regions wastes.
+ *
+ * @param a First region.
+ * @param b Second region.
+ * @return size_t Area of the bounding region beyond the areas of a and b,
+ *         0 if they overlap by more than that.
+ */
+inline size_t mergeWaste(const Region& a, const Region& b)
+{
+    Region bounds = unite(a, b);
+    size_t area = bounds.width * bounds.height;
+    return area - std::min(area, a.width * a.height + b.width * b.height);
+}
+
+/**
+ * @brief Merges regions that are close together into fewer larger regions.
+ * @details The regions are sorted by rows and merged in a single sweep,
+ *          each one into the first of the DAMAGE_MERGE_WINDOW latest
+ *          merged regions whose bounding region with it wastes at most
+ *          DAMAGE_MERGE_SLACK pixels. While more than twice
+ *          MAX_DAMAGE_REGIONS remain, they are ordered by bands of
+ *          DAMAGE_BAND_HEIGHT rows and left to right, and neighbours are
+ *          merged in pairs. Once at most twice the limit are left, the
+ *          pairs that waste the fewest pixels are merged until the limit
+ *          is met. The cost is O(n log n) in the number of regions, the
+ *          last step only ever looks at a bounded number.
+ *
+ * @param regions Regions to merge in place.
+ */
+inline void mergeRegions(std::vector<Region>& regions)
+{
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    size_t merged = 0;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        size_t into = merged;
+        for (size_t k = merged; k > 0 && merged - k < DAMAGE_MERGE_WINDOW; --k) {
+            if (mergeWaste(regions[k - 1], regions[i]) <= DAMAGE_MERGE_SLACK) {
+                into = k - 1;
+                break;
+            }
+        }
+        if (into < merged) {
+            regions[into] = unite(regions[into], regions[i]);
+        } else {
+            regions[merged++] = regions[i];
+        }
+    }
+    regions.resize(merged);
+
+    // Far too many left, halve them by merging neighbours
+    while (regions.size() > 2 * MAX_DAMAGE_REGIONS) {
+        std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) {
+            size_t bandA = a.y / DAMAGE_BAND_HEIGHT;
+            size_t bandB = b.y / DAMAGE_BAND_HEIGHT;
+            return bandA != bandB ? bandA < bandB : a.x < b.x;
+        });
+        size_t kept = 0;
+        for (size_t i = 0; i < regions.size(); i += 2) {
+            regions[kept++] = i + 1 < regions.size() ? unite(regions[i], regions[i + 1]) : regions[i];
+        }
+        regions.resize(kept);
+    }
+
+    // Still too many, keep merging the pair that wastes the fewest pixels.
+    // Every region keeps the partner it wastes the fewest pixels with, so
+    // a merge only looks again at the regions whose partner went away.
+    std::array<size_t, 2 * MAX_DAMAGE_REGIONS> partner;
+    std::array<size_t, 2 * MAX_DAMAGE_REGIONS> waste;
+    auto findPartner = [&](size_t i) {
+        waste[i] = SIZE_MAX;
+        for (size_t j = 0; j < regions.size(); ++j) {
+            size_t w = j == i ? SIZE_MAX : mergeWaste(regions[i], regions[j]);
+            if (w < waste[i]) {
+                waste[i] = w;
+                partner[i] = j;
+            }
+        }
+    };
+    if (regions.size() > MAX_DAMAGE_REGIONS) {
+        for (size_t i = 0; i < regions.size(); ++i) {
+            findPartner(i);
+        }
+    }
+    while (regions.size() > MAX_DAMAGE_REGIONS) {
+        size_t best = 0;
+        for (size_t i = 1; i < regions.size(); ++i) {
+            if (waste[i] < waste[best]) {
+                best = i;
+            }
+        }
+        const size_t i = std::min(best, partner[best]);
+        const size_t j = std::max(best, partner[best]);
+        const size_t last = regions.size() - 1;
+        regions[i] = unite(regions[i], regions[j]);
+        regions[j] = regions[last];
+        partner[j] = partner[last];
+        waste[j] = waste[last];
+        regions.pop_back();
+
+        for (size_t k = 0; k < regions.size(); ++k) {
+            if (k == i || partner[k] == i || partner[k] == j) {
+                findPartner(k);
+                continue;
+            }
+            if (partner[k] == last) {
+                partner[k] = j;
+            }
+            size_t w = mergeWaste(regions[k], regions[i]);
+            if (w < waste[k]) {
+                waste[k] = w;
+                partner[k] = i;
+            }
+        }
+    }
+}
+
 /**
  * @brief A sprite with a specified width, height, and pixel data.
  * @details Inherits from Rectangle and adds sprite-specific pixel data.
@@ -46,20 +235,183 @@ struct Sprite final: Rectangle
 };
 
 /**
- * @brief Represents an alien entity with position and type information.
- * @details Inherits from Location and adds alien type information.
+ * @brief A horizontal run of lit pixels within one row of a sprite.
  *
- * @inherit Location
- *    - x: X-coordinate position of the alien.
- *    - y: Y-coordinate position of the alien.
+ * @var x Column of the first lit pixel in the run.
+ * @var length Number of consecutive lit pixels.
+ */
+struct Span {
+    uint16_t x;
+    uint16_t length;
+};
+
+/**
+ * @brief Run-length encoded form of a Sprite.
+ * @details Each row of the sprite is stored as a list of spans of lit
+ *          pixels, so drawing only touches pixels that are actually set.
+ *
+ * @inherit Rectangle
+ *    - width: Width of the sprite.
+ *    - height: Height of the sprite.
  *
- * @var type Type of the alien (see AlienType enum).
+ * @var source Pixel data the spans were compiled from.
+ * @var spans Spans of all rows, ordered by row and then by column.
+ * @var rowStart Index of the first span of each row; rowStart[height] is
+ *               the total number of spans.
  */
-struct Alien final: Location
+struct SpanSprite final: Rectangle
 {
-    uint8_t type;
+    const uint8_t* source;
+    std::vector<Span> spans;
+    std::vector<uint32_t> rowStart;
+};
+
+/**
+ * @brief Compiles a sprite into its run-length encoded span form.
+ *
+ * @param sprite The sprite to compile.
+ * @return SpanSprite Spans of lit pixels for every row of the sprite.
+ */
+inline SpanSprite compileSpans(const Sprite& sprite)
+{
+    SpanSprite compiled;
+    compiled.width = sprite.width;
+    compiled.height = sprite.height;
+    compiled.source = sprite.data;
+    compiled.rowStart.reserve(sprite.height + 1);
+
+    for (size_t yi = 0; yi < sprite.height; ++yi) {
+        compiled.rowStart.push_back(compiled.spans.size());
+        const uint8_t* row = sprite.data + yi * sprite.width;
+        size_t xi = 0;
+        while (xi < sprite.width) {
+            if (!row[xi]) {
+                ++xi;
+                continue;
+            }
+            size_t start = xi;
+            while (xi < sprite.width && row[xi]) {
+                ++xi;
+            }
+            compiled.spans.push_back({
+                static_cast<uint16_t>(start),
+                static_cast<uint16_t>(xi - start)
+            });
+        }
+    }
+    compiled.rowStart.push_back(compiled.spans.size());
+
+    return compiled;
+}
+
+/**
+ * @brief Maximum width of a sprite that can be stored in packed form.
+ */
+constexpr size_t PACKED_MAX_WIDTH = 16;
+
+/**
+ * @brief A sprite stored with one bit per pixel.
+ * @details Each row is a single 16-bit word where bit xi is set when pixel
+ *          xi of that row is lit. Sheets of glyphs store the rows of every
+ *          glyph one after another.
+ *
+ * @inherit Rectangle
+ *    - width: Width of the sprite, at most PACKED_MAX_WIDTH.
+ *    - height: Height of the sprite.
+ *
+ * @var rows Pointer to the packed rows of the sprite.
+ */
+struct PackedSprite final: Rectangle
+{
+    const uint16_t* rows;
 };
 
+/**
+ * @brief Packs byte-per-pixel sprite data into one bit per pixel at compile time.
+ *
+ * @tparam Width Width of the sprite in pixels.
+ * @tparam Height Height of the sprite in pixels.
+ * @tparam Count Number of sprites stored back to back in pixels.
+ * @param pixels Byte-per-pixel sprite data, Width * Height * Count bytes.
+ * @return std::array<uint16_t, Height * Count> The packed rows.
+ */
+template <size_t Width, size_t Height, size_t Count = 1>
+constexpr std::array<uint16_t, Height * Count> packSprite(const uint8_t* pixels)
+{
+    static_assert(Width <= PACKED_MAX_WIDTH, "Sprite is too wide to be packed");
+
+    std::array<uint16_t, Height * Count> rows{};
+    for (size_t row = 0; row < Height * Count; ++row) {
+        uint16_t bits = 0;
+        for (size_t xi = 0; xi < Width; ++xi) {
+            if (pixels[row * Width + xi]) {
+                bits |= static_cast<uint16_t>(1u << xi);
+            }
+        }
+        rows[row] = bits;
+    }
+    return rows;
+}
+
+/**
+ * @brief Packs a sprite of any width into banks of packed columns.
+ * @details Bank bi holds columns PACKED_MAX_WIDTH * bi onward, a row per
+ *          16-bit word like packSprite, so every bank can be drawn as a
+ *          PackedSprite. Banks are stored one after another.
+ *
+ * @tparam Width Width of the sprite in pixels.
+ * @tparam Height Height of the sprite in pixels.
+ * @param pixels Byte-per-pixel sprite data, Width * Height bytes.
+ * @return std::array<uint16_t, Banks * Height> The packed banks.
+ */
+template <size_t Width, size_t Height>
+constexpr std::array<uint16_t, (Width + PACKED_MAX_WIDTH - 1) / PACKED_MAX_WIDTH * Height>
+packBanks(const uint8_t* pixels)
+{
+    std::array<uint16_t, (Width + PACKED_MAX_WIDTH - 1) / PACKED_MAX_WIDTH * Height> rows{};
+    for (size_t row = 0; row < Height; ++row) {
+        for (size_t xi = 0; xi < Width; ++xi) {
+            if (pixels[row * Width + xi]) {
+                rows[xi / PACKED_MAX_WIDTH * Height + row] |= static_cast<uint16_t>(1u << (xi % PACKED_MAX_WIDTH));
+            }
+        }
+    }
+    return rows;
+}
+
+/**
+ * @brief Number of entity slots, rounded up so loops over whole stores
+ *        run in full vector widths and stores pack without padding.
+ */
+constexpr size_t ALIEN_CAPACITY = (GAME_MAX_ALIENS + 7) / 8 * 8;
+constexpr size_t BULLET_CAPACITY = (GAME_MAX_BULLETS + 7) / 8 * 8;
+
+static_assert(ALIEN_CAPACITY <= 65536, "Alien numbers must fit 16 bits");
+static_assert(BULLET_CAPACITY <= 65536, "Bullet slots must fit 16 bits");
+
+/**
+ * @brief Columns and rows of the alien formation.
+ */
+constexpr size_t FORMATION_COLUMNS = 11;
+constexpr size_t FORMATION_ROWS = 5;
+
+static_assert(ALIEN_CAPACITY >= FORMATION_COLUMNS * FORMATION_ROWS, "The formation must fit the alien store");
+
+/**
+ * @brief Number and size of the shields in front of the player.
+ */
+constexpr size_t SHIELD_COUNT = 4;
+constexpr size_t SHIELD_WIDTH = 22;
+constexpr size_t SHIELD_HEIGHT = 16;
+constexpr size_t SHIELD_BANKS = (SHIELD_WIDTH + PACKED_MAX_WIDTH - 1) / PACKED_MAX_WIDTH;
+
+static_assert(SHIELD_WIDTH <= 32, "Shield rows must fit a 32-bit word");
+
+/**
+ * @brief Number of latest impacts a game keeps, see ImpactLog.
+ */
+constexpr size_t IMPACT_LOG_SIZE = 16;
+
 /**
  * @brief Represents the player entity with position and life information.
  * @details Inherits from Location and adds player-specific attributes.
@@ -76,77 +428,484 @@ struct Player final: Location
 };
 
 /**
- * @brief Represents a bullet entity with position and direction information.
- * @details Inherits from Location and adds bullet-specific attributes.
+ * @brief Every alien of a game, one array per attribute.
+ * @details Alien ai is described by entry ai of every array. It sits in
+ *          row ai / FORMATION_COLUMNS and column ai % FORMATION_COLUMNS
+ *          of the formation, row 0 at the bottom. Coordinates are 16-bit
+ *          and signed offsets from the formation's origin, so the whole
+ *          formation moves by moving the origin. Aliens keep their
+ *          number for the whole game, dead ones stay in the store to
+ *          play their explosion and alive lists the numbers of the living
+ *          ones, in no particular order.
  *
- * @inherit Location
- *    - x: X-coordinate position of the bullet.
- *    - y: Y-coordinate position of the bullet.
+ * @var count Number of aliens in the game, living or not.
+ * @var numAlive Number of entries of alive in use.
+ * @var x Offset of each alien's left column from the formation's x.
+ * @var y Offset of each alien's bottom row from the formation's y.
+ * @var alive Numbers of the living aliens.
+ * @var aliveSlot Entry of alive holding each living alien.
+ * @var type Type of each alien (see AlienType enum).
+ * @var state Whether each alien lives (see AlienState enum).
+ * @var deathTimer Steps left to show each dying alien's explosion.
+ * @var phase Tick each alien is at in the animation of its type.
+ * @var frame Sprite each alien shows, an index into ALIEN_SPRITES and
+ *      ALIEN_MASKS, updated from phase once per step.
+ */
+struct AlienStore {
+    size_t count;
+    size_t numAlive;
+    int16_t x[ALIEN_CAPACITY];
+    int16_t y[ALIEN_CAPACITY];
+    uint16_t alive[ALIEN_CAPACITY];
+    uint16_t aliveSlot[ALIEN_CAPACITY];
+    uint8_t type[ALIEN_CAPACITY];
+    uint8_t state[ALIEN_CAPACITY];
+    uint8_t deathTimer[ALIEN_CAPACITY];
+    uint8_t phase[ALIEN_CAPACITY];
+    uint8_t frame[ALIEN_CAPACITY];
+};
+
+/**
+ * @brief Position of the alien formation and what is left of it.
+ * @details The formation marches sideways and drops down a row at the
+ *          screen's edges. The counts are kept up to date as aliens die,
+ *          so the living extents and the lowest alien of a column are
+ *          known without looking at the aliens. Rows and columns with no
+ *          living alien left have a count of 0.
  *
- * @var dir Direction of the bullet (-1 for up, 1 for down typically).
+ * @var x X-coordinate of the formation's origin.
+ * @var y Y-coordinate of the formation's origin.
+ * @var dir Direction of the march, -1 left or 1 right.
+ * @var timer Steps until the next march step.
+ * @var marches Number of march steps taken.
+ * @var left First column with a living alien.
+ * @var right Last column with a living alien.
+ * @var bottom Lowest row with a living alien.
+ * @var top Highest row with a living alien.
+ * @var columnAlive Number of living aliens in each column.
+ * @var columnBottom Lowest row with a living alien of each column.
+ * @var rowAlive Number of living aliens in each row.
  */
-struct Bullet final: Location
-{
-    int dir;
+struct Formation {
+    int16_t x;
+    int16_t y;
+    int16_t dir;
+    uint16_t timer;
+    uint16_t marches;
+    uint16_t left;
+    uint16_t right;
+    uint16_t bottom;
+    uint16_t top;
+    uint16_t columnAlive[FORMATION_COLUMNS];
+    uint16_t columnBottom[FORMATION_COLUMNS];
+    uint16_t rowAlive[FORMATION_ROWS];
+};
+
+/**
+ * @brief Names a bullet for as long as it is in flight.
+ * @details The slot of the bullet in the low 16 bits and the generation
+ *          of the slot in the high 16 bits. A slot's generation changes
+ *          every time it is handed out, so the handle of a spent bullet
+ *          never names the bullet that reuses its slot.
+ */
+using BulletHandle = uint32_t;
+
+/**
+ * @brief Handle naming no bullet.
+ */
+constexpr BulletHandle NO_BULLET = 0;
+
+/**
+ * @brief Every bullet in flight, one array per attribute, as a pool.
+ * @details The first count entries of the per bullet arrays are in use,
+ *          so moving every bullet is one pass over packed arrays. A spent
+ *          bullet is replaced by the last one. Handles name slots instead
+ *          of entries, every slot knows the entry of its bullet, so
+ *          handles stay valid while other bullets come and go. Slots are
+ *          handed out in order and spent ones are reused, last spent
+ *          first, from a free list threaded through index. Nothing is
+ *          allocated, a zeroed store is empty.
+ *
+ * @var count Number of bullets in flight.
+ * @var numAlien Number of bullets in flight fired by aliens.
+ * @var numSlots Number of slots handed out at least once.
+ * @var numFree Number of slots on the free list.
+ * @var freeSlot First slot on the free list, if numFree is not 0.
+ * @var x X-coordinate of each bullet.
+ * @var y Y-coordinate of each bullet's bottom row.
+ * @var slot Slot of each bullet.
+ * @var index Entry of the bullet in each used slot, the next slot on the
+ *      free list for free ones.
+ * @var generation Generation of each slot, never 0 once handed out.
+ * @var dir Distance each bullet moves up per step, negative moves down.
+ * @var owner Who fired each bullet (see BulletOwner enum).
+ */
+struct BulletStore {
+    size_t count;
+    size_t numAlien;
+    size_t numSlots;
+    size_t numFree;
+    size_t freeSlot;
+    int16_t x[BULLET_CAPACITY];
+    int16_t y[BULLET_CAPACITY];
+    uint16_t slot[BULLET_CAPACITY];
+    uint16_t index[BULLET_CAPACITY];
+    uint16_t generation[BULLET_CAPACITY];
+    int8_t dir[BULLET_CAPACITY];
+    uint8_t owner[BULLET_CAPACITY];
+};
+
+/**
+ * @brief When and how the aliens fire.
+ * @details Every period steps a volley of shots leaves from random
+ *          columns of the formation, each from the column's lowest living
+ *          alien, as long as fewer than maxBullets alien bullets are in
+ *          flight. The columns are drawn from seed, so a game fires the
+ *          same way every time it is played the same way.
+ *
+ * @var seed State of the generator columns are drawn from.
+ * @var timer Steps until the next volley.
+ * @var period Steps from one volley to the next.
+ * @var volley Shots per volley.
+ * @var maxBullets Most alien bullets in flight at once.
+ * @var speed Distance alien bullets move down per step.
+ * @var shots Number of shots fired so far, wrapping around.
+ */
+struct AlienFire {
+    uint32_t seed;
+    uint16_t timer;
+    uint16_t period;
+    uint16_t volley;
+    uint16_t maxBullets;
+    uint16_t speed;
+    uint16_t shots;
+};
+
+/**
+ * @brief Something hit, for effects to pick up.
+ *
+ * @var x X-coordinate of the center of the impact.
+ * @var y Y-coordinate of the center of the impact.
+ * @var dir Distance per step and direction the bullet moved up,
+ *      negative if it moved down.
+ * @var kind What was hit (see ImpactKind enum).
+ * @var type Type of the alien killed, 0 for other impacts.
+ */
+struct Impact {
+    int16_t x;
+    int16_t y;
+    int16_t dir;
+    uint8_t kind;
+    uint8_t type;
+};
+
+/**
+ * @brief The latest impacts of a game, as a ring.
+ * @details Impact i, counted from 0 since the game started, is kept in
+ *          entry i % IMPACT_LOG_SIZE until IMPACT_LOG_SIZE later ones
+ *          overwrite it. The game only writes, whoever shows the impacts
+ *          remembers how many it has seen, so none are missed however
+ *          many steps pass between two looks as long as the ring does
+ *          not wrap. A count lower than the one seen means the game went
+ *          back in time.
+ *
+ * @var count Number of impacts since the game started.
+ * @var entries The latest impacts.
+ */
+struct ImpactLog {
+    uint64_t count;
+    Impact entries[IMPACT_LOG_SIZE];
+};
+
+/**
+ * @brief The shields and what is left of them, one bit per pixel.
+ * @details Each shield is stored in SHIELD_BANKS banks of packed rows as
+ *          made by packBanks, top row first, so every bank can be drawn
+ *          and tested as a PackedSprite as it is. A cleared bit is a
+ *          pixel shot away.
+ *
+ * @var x X-coordinate of each shield's left column.
+ * @var y Y-coordinate of each shield's bottom row.
+ * @var rows Packed rows of each bank of each shield.
+ */
+struct ShieldStore {
+    int16_t x[SHIELD_COUNT];
+    int16_t y[SHIELD_COUNT];
+    uint16_t rows[SHIELD_COUNT][SHIELD_BANKS][SHIELD_HEIGHT];
 };
 
 /**
  * @brief Represents the main game state with dimensions and game entities.
- * @details Inherits from Rectangle and contains all game entities and state information.
+ * @details Inherits from Rectangle and contains all game entities and state
+ *          information. Holds no pointers and no padding, so copying it is
+ *          a memcpy and its bytes can be hashed or compared as they are.
  *
  * @inherit Rectangle
  *    - width: Width of the game area.
  *    - height: Height of the game area.
  *
- * @var numAliens Number of active aliens.
- * @var numBullets Number of active bullets.
- * @var aliens Pointer to array of alien entities.
  * @var player The player entity.
- * @var bullets Array of bullet entities, limited by GAME_MAX_BULLETS.
+ * @var score Points scored so far.
+ * @var tick Number of simulation steps taken.
+ * @var formation Where the aliens are and which of them are left.
+ * @var fire When and how the aliens fire.
+ * @var aliens Every alien, at most GAME_MAX_ALIENS.
+ * @var bullets Bullets in flight, at most GAME_MAX_BULLETS.
+ * @var shields The shields, eroded by every hit.
+ * @var impacts The latest things hit, for effects. Nothing in the game
+ *      reads it, so sim::hashGame leaves it out.
  */
 struct Game final: Rectangle
 {
-    size_t numAliens;
-    size_t numBullets;
-    Alien* aliens;
     Player player;
-    Bullet bullets[GAME_MAX_BULLETS];
+    size_t score;
+    size_t tick;
+    Formation formation;
+    AlienFire fire;
+    AlienStore aliens;
+    BulletStore bullets;
+    ShieldStore shields;
+    ImpactLog impacts;
+};
+
+static_assert(std::is_trivially_copyable_v<Game>, "Game must copy with memcpy");
+static_assert(std::has_unique_object_representations_v<Game>, "Game must not contain padding");
+
+/**
+ * @brief Player input for one step of the game.
+ *
+ * @var moveDir Direction the player is held in, -1 left, 1 right, 0 none.
+ * @var fire Whether fire was pressed since the previous step.
+ * @var quit Whether the game should stop.
+ * @var rewind Whether time is held to run backwards.
+ */
+struct Input {
+    int moveDir;
+    bool fire;
+    bool quit;
+    bool rewind;
 };
 
 /**
- * @brief Represents an animation sequence for sprites.
+ * @brief Longest animation in ticks, see Animation.
+ */
+constexpr size_t MAX_ANIMATION_TICKS = 64;
+
+/**
+ * @brief Frames an animation shows, laid out tick by tick.
+ * @details Built at compile time by makeAnimation and never changed, so
+ *          one table serves every game. Each entity keeps its own phase,
+ *          an index into ticks, and moves it on with nextPhase once per
+ *          game tick. Starting entities at different phases offsets
+ *          their animations. The frame of a phase is a single load,
+ *          nothing is divided.
  *
- * @var loop Whether the animation should loop.
- * @var numFrames Number of frames in the animation.
- * @var frameDuration Duration of each frame in time units.
- * @var time Current time position in the animation.
- * @var frames Array of pointers to sprite frames.
+ * @var loop Whether the phase starts over after the last tick, otherwise
+ *      it stays on the last one.
+ * @var period Number of ticks the animation lasts.
+ * @var ticks Frame shown on each tick, an index into the sprite table of
+ *      the entity.
  */
-struct SpriteAnimation
+struct Animation
 {
     bool loop;
-    size_t numFrames;
-    size_t frameDuration;
-    size_t time;
-    Sprite** frames;
+    uint8_t period;
+    uint8_t ticks[MAX_ANIMATION_TICKS];
 };
 
+/**
+ * @brief Lays out an animation tick by tick.
+ * @details Animations longer than MAX_ANIMATION_TICKS do not compile.
+ *
+ * @param frames Frames in the order they are shown.
+ * @param frameDuration Ticks each frame is shown for.
+ * @param loop Whether the animation starts over after the last frame.
+ * @return Animation The table.
+ */
+constexpr Animation makeAnimation(std::initializer_list<uint8_t> frames, size_t frameDuration, bool loop = true)
+{
+    Animation animation{loop, static_cast<uint8_t>(frames.size() * frameDuration), {}};
+    size_t tick = 0;
+    for (uint8_t frame : frames) {
+        for (size_t ti = 0; ti < frameDuration; ++ti) {
+            animation.ticks[tick++] = frame;
+        }
+    }
+    return animation;
+}
+
+/**
+ * @brief Moves the phase of an animation on by one tick.
+ *
+ * @param animation Animation the phase is in.
+ * @param phase Phase to move on, below animation.period.
+ * @return uint8_t Phase of the next tick.
+ */
+constexpr uint8_t nextPhase(const Animation& animation, uint8_t phase)
+{
+    const uint8_t next = static_cast<uint8_t>(phase + 1);
+    return next < animation.period ? next : animation.loop ? 0 : phase;
+}
+
 /**
  * @brief Enumeration of alien types in the game.
  *
- * @var ALIEN_DEAD Dead alien (inactive).
  * @var ALIEN_TYPE_A Alien of type A.
  * @var ALIEN_TYPE_B Alien of type B.
  * @var ALIEN_TYPE_C Alien of type C.
  */
 enum AlienType: uint8_t
 {
-    ALIEN_DEAD   = 0,
     ALIEN_TYPE_A = 1,
     ALIEN_TYPE_B = 2,
     ALIEN_TYPE_C = 3
 };
 
+/**
+ * @brief Enumeration of who fired a bullet.
+ *
+ * @var BULLET_PLAYER Fired up by the player, hits aliens.
+ * @var BULLET_ALIEN Fired down by an alien, hits the player.
+ */
+enum BulletOwner: uint8_t
+{
+    BULLET_PLAYER = 1,
+    BULLET_ALIEN  = 2
+};
+
+/**
+ * @brief Enumeration of what an impact hit.
+ *
+ * @var IMPACT_ALIEN A player bullet killed an alien.
+ * @var IMPACT_SHIELD A bullet blew a crater into a shield.
+ * @var IMPACT_PLAYER An alien bullet hit the player.
+ */
+enum ImpactKind: uint8_t
+{
+    IMPACT_ALIEN  = 1,
+    IMPACT_SHIELD = 2,
+    IMPACT_PLAYER = 3
+};
+
+/**
+ * @brief Enumeration of the stages of an alien's life.
+ *
+ * @var ALIEN_ALIVE Alien can move and be hit.
+ * @var ALIEN_DYING Alien was hit and shows its explosion.
+ * @var ALIEN_GONE Alien's explosion is over, nothing is drawn.
+ */
+enum AlienState: uint8_t
+{
+    ALIEN_ALIVE = 0,
+    ALIEN_DYING = 1,
+    ALIEN_GONE  = 2
+};
+
+/**
+ * @brief Gets a single glyph out of a spritesheet.
+ *
+ * @param sheet Spritesheet holding glyphs back to back.
+ * @param index Index of the glyph in the sheet.
+ * @return Sprite The glyph as a sprite of the sheet's size.
+ */
+inline Sprite glyph(const Sprite& sheet, size_t index)
+{
+    Sprite sprite = sheet;
+    sprite.data = sheet.data + index * sheet.width * sheet.height;
+    return sprite;
+}
+
+/**
+ * @brief Gets a single glyph out of a packed spritesheet.
+ *
+ * @param sheet Packed spritesheet holding glyph rows back to back.
+ * @param index Index of the glyph in the sheet.
+ * @return PackedSprite The glyph as a packed sprite of the sheet's size.
+ */
+inline PackedSprite glyph(const PackedSprite& sheet, size_t index)
+{
+    PackedSprite sprite = sheet;
+    sprite.rows = sheet.rows + index * sheet.height;
+    return sprite;
+}
+
+/**
+ * @brief Lays out a string of glyphs from a text spritesheet.
+ * @details The sheet starts at the space character and holds 65 glyphs,
+ *          characters outside of it are skipped.
+ *
+ * @tparam SpriteSheet Sprite or PackedSprite.
+ * @tparam GlyphFn Callable taking the glyph and its x-coordinate.
+ * @param textSpritesheet Sprite containing character glyphs.
+ * @param text Null-terminated string to lay out.
+ * @param x X-coordinate position of the first glyph.
+ * @param draw Called for every glyph in order.
+ */
+template <typename SpriteSheet, typename GlyphFn>
+void layoutText(
+    const SpriteSheet& textSpritesheet,
+    const char* text, size_t x,
+    GlyphFn&& draw
+){
+    size_t xp = x;
+    for (const char* charp = text; *charp != '\0'; ++charp) {
+        char character = *charp - 32;
+        if (character < 0 || character >= 65) {
+            continue;
+        }
+        draw(glyph(textSpritesheet, character), xp);
+        xp += textSpritesheet.width + 1;
+    }
+}
+
+/**
+ * @brief Lays out the decimal digits of a number from a number spritesheet.
+ *
+ * @tparam SpriteSheet Sprite or PackedSprite.
+ * @tparam GlyphFn Callable taking the glyph and its x-coordinate.
+ * @param numberSpritesheet Sprite containing digit glyphs (0-9).
+ * @param number The number to lay out.
+ * @param x X-coordinate position of the first digit.
+ * @param draw Called for every digit, most significant first.
+ */
+template <typename SpriteSheet, typename GlyphFn>
+void layoutNumber(
+    const SpriteSheet& numberSpritesheet,
+    size_t number, size_t x,
+    GlyphFn&& draw
+){
+    uint8_t digits[64];
+    size_t num_digits = 0;
+
+    size_t current_number = number;
+    do {
+        digits[num_digits++] = current_number % 10;
+        current_number = current_number / 10;
+    } while (current_number > 0);
+
+    size_t xp = x;
+    for (size_t i = 0; i < num_digits; ++i) {
+        uint8_t digit = digits[num_digits - i - 1];
+        draw(glyph(numberSpritesheet, digit), xp);
+        xp += numberSpritesheet.width + 1;
+    }
+}
+
+/**
+ * @brief Enumeration of the pixel formats a Buffer can store.
+ *
+ * @var FORMAT_RGBA32 One 32-bit RGBA color per pixel.
+ * @var FORMAT_INDEXED8 One byte per pixel indexing a palette of up to 256 colors.
+ * @var FORMAT_MONO1 One bit per pixel selecting one of two palette colors,
+ *      like the framebuffer of the original cabinet.
+ */
+enum PixelFormat: uint8_t
+{
+    FORMAT_RGBA32   = 0,
+    FORMAT_INDEXED8 = 1,
+    FORMAT_MONO1    = 2
+};
+
 /**
  * @brief A buffer of pixel data with a specified width and height.
  * @details Inherits from Rectangle and adds pixel data storage.
@@ -156,6 +915,20 @@ enum AlienType: uint8_t
  *    - height: Height of the buffer.
  *
  * @var data Pointer to pixel data of the buffer.
+ *
+ * @details Every draw records the area it touched. clearDamaged only clears
+ *          what was drawn since the previous clear and collectDamage reports
+ *          the merged areas that changed, so unchanged parts of the screen
+ *          are neither cleared nor uploaded again.
+ *
+ *          Content that rarely changes can be cached as a background
+ *          layer. Moving sprites are then drawn over it and the areas
+ *          they covered are restored from the cache by restoreDamaged.
+ *
+ *          Compact formats store palette indices instead of colors. Draw
+ *          calls still take RGBA colors, which are mapped to the palette,
+ *          and expand converts the buffer back to RGBA for presentation.
+ *          Every row starts on a 32-bit word boundary in every format.
  */
 class Buffer
 {
@@ -165,10 +938,28 @@ public:
      *
      * @param width Width of the buffer in pixels.
      * @param height Height of the buffer in pixels.
+     * @param format Pixel format of the buffer.
      */
-    Buffer(size_t width, size_t height) : width(width), height(height)
+    Buffer(size_t width, size_t height, PixelFormat format = FORMAT_RGBA32)
+        : width(width), height(height), format(format)
     {
-        data = std::vector<uint32_t>(width * height, 0);
+        switch (format) {
+            case FORMAT_RGBA32:
+                stride = width;
+                break;
+            case FORMAT_INDEXED8:
+                stride = (width + 3) / 4;
+                break;
+            case FORMAT_MONO1:
+                stride = (width + 31) / 32;
+                break;
+        }
+        data = std::vector<uint32_t>(stride * height, 0);
+        palette.fill(0);
+        damage.reserve(256);
+        cleared.reserve(256);
+        plotTilesX = (width + DAMAGE_TILE_WIDTH - 1) / DAMAGE_TILE_WIDTH;
+        plotTiles.assign(plotTilesX * ((height + DAMAGE_BAND_HEIGHT - 1) / DAMAGE_BAND_HEIGHT), PlotTile{});
     }
 
     /**
@@ -196,6 +987,96 @@ public:
         return height;
     }
 
+    /**
+     * @brief Gets the pixel format of the buffer.
+     *
+     * @return PixelFormat Format the pixels are stored in.
+     */
+    PixelFormat getFormat()
+    {
+        return format;
+    }
+
+    /**
+     * @brief Gets the distance between the starts of two rows.
+     *
+     * @return Number of 32-bit words per row.
+     */
+    size_t getStride()
+    {
+        return stride;
+    }
+
+    /**
+     * @brief Gets the palette of a compact buffer.
+     *
+     * @return const uint32_t* The 256 RGBA palette entries, unused ones are 0.
+     */
+    const uint32_t* getPalette()
+    {
+        return palette.data();
+    }
+
+    /**
+     * @brief Gets a counter that changes whenever the palette changes.
+     *
+     * @return size_t Version of the palette.
+     */
+    size_t getPaletteVersion()
+    {
+        return paletteVersion;
+    }
+
+    /**
+     * @brief Replaces the palette of a compact buffer.
+     * @details Colors that are drawn but not part of the palette are added
+     *          while there is room. Once the palette is full they map to the
+     *          last entry. A 1-bit buffer has room for two colors, index 0
+     *          being the background.
+     *
+     * @param colors 32-bit RGBA colors of the palette.
+     */
+    void setPalette(const std::vector<uint32_t>& colors)
+    {
+        palette.fill(0);
+        paletteSize = std::min(colors.size(), paletteCapacity());
+        std::copy_n(colors.begin(), paletteSize, palette.begin());
+        lastColor = palette[0];
+        lastIndex = 0;
+        ++paletteVersion;
+    }
+
+    /**
+     * @brief Expands an area of the buffer into 32-bit RGBA colors.
+     * @details RGBA buffers are copied as is, compact buffers go through
+     *          the palette using vector instructions where available.
+     *
+     * @param out Output image with the same dimensions as the buffer.
+     * @param outStride Distance between two rows of out in pixels.
+     * @param region Area of the buffer to expand.
+     */
+    void expand(uint32_t* out, size_t outStride, const Region& region)
+    {
+        for (size_t yi = region.y; yi < region.y + region.height; ++yi) {
+            const uint32_t* row = data.data() + yi * stride;
+            uint32_t* dst = out + yi * outStride + region.x;
+            switch (format) {
+                case FORMAT_RGBA32:
+                    std::copy_n(row + region.x, region.width, dst);
+                    break;
+                case FORMAT_INDEXED8:
+                    blit::expandIndexed8(
+                        reinterpret_cast<const uint8_t*>(row) + region.x,
+                        region.width, palette.data(), dst
+                    );
+                    break;
+                case FORMAT_MONO1:
+                    blit::expandMono1(row, region.x, region.width, palette.data(), dst);
+                    break;
+            }
+        }
+    }
+
     /**
      * @brief Gets a pointer to the raw pixel data.
      *
@@ -223,11 +1104,240 @@ public:
      */
     void clear(uint32_t color)
     {
-        std::fill(data.begin(), data.end(), color);
+        uint32_t value = pixelValue(color);
+        switch (format) {
+            case FORMAT_RGBA32:
+                std::fill(data.begin(), data.end(), value);
+                break;
+            case FORMAT_INDEXED8:
+                std::fill(data.begin(), data.end(), value * 0x01010101u);
+                break;
+            case FORMAT_MONO1:
+                std::fill(data.begin(), data.end(), value ? ~0u : 0u);
+                break;
+        }
+        clearColor = color;
+        fullDamage = true;
+        damage.clear();
+        cleared.clear();
+    }
+
+    /**
+     * @brief Clears only the areas drawn since the previous clear.
+     * @details Falls back to a full clear when the color differs from the
+     *          one the rest of the buffer was cleared with.
+     *
+     * @param color 32-bit RGBA color value to clear with.
+     */
+    void clearDamaged(uint32_t color)
+    {
+        if (fullDamage || color != clearColor) {
+            clear(color);
+            return;
+        }
+
+        uint32_t value = pixelValue(color);
+        for (const Region& region : damage) {
+            for (size_t yi = region.y; yi < region.y + region.height; ++yi) {
+                fillRow(yi, region.x, region.x + region.width, value);
+            }
+        }
+        cleared.insert(cleared.end(), damage.begin(), damage.end());
+        damage.clear();
+    }
+
+    /**
+     * @brief Saves the current content as the static background layer.
+     * @details Draw everything that does not move, then cache it. Until
+     *          the layer is invalidated, restoreDamaged copies it back under
+     *          the moving sprites instead of redrawing it every frame.
+     */
+    void cacheBackground()
+    {
+        background.assign(data.begin(), data.end());
+        backgroundValid = true;
+        // Still uploaded, but there is nothing to restore under it
+        cleared.insert(cleared.end(), damage.begin(), damage.end());
+        damage.clear();
+    }
+
+    /**
+     * @brief Saves an area of the current content into the background layer.
+     * @details Cheaper than caching everything when only a small part of
+     *          the background changed. Like cacheBackground it must be
+     *          called before moving sprites are drawn.
+     *          Requires a cached background.
+     *
+     * @param region Area to save.
+     */
+    void cacheBackground(const Region& region)
+    {
+        copyWords(data, background, region);
+        cleared.insert(cleared.end(), damage.begin(), damage.end());
+        damage.clear();
+    }
+
+    /**
+     * @brief Drops the cached background layer after its content changed.
+     */
+    void invalidateBackground()
+    {
+        backgroundValid = false;
+    }
+
+    /**
+     * @brief Checks whether a background layer is cached.
+     *
+     * @return true if restoreDamaged may be used.
+     */
+    bool hasBackground() const
+    {
+        return backgroundValid;
+    }
+
+    /**
+     * @brief Restores the areas drawn since the previous restore from the
+     *        background layer.
+     * @details Requires a cached background, see cacheBackground.
+     */
+    void restoreDamaged()
+    {
+        for (const Region& region : damage) {
+            copyWords(background, data, region);
+        }
+        cleared.insert(cleared.end(), damage.begin(), damage.end());
+        damage.clear();
+    }
+
+    /**
+     * @brief Marks an area of the buffer as changed.
+     * @details Call this after writing to getData or getVector directly.
+     *          The area is clipped against the buffer.
+     *
+     * @param x X-coordinate of the first column of the area.
+     * @param y Y-coordinate of the first row of the area.
+     * @param areaWidth Width of the area.
+     * @param areaHeight Height of the area.
+     */
+    void markDamaged(size_t x, size_t y, size_t areaWidth, size_t areaHeight)
+    {
+        if (x >= width || y >= height) {
+            return;
+        }
+        areaWidth = std::min(areaWidth, width - x);
+        areaHeight = std::min(areaHeight, height - y);
+        if (areaWidth && areaHeight) {
+            damage.push_back({{x, y}, {areaWidth, areaHeight}});
+        }
+    }
+
+    /**
+     * @brief Collects the areas that changed since the previous call.
+     * @details This is everything cleared by clearDamaged plus everything
+     *          drawn since, merged into at most MAX_DAMAGE_REGIONS regions.
+     *          The result is empty when nothing changed.
+     *
+     * @return const std::vector<Region>& Regions that need to be presented.
+     */
+    const std::vector<Region>& collectDamage()
+    {
+        changed.clear();
+        if (fullDamage) {
+            changed.push_back({{0, 0}, {width, height}});
+            fullDamage = false;
+        } else {
+            changed.insert(changed.end(), cleared.begin(), cleared.end());
+            changed.insert(changed.end(), damage.begin(), damage.end());
+            mergeRegions(changed);
+        }
+        cleared.clear();
+        return changed;
+    }
+
+    /**
+     * @brief Collects the areas that changed since the previous call, unmerged.
+     * @details Like collectDamage, but hands out every cleared and drawn
+     *          area as it is, which may be many overlapping regions. Much
+     *          cheaper when the caller reads the regions itself instead of
+     *          uploading them.
+     *
+     * @return const std::vector<Region>& Regions that changed.
+     */
+    const std::vector<Region>& collectRawDamage()
+    {
+        changed.clear();
+        if (fullDamage) {
+            changed.push_back({{0, 0}, {width, height}});
+            fullDamage = false;
+        } else {
+            changed.insert(changed.end(), cleared.begin(), cleared.end());
+            changed.insert(changed.end(), damage.begin(), damage.end());
+        }
+        cleared.clear();
+        return changed;
+    }
+
+    /**
+     * @brief Fills a rectangular area with a color.
+     *
+     * @param x X-coordinate of the first column of the area.
+     * @param y Y-coordinate of the first row of the area.
+     * @param areaWidth Width of the area.
+     * @param areaHeight Height of the area.
+     * @param color 32-bit RGBA color value to fill with.
+     */
+    void fillRect(
+        size_t x, size_t y,
+        size_t areaWidth, size_t areaHeight,
+        uint32_t color
+    ){
+        markDamaged(x, y, areaWidth, areaHeight);
+        rasterRect(x, y, areaWidth, areaHeight, pixelValue(color), 0, height);
+    }
+
+    /**
+     * @brief Sets single pixels, one per pair of coordinates.
+     * @details Points outside the buffer are skipped, so coordinates that
+     *          wrapped below zero need no clipping. The buffer is cut into
+     *          tiles of DAMAGE_TILE_WIDTH by DAMAGE_BAND_HEIGHT pixels and
+     *          the box around the points in each tile is marked damaged,
+     *          so scattered bursts do not damage the screen between them.
+     *
+     * @param xs X-coordinate of each point.
+     * @param ys Y-coordinate of each point.
+     * @param count Number of points.
+     * @param color 32-bit RGBA color value for the points.
+     */
+    void plotPoints(const uint16_t* xs, const uint16_t* ys, size_t count, uint32_t color)
+    {
+        const uint32_t value = pixelValue(color);
+        switch (format) {
+            case FORMAT_RGBA32:
+                plotEach(xs, ys, count, [&](size_t x, size_t y) {
+                    data[y * stride + x] = value;
+                });
+                break;
+            case FORMAT_INDEXED8: {
+                uint8_t* bytes = reinterpret_cast<uint8_t*>(data.data());
+                plotEach(xs, ys, count, [&](size_t x, size_t y) {
+                    bytes[y * stride * 4 + x] = static_cast<uint8_t>(value);
+                });
+                break;
+            }
+            case FORMAT_MONO1:
+                plotEach(xs, ys, count, [&](size_t x, size_t y) {
+                    uint32_t& word = data[y * stride + x / 32];
+                    const uint32_t bit = 1u << (x % 32);
+                    word = value ? word | bit : word & ~bit;
+                });
+                break;
+        }
     }
 
     /**
      * @brief Draws a sprite onto the buffer at a specified position.
+     * @details The sprite is compiled into spans the first time it is drawn
+     *          and the compiled form is reused on later calls.
      *
      * @param sprite The sprite to draw.
      * @param x X-coordinate position to draw the sprite.
@@ -238,85 +1348,525 @@ public:
         const Sprite& sprite,
         size_t x, size_t y, uint32_t color
     ){
-        for (size_t xi = 0; xi < sprite.width; ++xi) {
-            for (size_t yi = 0; yi < sprite.height; ++yi) {
-                size_t sy = sprite.height - 1 + y - yi;
-                size_t sx = x + xi;
-                if (sprite.data[yi * sprite.width + xi]
-                    && sy < height && sx < width) {
-                    data[sy * width + sx] = color;
+        drawSpans(spansFor(sprite), x, y, color);
+    }
+
+    /**
+     * @brief Draws a span compiled sprite onto the buffer.
+     * @details The sprite rectangle is clipped against the buffer once and
+     *          every visible span is filled with a contiguous store. The
+     *          first sprite row is drawn at the top, so sprite row yi lands
+     *          on buffer row y + height - 1 - yi.
+     *
+     * @param sprite The compiled sprite to draw.
+     * @param x X-coordinate position to draw the sprite.
+     * @param y Y-coordinate position to draw the sprite.
+     * @param color 32-bit RGBA color value for the sprite pixels.
+     */
+    void drawSpans(
+        const SpanSprite& sprite,
+        size_t x, size_t y, uint32_t color
+    ){
+        markDamaged(sprite, x, y);
+        rasterSpans(sprite, x, y, pixelValue(color), 0, height);
+    }
+
+    /**
+     * @brief Draws a bit-packed sprite onto the buffer at a specified position.
+     * @details Every row is expanded from its bit mask with vector stores
+     *          when the CPU supports them, see blit::packedRows.
+     *
+     * @param sprite The packed sprite to draw.
+     * @param x X-coordinate position to draw the sprite.
+     * @param y Y-coordinate position to draw the sprite.
+     * @param color 32-bit RGBA color value for the sprite pixels.
+     */
+    void drawSprite(
+        const PackedSprite& sprite,
+        size_t x, size_t y, uint32_t color
+    ){
+        markDamaged(sprite, x, y);
+        rasterPacked(sprite, x, y, pixelValue(color), 0, height);
+    }
+
+    /**
+     * @brief Converts a color into the value stored for it in the buffer.
+     * @details The raster functions take this value instead of a color.
+     *          Compact buffers may add the color to their palette, so this
+     *          must not be called concurrently.
+     *
+     * @param color 32-bit RGBA color value.
+     * @return uint32_t The color for RGBA buffers, its palette index otherwise.
+     */
+    uint32_t mapColor(uint32_t color)
+    {
+        return pixelValue(color);
+    }
+
+    /**
+     * @brief Looks up the compiled spans of a sprite, compiling them on first use.
+     * @details The returned reference stays valid for the buffer's lifetime.
+     *          Must not be called concurrently.
+     *
+     * @param sprite The sprite to look up.
+     * @return const SpanSprite& The cached span form of the sprite.
+     */
+    const SpanSprite& spansFor(const Sprite& sprite)
+    {
+        SpanSprite& compiled = spanCache[sprite.data];
+        if (compiled.source != sprite.data
+            || compiled.width != sprite.width
+            || compiled.height != sprite.height) {
+            compiled = compileSpans(sprite);
+        }
+        return compiled;
+    }
+
+    /**
+     * @brief Marks the visible part of a sprite drawn at a position as changed.
+     *
+     * @param sprite Rectangle of the sprite.
+     * @param x X-coordinate position of the sprite.
+     * @param y Y-coordinate position of the sprite.
+     */
+    void markDamaged(const Rectangle& sprite, size_t x, size_t y)
+    {
+        SpriteClip clip = clipSprite(sprite, x, y, 0, height);
+        if (clip.empty()) {
+            return;
+        }
+        damage.push_back({
+            {
+                static_cast<size_t>(clip.left + clip.firstCol),
+                static_cast<size_t>(clip.top - clip.lastRow + 1)
+            },
+            {
+                static_cast<size_t>(clip.lastCol - clip.firstCol),
+                static_cast<size_t>(clip.lastRow - clip.firstRow)
+            }
+        });
+    }
+
+    /**
+     * @brief Fills the part of a rectangular area within a range of rows.
+     * @details Like the other raster functions this records no damage and
+     *          only touches rows in [rowBegin, rowEnd), so calls for
+     *          disjoint row ranges may run concurrently.
+     *
+     * @param x X-coordinate of the first column of the area.
+     * @param y Y-coordinate of the first row of the area.
+     * @param areaWidth Width of the area.
+     * @param areaHeight Height of the area.
+     * @param value Value to fill with, see mapColor.
+     * @param rowBegin First buffer row that may be written.
+     * @param rowEnd One past the last buffer row that may be written.
+     */
+    void rasterRect(
+        size_t x, size_t y,
+        size_t areaWidth, size_t areaHeight,
+        uint32_t value,
+        size_t rowBegin, size_t rowEnd
+    ){
+        if (x >= width || y >= rowEnd) {
+            return;
+        }
+        size_t x1 = x + std::min(areaWidth, width - x);
+        size_t y0 = std::max(y, rowBegin);
+        size_t y1 = y + std::min(areaHeight, rowEnd - y);
+        for (size_t yi = y0; yi < y1; ++yi) {
+            fillRow(yi, x, x1, value);
+        }
+    }
+
+    /**
+     * @brief Draws the part of a span compiled sprite within a range of rows.
+     *
+     * @param sprite The compiled sprite to draw.
+     * @param x X-coordinate position to draw the sprite.
+     * @param y Y-coordinate position to draw the sprite.
+     * @param value Value for the sprite pixels, see mapColor.
+     * @param rowBegin First buffer row that may be written.
+     * @param rowEnd One past the last buffer row that may be written.
+     */
+    void rasterSpans(
+        const SpanSprite& sprite,
+        size_t x, size_t y, uint32_t value,
+        size_t rowBegin, size_t rowEnd
+    ){
+        SpriteClip clip = clipSprite(sprite, x, y, rowBegin, rowEnd);
+        if (clip.empty()) {
+            return;
+        }
+
+        const ptrdiff_t bufferWidth = static_cast<ptrdiff_t>(width);
+        const bool clipX = clip.firstCol > 0
+            || clip.lastCol < static_cast<ptrdiff_t>(sprite.width);
+
+        if (format != FORMAT_RGBA32) {
+            for (ptrdiff_t yi = clip.firstRow; yi < clip.lastRow; ++yi) {
+                const Span* span = sprite.spans.data() + sprite.rowStart[yi];
+                const Span* end = sprite.spans.data() + sprite.rowStart[yi + 1];
+                for (; span != end; ++span) {
+                    ptrdiff_t sx = std::max<ptrdiff_t>(span->x, clip.firstCol);
+                    ptrdiff_t ex = std::min<ptrdiff_t>(span->x + span->length, clip.lastCol);
+                    if (sx < ex) {
+                        fillRow(clip.top - yi, clip.left + sx, clip.left + ex, value);
+                    }
+                }
+            }
+            return;
+        }
+
+        for (ptrdiff_t yi = clip.firstRow; yi < clip.lastRow; ++yi) {
+            uint32_t* row = data.data() + (clip.top - yi) * bufferWidth;
+            const Span* span = sprite.spans.data() + sprite.rowStart[yi];
+            const Span* end = sprite.spans.data() + sprite.rowStart[yi + 1];
+
+            if (!clipX) {
+                for (; span != end; ++span) {
+                    std::fill_n(row + clip.left + span->x, span->length, value);
+                }
+                continue;
+            }
+
+            for (; span != end; ++span) {
+                ptrdiff_t sx = std::max<ptrdiff_t>(span->x, clip.firstCol);
+                ptrdiff_t ex = std::min<ptrdiff_t>(span->x + span->length, clip.lastCol);
+                if (sx < ex) {
+                    std::fill(row + clip.left + sx, row + clip.left + ex, value);
                 }
             }
         }
     }
 
+    /**
+     * @brief Draws the part of a bit-packed sprite within a range of rows.
+     *
+     * @param sprite The packed sprite to draw.
+     * @param x X-coordinate position to draw the sprite.
+     * @param y Y-coordinate position to draw the sprite.
+     * @param value Value for the sprite pixels, see mapColor.
+     * @param rowBegin First buffer row that may be written.
+     * @param rowEnd One past the last buffer row that may be written.
+     */
+    void rasterPacked(
+        const PackedSprite& sprite,
+        size_t x, size_t y, uint32_t value,
+        size_t rowBegin, size_t rowEnd
+    ){
+        SpriteClip clip = clipSprite(sprite, x, y, rowBegin, rowEnd);
+        if (clip.empty()) {
+            return;
+        }
+
+        const size_t count = clip.lastCol - clip.firstCol;
+        const uint16_t mask = static_cast<uint16_t>((1u << count) - 1);
+        const size_t x0 = clip.left + clip.firstCol;
+
+        switch (format) {
+            case FORMAT_RGBA32: {
+                const ptrdiff_t bufferWidth = static_cast<ptrdiff_t>(width);
+                uint32_t* dst = data.data() + (clip.top - clip.firstRow) * bufferWidth + x0;
+                blit::packedRows(
+                    dst, -bufferWidth,
+                    sprite.rows + clip.firstRow, clip.lastRow - clip.firstRow,
+                    clip.firstCol, mask, count,
+                    value
+                );
+                break;
+            }
+            case FORMAT_INDEXED8: {
+                for (ptrdiff_t yi = clip.firstRow; yi < clip.lastRow; ++yi) {
+                    uint8_t* dst = reinterpret_cast<uint8_t*>(data.data() + (clip.top - yi) * stride) + x0;
+                    unsigned bits = (sprite.rows[yi] >> clip.firstCol) & mask;
+                    while (bits) {
+                        dst[__builtin_ctz(bits)] = static_cast<uint8_t>(value);
+                        bits &= bits - 1;
+                    }
+                }
+                break;
+            }
+            case FORMAT_MONO1: {
+                // A whole sprite row lands in at most two words
+                for (ptrdiff_t yi = clip.firstRow; yi < clip.lastRow; ++yi) {
+                    uint32_t* row = data.data() + (clip.top - yi) * stride + x0 / 32;
+                    uint64_t bits = static_cast<uint64_t>((sprite.rows[yi] >> clip.firstCol) & mask) << (x0 % 32);
+                    uint32_t low = static_cast<uint32_t>(bits);
+                    uint32_t high = static_cast<uint32_t>(bits >> 32);
+                    row[0] = value ? row[0] | low : row[0] & ~low;
+                    if (high) {
+                        row[1] = value ? row[1] | high : row[1] & ~high;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
     /**
      * @brief Draws text onto the buffer using a text spritesheet.
      *
+     * @tparam SpriteSheet Sprite or PackedSprite.
      * @param textSpritesheet Sprite containing character glyphs.
      * @param text Null-terminated string to draw.
      * @param x X-coordinate position to start drawing text.
      * @param y Y-coordinate position to draw text.
      * @param color 32-bit RGBA color value for the text.
      */
+    template <typename SpriteSheet>
     void drawText(
-        const data::Sprite& textSpritesheet,
+        const SpriteSheet& textSpritesheet,
         const char* text,
         size_t x, size_t y,
         uint32_t color)
     {
-        size_t xp = x;
-        size_t stride = textSpritesheet.width * textSpritesheet.height;
-        data::Sprite sprite = textSpritesheet;
-        for (const char* charp = text; *charp != '\0'; ++charp) {
-            char character = *charp - 32;
-            if (character < 0 || character >= 65) {
-                continue;
-            }
-            sprite.data = textSpritesheet.data + character * stride;
+        layoutText(textSpritesheet, text, x, [&](const auto& sprite, size_t xp) {
             drawSprite(sprite, xp, y, color);
-            xp += sprite.width + 1;
-        }
+        });
     }
 
     /**
      * @brief Draws a number onto the buffer using a number spritesheet.
      *
+     * @tparam SpriteSheet Sprite or PackedSprite.
      * @param numberSpritesheet Sprite containing digit glyphs (0-9).
      * @param number The number to draw.
      * @param x X-coordinate position to start drawing the number.
      * @param y Y-coordinate position to draw the number.
      * @param color 32-bit RGBA color value for the number.
      */
+    template <typename SpriteSheet>
     void drawNumber(
-        const data::Sprite& numberSpritesheet, size_t number,
+        const SpriteSheet& numberSpritesheet, size_t number,
         size_t x, size_t y,
         uint32_t color
     ){
-        uint8_t digits[64];
-        size_t num_digits = 0;
-
-        size_t current_number = number;
-        do {
-            digits[num_digits++] = current_number % 10;
-            current_number = current_number / 10;
-        } while (current_number > 0);
-
-        size_t xp = x;
-        size_t stride = numberSpritesheet.width * numberSpritesheet.height;
-        data::Sprite sprite = numberSpritesheet;
-        for (size_t i = 0; i < num_digits; ++i) {
-            uint8_t digit = digits[num_digits - i - 1];
-            sprite.data = numberSpritesheet.data + digit * stride;
+        layoutNumber(numberSpritesheet, number, x, [&](const auto& sprite, size_t xp) {
             drawSprite(sprite, xp, y, color);
-            xp += sprite.width + 1;
-        }
+        });
     }
 
 private:
+    /**
+     * @brief Visible part of a sprite after clipping against the buffer.
+     *
+     * @var left Buffer column of sprite column 0.
+     * @var top Buffer row of sprite row 0.
+     * @var firstRow First visible sprite row.
+     * @var lastRow One past the last visible sprite row.
+     * @var firstCol First visible sprite column.
+     * @var lastCol One past the last visible sprite column.
+     */
+    struct SpriteClip {
+        ptrdiff_t left;
+        ptrdiff_t top;
+        ptrdiff_t firstRow;
+        ptrdiff_t lastRow;
+        ptrdiff_t firstCol;
+        ptrdiff_t lastCol;
+
+        bool empty() const
+        {
+            return firstRow >= lastRow || firstCol >= lastCol;
+        }
+    };
+
+    /**
+     * @brief Clips a sprite rectangle drawn at a position against the buffer.
+     * @details Positions may have wrapped below zero, so they are treated
+     *          as signed. Sprite row yi lands on buffer row top - yi.
+     *
+     * @param sprite Rectangle of the sprite.
+     * @param x X-coordinate position of the sprite.
+     * @param y Y-coordinate position of the sprite.
+     * @param rowBegin First buffer row the sprite may cover.
+     * @param rowEnd One past the last buffer row the sprite may cover.
+     * @return SpriteClip The visible rows and columns of the sprite.
+     */
+    SpriteClip clipSprite(
+        const Rectangle& sprite, size_t x, size_t y,
+        size_t rowBegin, size_t rowEnd
+    ) const {
+        SpriteClip clip;
+        clip.left = static_cast<ptrdiff_t>(x);
+        clip.top = static_cast<ptrdiff_t>(y + sprite.height - 1);
+        clip.firstRow = std::max<ptrdiff_t>(0, clip.top - (static_cast<ptrdiff_t>(rowEnd) - 1));
+        clip.lastRow = std::min<ptrdiff_t>(sprite.height, clip.top - static_cast<ptrdiff_t>(rowBegin) + 1);
+        clip.firstCol = std::max<ptrdiff_t>(0, -clip.left);
+        clip.lastCol = std::min<ptrdiff_t>(sprite.width, static_cast<ptrdiff_t>(width) - clip.left);
+        return clip;
+    }
+
+    /**
+     * @brief Box around the points plotted into a tile, empty while left
+     *        is past right.
+     *
+     * @var left Leftmost column plotted.
+     * @var right Rightmost column plotted.
+     * @var bottom Lowest row plotted.
+     * @var top Highest row plotted.
+     */
+    struct PlotTile {
+        uint16_t left = UINT16_MAX;
+        uint16_t right = 0;
+        uint16_t bottom = UINT16_MAX;
+        uint16_t top = 0;
+    };
+
+    /**
+     * @brief Calls plot for every point inside the buffer and marks the
+     *        box around them damaged tile by tile, see plotPoints.
+     * @details Every touched tile adds one region, which collectDamage
+     *          merges down to MAX_DAMAGE_REGIONS with everything else.
+     */
+    template <typename Plot>
+    void plotEach(const uint16_t* xs, const uint16_t* ys, size_t count, Plot plot)
+    {
+        for (size_t pi = 0; pi < count; ++pi) {
+            const uint16_t x = xs[pi];
+            const uint16_t y = ys[pi];
+            if (x >= width || y >= height) {
+                continue;
+            }
+            plot(x, y);
+            PlotTile& tile = plotTiles[y / DAMAGE_BAND_HEIGHT * plotTilesX + x / DAMAGE_TILE_WIDTH];
+            tile.left = std::min(tile.left, x);
+            tile.right = std::max(tile.right, x);
+            tile.bottom = std::min(tile.bottom, y);
+            tile.top = std::max(tile.top, y);
+        }
+        for (PlotTile& tile : plotTiles) {
+            if (tile.left <= tile.right) {
+                markDamaged(tile.left, tile.bottom, tile.right - tile.left + 1, tile.top - tile.bottom + 1);
+                tile = PlotTile{};
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the number of colors the palette can hold.
+     *
+     * @return size_t 2 for 1-bit buffers, 256 otherwise.
+     */
+    size_t paletteCapacity() const
+    {
+        return format == FORMAT_MONO1 ? 2 : palette.size();
+    }
+
+    /**
+     * @brief Converts a color into the value stored for it in the buffer.
+     * @details RGBA buffers store the color itself, compact buffers store
+     *          its palette index, adding the color to the palette if needed.
+     *
+     * @param color 32-bit RGBA color value.
+     * @return uint32_t The color or its palette index.
+     */
+    uint32_t pixelValue(uint32_t color)
+    {
+        if (format == FORMAT_RGBA32) {
+            return color;
+        }
+        if (paletteSize && color == lastColor) {
+            return lastIndex;
+        }
+
+        size_t index = 0;
+        while (index < paletteSize && palette[index] != color) {
+            ++index;
+        }
+        if (index == paletteSize) {
+            if (paletteSize < paletteCapacity()) {
+                palette[paletteSize++] = color;
+                ++paletteVersion;
+            } else {
+                index = paletteSize - 1;
+            }
+        }
+        lastColor = color;
+        lastIndex = static_cast<uint32_t>(index);
+        return lastIndex;
+    }
+
+    /**
+     * @brief Copies the rows of a region between the buffer and its background.
+     * @details Every row is a single copy of whole words. In compact formats
+     *          this may copy a few pixels next to the region as well, which
+     *          is harmless as everything outside the drawn areas already
+     *          matches the background.
+     *
+     * @param from Words to copy from.
+     * @param to Words to copy to.
+     * @param region Area to copy.
+     */
+    void copyWords(const std::vector<uint32_t>& from, std::vector<uint32_t>& to, const Region& region) const
+    {
+        const size_t pixelsPerWord = format == FORMAT_RGBA32 ? 1
+                                   : format == FORMAT_INDEXED8 ? 4 : 32;
+        size_t first = region.x / pixelsPerWord;
+        size_t last = (region.x + region.width + pixelsPerWord - 1) / pixelsPerWord;
+        for (size_t yi = region.y; yi < region.y + region.height; ++yi) {
+            std::copy(from.begin() + yi * stride + first, from.begin() + yi * stride + last,
+                      to.begin() + yi * stride + first);
+        }
+    }
+
+    /**
+     * @brief Fills part of a row with a pixel value in the buffer's format.
+     *
+     * @param row Buffer row to fill.
+     * @param x0 First column to fill.
+     * @param x1 One past the last column to fill.
+     * @param value Color or palette index, see pixelValue.
+     */
+    void fillRow(size_t row, size_t x0, size_t x1, uint32_t value)
+    {
+        uint32_t* words = data.data() + row * stride;
+        switch (format) {
+            case FORMAT_RGBA32:
+                std::fill(words + x0, words + x1, value);
+                break;
+            case FORMAT_INDEXED8: {
+                uint8_t* bytes = reinterpret_cast<uint8_t*>(words);
+                std::fill(bytes + x0, bytes + x1, static_cast<uint8_t>(value));
+                break;
+            }
+            case FORMAT_MONO1: {
+                const uint32_t fill = value ? ~0u : 0u;
+                while (x0 < x1) {
+                    size_t bit = x0 % 32;
+                    size_t count = std::min<size_t>(32 - bit, x1 - x0);
+                    uint32_t mask = (count == 32 ? ~0u : ((1u << count) - 1)) << bit;
+                    words[x0 / 32] = (words[x0 / 32] & ~mask) | (fill & mask);
+                    x0 += count;
+                }
+                break;
+            }
+        }
+    }
+
     size_t width;
     size_t height;
+    PixelFormat format;
+    size_t stride;
     std::vector<uint32_t> data;
+    std::unordered_map<const uint8_t*, SpanSprite> spanCache;
+
+    std::array<uint32_t, 256> palette;
+    size_t paletteSize = 0;
+    size_t paletteVersion = 0;
+    uint32_t lastColor = 0;
+    uint32_t lastIndex = 0;
+
+    uint32_t clearColor = 0;
+    bool fullDamage = true;
+    std::vector<Region> damage;
+    std::vector<Region> cleared;
+    std::vector<Region> changed;
+    std::vector<PlotTile> plotTiles;
+    size_t plotTilesX = 0;
+
+    std::vector<uint32_t> background;
+    bool backgroundValid = false;
 };
 
 } // data
@@ -0,0 +1,241 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data/data.hpp"
+#include "data/static_sprite.hpp"
+#include "util/thread_pool.hpp"
+
+namespace data {
+
+/**
+ * @brief Rasterizes a compile-time sprite within a range of buffer rows.
+ *
+ * @param buffer Buffer to draw into.
+ * @param x X-coordinate position of the sprite.
+ * @param y Y-coordinate position of the sprite.
+ * @param value Value for the sprite pixels, see Buffer::mapColor.
+ * @param rowBegin First buffer row that may be written.
+ * @param rowEnd One past the last buffer row that may be written.
+ * @param spans Span form of the sprite for positions that need clipping.
+ */
+using StaticRasterFn = void (*)(
+    Buffer& buffer, size_t x, size_t y, uint32_t value,
+    size_t rowBegin, size_t rowEnd, const SpanSprite& spans
+);
+
+/**
+ * @brief Enumeration of the kinds of recorded draw commands.
+ *
+ * @var DRAW_SPANS Sprite drawn through its span form.
+ * @var DRAW_PACKED Bit-packed sprite.
+ * @var DRAW_STATIC Sprite with a compile-time specialized draw routine.
+ * @var DRAW_RECT Filled rectangle.
+ */
+enum DrawKind: uint8_t
+{
+    DRAW_SPANS  = 0,
+    DRAW_PACKED = 1,
+    DRAW_STATIC = 2,
+    DRAW_RECT   = 3
+};
+
+/**
+ * @brief A single recorded draw.
+ * @details Inherits from Location for the position of the draw.
+ *
+ * @inherit Location
+ *    - x: X-coordinate position of the draw.
+ *    - y: Y-coordinate position of the draw.
+ *
+ * @var kind What is drawn, see DrawKind.
+ * @var value Pixel value already mapped by Buffer::mapColor.
+ * @var size Width and height of the sprite or rectangle.
+ * @var spans Span form of the sprite, for DRAW_SPANS and DRAW_STATIC.
+ * @var rows Packed rows of the sprite, for DRAW_PACKED.
+ * @var raster Specialized routine, for DRAW_STATIC.
+ */
+struct DrawCommand final: Location
+{
+    DrawKind kind;
+    uint32_t value;
+    Rectangle size;
+    const SpanSprite* spans;
+    const uint16_t* rows;
+    StaticRasterFn raster;
+};
+
+/**
+ * @brief Records draws for a buffer and rasterizes them in horizontal bands.
+ * @details Colors are mapped, sprites compiled and damage recorded while
+ *          recording, so rasterizing never modifies shared state. Commands
+ *          are binned into bands of rows and every band replays its
+ *          commands in recording order, which gives exactly the same pixels
+ *          as drawing straight into the buffer. Bands are independent and
+ *          can be rasterized on a thread pool.
+ *
+ * @var target Buffer the commands are drawn into.
+ * @var bandHeight Number of rows per band.
+ * @var commands Commands recorded since the last reset.
+ * @var bins Indices of the commands touching each band.
+ */
+class DrawList
+{
+public:
+    /**
+     * @brief Constructs an empty DrawList for a buffer.
+     *
+     * @param target Buffer the commands are drawn into.
+     * @param bandHeight Number of rows per band.
+     */
+    DrawList(Buffer& target, size_t bandHeight = 16);
+
+    /**
+     * @brief Drops all recorded commands, keeping their storage.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the number of recorded commands.
+     *
+     * @return size_t Number of commands since the last reset.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Records a filled rectangle, see Buffer::fillRect.
+     */
+    void fillRect(
+        size_t x, size_t y,
+        size_t areaWidth, size_t areaHeight,
+        uint32_t color
+    );
+
+    /**
+     * @brief Records a sprite, see Buffer::drawSprite.
+     */
+    void drawSprite(const Sprite& sprite, size_t x, size_t y, uint32_t color);
+
+    /**
+     * @brief Records a bit-packed sprite, see Buffer::drawSprite.
+     */
+    void drawSprite(const PackedSprite& sprite, size_t x, size_t y, uint32_t color);
+
+    /**
+     * @brief Records a sprite with a compile-time specialized routine.
+     *
+     * @param raster Routine rasterizing the sprite.
+     * @param sprite Runtime form of the same sprite.
+     * @param x X-coordinate position to draw the sprite.
+     * @param y Y-coordinate position to draw the sprite.
+     * @param color 32-bit RGBA color value for the sprite pixels.
+     */
+    void drawStatic(
+        StaticRasterFn raster, const Sprite& sprite,
+        size_t x, size_t y, uint32_t color
+    );
+
+    /**
+     * @brief Records text, see Buffer::drawText.
+     */
+    template <typename SpriteSheet>
+    void drawText(
+        const SpriteSheet& textSpritesheet,
+        const char* text,
+        size_t x, size_t y,
+        uint32_t color)
+    {
+        layoutText(textSpritesheet, text, x, [&](const auto& sprite, size_t xp) {
+            drawSprite(sprite, xp, y, color);
+        });
+    }
+
+    /**
+     * @brief Records a number, see Buffer::drawNumber.
+     */
+    template <typename SpriteSheet>
+    void drawNumber(
+        const SpriteSheet& numberSpritesheet, size_t number,
+        size_t x, size_t y,
+        uint32_t color
+    ){
+        layoutNumber(numberSpritesheet, number, x, [&](const auto& sprite, size_t xp) {
+            drawSprite(sprite, xp, y, color);
+        });
+    }
+
+    /**
+     * @brief Rasterizes all recorded commands into the target buffer.
+     * @details The commands stay recorded until reset.
+     *
+     * @param pool Pool to rasterize bands on, nullptr runs them on the
+     *             calling thread.
+     */
+    void execute(util::ThreadPool* pool = nullptr);
+
+private:
+    /**
+     * @brief Appends a command to every band its rows overlap.
+     *
+     * @param index Index of the command in commands.
+     */
+    void bin(size_t index);
+
+    /**
+     * @brief Rasterizes one command within a range of rows.
+     *
+     * @param command Command to rasterize.
+     * @param rowBegin First buffer row that may be written.
+     * @param rowEnd One past the last buffer row that may be written.
+     */
+    void rasterize(const DrawCommand& command, size_t rowBegin, size_t rowEnd);
+
+    Buffer& target;
+    size_t bandHeight;
+    std::vector<DrawCommand> commands;
+    std::vector<std::vector<uint32_t>> bins;
+};
+
+/**
+ * @brief Rasterizes a compile-time sprite within a range of buffer rows.
+ * @details Sprites fully inside the rows and the buffer width of an RGBA
+ *          buffer take the unrolled path, all others the span form.
+ *
+ * @tparam Shape StaticSprite to draw.
+ */
+template <typename Shape>
+void rasterStatic(
+    Buffer& buffer, size_t x, size_t y, uint32_t value,
+    size_t rowBegin, size_t rowEnd, const SpanSprite& spans
+){
+    const size_t width = buffer.getWidth();
+    if (buffer.getFormat() != FORMAT_RGBA32
+        || width < Shape::width || x > width - Shape::width
+        || y < rowBegin || rowEnd < Shape::height || y > rowEnd - Shape::height) {
+        buffer.rasterSpans(spans, x, y, value, rowBegin, rowEnd);
+        return;
+    }
+
+    uint32_t* topLeft = buffer.getData() + (y + Shape::height - 1) * width + x;
+    drawRuns<Shape>(topLeft, width, value, std::make_index_sequence<Shape::numSpans>{});
+}
+
+/**
+ * @brief Records a sprite whose shape is known at compile time.
+ * @details Placement only matters for immediate draws, recorded sprites
+ *          are checked against their band when rasterized.
+ *
+ * @tparam Shape StaticSprite to draw.
+ * @tparam Placement Clipped or InBounds.
+ * @param list Draw list to record into.
+ * @param x X-coordinate position to draw the sprite.
+ * @param y Y-coordinate position to draw the sprite.
+ * @param color 32-bit RGBA color value for the sprite pixels.
+ */
+template <typename Shape, typename Placement = Clipped>
+inline void drawStatic(DrawList& list, size_t x, size_t y, uint32_t color)
+{
+    list.drawStatic(rasterStatic<Shape>, Shape::sprite(), x, y, color);
+}
+
+} // data
@@ -0,0 +1,226 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "data/data.hpp"
+
+namespace data {
+
+/**
+ * @brief A string baked into bit-packed strips of its glyph rows.
+ * @details Inherits from Rectangle for the size of the whole string.
+ *          The string is cut into strips of PACKED_MAX_WIDTH columns so
+ *          every strip is an ordinary PackedSprite and a whole line of
+ *          text draws with a handful of row mask stores.
+ *
+ * @inherit Rectangle
+ *    - width: Width of the laid-out string.
+ *    - height: Height of the glyphs.
+ *
+ * @var rows Rows of every strip, strip after strip.
+ * @var numStrips Number of strips the string is cut into.
+ */
+struct TextLayout final: Rectangle
+{
+    std::vector<uint16_t> rows;
+    size_t numStrips;
+
+    /**
+     * @brief Gets a strip of the string as a packed sprite.
+     *
+     * @param index Index of the strip, from the left.
+     * @return PackedSprite The strip, drawn at x + index * PACKED_MAX_WIDTH.
+     */
+    PackedSprite strip(size_t index) const
+    {
+        size_t left = index * PACKED_MAX_WIDTH;
+        return {
+            {std::min(PACKED_MAX_WIDTH, width - left), height},
+            rows.data() + index * height
+        };
+    }
+};
+
+/**
+ * @brief A font on a packed glyph atlas with a cache of laid-out strings.
+ * @details Glyphs are stored back to back in the atlas starting at
+ *          firstChar, with one column of spacing between glyphs of a
+ *          string. Strings are baked into a TextLayout the first time they
+ *          are drawn and reused by content afterwards.
+ *
+ * @var atlas Packed spritesheet holding every glyph.
+ * @var numGlyphs Number of glyphs in the atlas.
+ * @var firstChar Character of the first glyph.
+ * @var layouts Laid-out strings by content.
+ */
+class Font
+{
+public:
+    /**
+     * @brief Constructs a Font on a packed glyph atlas.
+     *
+     * @param atlas Packed spritesheet holding glyph rows back to back.
+     * @param numGlyphs Number of glyphs in the atlas.
+     * @param firstChar Character of the first glyph.
+     */
+    Font(const PackedSprite& atlas, size_t numGlyphs, char firstChar);
+
+    /**
+     * @brief Gets the horizontal distance between two glyphs of a string.
+     *
+     * @return size_t Glyph width plus spacing.
+     */
+    size_t advance() const;
+
+    /**
+     * @brief Gets the glyph of a character.
+     *
+     * @param character Character to look up, must be in the atlas.
+     * @return PackedSprite The glyph.
+     */
+    PackedSprite glyph(char character) const;
+
+    /**
+     * @brief Looks up the layout of a string, baking it on first use.
+     * @details Characters outside the atlas are skipped. The returned
+     *          reference stays valid for the font's lifetime.
+     *
+     * @param text String to lay out.
+     * @return const TextLayout& The cached layout.
+     */
+    const TextLayout& layout(const std::string& text);
+
+    /**
+     * @brief Draws a string through its cached layout.
+     *
+     * @tparam Target Buffer or DrawList.
+     * @param target Buffer or draw list to draw into.
+     * @param text String to draw.
+     * @param x X-coordinate position of the first glyph.
+     * @param y Y-coordinate position of the glyphs.
+     * @param color 32-bit RGBA color value for the text pixels.
+     */
+    template <typename Target>
+    void drawText(Target& target, const std::string& text, size_t x, size_t y, uint32_t color)
+    {
+        const TextLayout& line = layout(text);
+        for (size_t i = 0; i < line.numStrips; ++i) {
+            target.drawSprite(line.strip(i), x + i * PACKED_MAX_WIDTH, y, color);
+        }
+    }
+
+private:
+    PackedSprite atlas;
+    size_t numGlyphs;
+    char firstChar;
+    std::unordered_map<std::string, TextLayout> layouts;
+};
+
+/**
+ * @brief A number drawn at a fixed position that only redraws digits that changed.
+ * @details Every changed digit cell is filled with the background color
+ *          and the new digit is drawn over it. Drawing the same number
+ *          again does nothing at all.
+ *
+ * @var font Font the digits are drawn with.
+ * @var position Position of the most significant digit.
+ * @var digits Digits currently drawn, most significant first.
+ * @var numDigits Number of digits currently drawn.
+ * @var number Number currently drawn.
+ * @var valid Whether the digits are actually on screen.
+ */
+class NumberLabel
+{
+public:
+    /**
+     * @brief Constructs a NumberLabel that has not been drawn yet.
+     *
+     * @param font Font the digits are drawn with.
+     * @param x X-coordinate position of the most significant digit.
+     * @param y Y-coordinate position of the digits.
+     */
+    NumberLabel(const Font& font, size_t x, size_t y);
+
+    /**
+     * @brief Forces the next draw to redraw every digit.
+     * @details Call after the area under the label was cleared.
+     */
+    void invalidate();
+
+    /**
+     * @brief Brings the label up to date with a number.
+     *
+     * @tparam Target Buffer or DrawList.
+     * @param target Buffer or draw list to draw into.
+     * @param value Number to show.
+     * @param color 32-bit RGBA color value for the digits.
+     * @param background 32-bit RGBA color value behind the digits.
+     * @return Region Area that was redrawn, empty if nothing changed.
+     */
+    template <typename Target>
+    Region draw(Target& target, size_t value, uint32_t color, uint32_t background)
+    {
+        if (valid && value == number) {
+            return {{position.x, position.y}, {0, 0}};
+        }
+
+        uint8_t next[MAX_DIGITS];
+        size_t numNext = toDigits(value, next);
+        const size_t cells = std::max(numDigits, numNext);
+        const size_t advance = font.advance();
+        const PackedSprite zero = font.glyph('0');
+
+        size_t first = cells;
+        size_t last = 0;
+        for (size_t i = 0; i < cells; ++i) {
+            bool shown = i < numDigits;
+            bool wanted = i < numNext;
+            if (valid && shown == wanted && (!wanted || digits[i] == next[i])) {
+                continue;
+            }
+            size_t xp = position.x + i * advance;
+            target.fillRect(xp, position.y, zero.width, zero.height, background);
+            if (wanted) {
+                target.drawSprite(font.glyph('0' + next[i]), xp, position.y, color);
+            }
+            first = std::min(first, i);
+            last = i + 1;
+        }
+
+        std::copy(next, next + numNext, digits);
+        numDigits = numNext;
+        number = value;
+        valid = true;
+
+        if (first >= last) {
+            return {{position.x, position.y}, {0, 0}};
+        }
+        return {
+            {position.x + first * advance, position.y},
+            {(last - first - 1) * advance + zero.width, zero.height}
+        };
+    }
+
+private:
+    static constexpr size_t MAX_DIGITS = 20;
+
+    /**
+     * @brief Splits a number into decimal digits.
+     *
+     * @param value Number to split.
+     * @param out Receives the digits, most significant first.
+     * @return size_t Number of digits.
+     */
+    static size_t toDigits(size_t value, uint8_t* out);
+
+    const Font& font;
+    Location position;
+    uint8_t digits[MAX_DIGITS];
+    size_t numDigits = 0;
+    size_t number = 0;
+    bool valid = false;
+};
+
+} // data
@@ -0,0 +1,193 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "data/data.hpp"
+
+namespace data {
+
+/**
+ * @brief A run of lit pixels within a sprite, tagged with its row.
+ *
+ * @var row Sprite row of the run (0 is the top row of the sprite data).
+ * @var x Column of the first lit pixel in the run.
+ * @var length Number of consecutive lit pixels.
+ */
+struct RowSpan {
+    uint16_t row;
+    uint16_t x;
+    uint16_t length;
+};
+
+/**
+ * @brief Counts the runs of lit pixels in byte-per-pixel sprite data.
+ *
+ * @param pixels Byte-per-pixel sprite data.
+ * @param width Width of the sprite.
+ * @param height Height of the sprite.
+ * @return size_t Number of runs over all rows.
+ */
+constexpr size_t countRowSpans(const uint8_t* pixels, size_t width, size_t height)
+{
+    size_t count = 0;
+    for (size_t yi = 0; yi < height; ++yi) {
+        for (size_t xi = 0; xi < width; ++xi) {
+            if (pixels[yi * width + xi] && (xi == 0 || !pixels[yi * width + xi - 1])) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Builds the runs of lit pixels of byte-per-pixel sprite data.
+ *
+ * @tparam Count Number of runs, see countRowSpans.
+ * @param pixels Byte-per-pixel sprite data.
+ * @param width Width of the sprite.
+ * @param height Height of the sprite.
+ * @return std::array<RowSpan, Count> Runs ordered by row and then column.
+ */
+template <size_t Count>
+constexpr std::array<RowSpan, Count> buildRowSpans(
+    const uint8_t* pixels, size_t width, size_t height
+){
+    std::array<RowSpan, Count> spans{};
+    size_t count = 0;
+    for (size_t yi = 0; yi < height; ++yi) {
+        size_t xi = 0;
+        while (xi < width) {
+            if (!pixels[yi * width + xi]) {
+                ++xi;
+                continue;
+            }
+            size_t start = xi;
+            while (xi < width && pixels[yi * width + xi]) {
+                ++xi;
+            }
+            spans[count++] = {
+                static_cast<uint16_t>(yi),
+                static_cast<uint16_t>(start),
+                static_cast<uint16_t>(xi - start)
+            };
+        }
+    }
+    return spans;
+}
+
+/**
+ * @brief A sprite whose shape is known at compile time.
+ * @details The runs of lit pixels are computed at compile time, which lets
+ *          drawStatic emit a fully unrolled sequence of stores per sprite.
+ *
+ * @tparam Width Width of the sprite in pixels.
+ * @tparam Height Height of the sprite in pixels.
+ * @tparam Pixels Byte-per-pixel sprite data, Width * Height bytes.
+ */
+template <size_t Width, size_t Height, const uint8_t* Pixels>
+struct StaticSprite
+{
+    static constexpr size_t width = Width;
+    static constexpr size_t height = Height;
+    static constexpr size_t numSpans = countRowSpans(Pixels, Width, Height);
+    static constexpr std::array<RowSpan, numSpans> spans =
+        buildRowSpans<numSpans>(Pixels, Width, Height);
+
+    /**
+     * @brief Gets the runtime sprite with the same shape.
+     *
+     * @return Sprite Sprite pointing at Pixels.
+     */
+    static Sprite sprite()
+    {
+        return {{Width, Height}, const_cast<uint8_t*>(Pixels)};
+    }
+};
+
+/**
+ * @brief Placement tag for sprites that may be partially off the buffer.
+ */
+struct Clipped {};
+
+/**
+ * @brief Placement tag for sprites the caller knows lie fully inside the buffer.
+ */
+struct InBounds {};
+
+/**
+ * @brief Fills a run of a length known at compile time.
+ *
+ * @tparam Length Number of pixels to fill.
+ * @param dst First pixel of the run.
+ * @param color 32-bit RGBA color value to fill with.
+ */
+template <size_t Length>
+inline void fillRun(uint32_t* dst, uint32_t color)
+{
+    for (size_t i = 0; i < Length; ++i) {
+        dst[i] = color;
+    }
+}
+
+/**
+ * @brief Stores every run of a static sprite without any clipping.
+ *
+ * @tparam Shape StaticSprite to draw.
+ * @param topLeft Buffer pixel of the top left corner of the sprite.
+ * @param stride Width of the buffer in pixels.
+ * @param color 32-bit RGBA color value for the sprite pixels.
+ */
+template <typename Shape, size_t... I>
+inline void drawRuns(
+    uint32_t* topLeft, size_t stride, uint32_t color,
+    std::index_sequence<I...>
+){
+    (fillRun<Shape::spans[I].length>(
+        topLeft - Shape::spans[I].row * stride + Shape::spans[I].x, color
+    ), ...);
+}
+
+/**
+ * @brief Draws a sprite whose shape is known at compile time.
+ * @details With the Clipped placement the sprite rectangle is checked
+ *          against the buffer once, sprites that are not fully inside fall
+ *          back to Buffer::drawSprite. With InBounds the check is compiled
+ *          out entirely and the caller must guarantee the sprite fits.
+ *
+ * @tparam Shape StaticSprite to draw.
+ * @tparam Placement Clipped or InBounds.
+ * @param buffer Buffer to draw into.
+ * @param x X-coordinate position to draw the sprite.
+ * @param y Y-coordinate position to draw the sprite.
+ * @param color 32-bit RGBA color value for the sprite pixels.
+ */
+template <typename Shape, typename Placement = Clipped>
+inline void drawStatic(Buffer& buffer, size_t x, size_t y, uint32_t color)
+{
+    static_assert(std::is_same_v<Placement, Clipped> || std::is_same_v<Placement, InBounds>,
+                  "Placement must be Clipped or InBounds");
+
+    // Unrolled stores write RGBA colors, compact formats take the generic path
+    if (buffer.getFormat() != FORMAT_RGBA32) {
+        buffer.drawSprite(Shape::sprite(), x, y, color);
+        return;
+    }
+
+    const size_t width = buffer.getWidth();
+    if constexpr (std::is_same_v<Placement, Clipped>) {
+        if (width < Shape::width || x > width - Shape::width
+            || buffer.getHeight() < Shape::height || y > buffer.getHeight() - Shape::height) {
+            buffer.drawSprite(Shape::sprite(), x, y, color);
+            return;
+        }
+    }
+
+    uint32_t* topLeft = buffer.getData() + (y + Shape::height - 1) * width + x;
+    drawRuns<Shape>(topLeft, width, color, std::make_index_sequence<Shape::numSpans>{});
+    buffer.markDamaged(x, y, Shape::width, Shape::height);
+}
+
+} // data
@@ -0,0 +1,184 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "data/data.hpp"
+
+namespace render {
+
+/**
+ * @brief Costs of the frames captured so far.
+ * @details Times are spent in capture on the game thread, encoding and
+ *          writing happen on the writer thread and are not included.
+ *
+ * @var frames Number of frames handed to capture.
+ * @var dropped Frames dropped because the writer had no free packet.
+ * @var overBudget Frames whose capture took longer than the budget.
+ * @var totalMicros Time of all captures.
+ * @var maxMicros Time of the slowest capture.
+ * @var bytes Bytes written to the file so far.
+ * @var failed Whether writing the file failed, which stops the capture.
+ */
+struct CaptureStats {
+    size_t frames;
+    size_t dropped;
+    size_t overBudget;
+    double totalMicros;
+    double maxMicros;
+    size_t bytes;
+    bool failed;
+};
+
+/**
+ * @brief Records frames of a buffer into a frame file on a background thread.
+ * @details The game thread only copies the words of the damaged regions
+ *          into a packet from a small pool and queues it, which is the
+ *          least that can be copied before the next frame draws over them.
+ *          The writer thread applies packets to its own copy of the
+ *          buffer, expands it to RGBA and delta-encodes it against the
+ *          previous frame, see encodeDelta. When the writer falls behind
+ *          and no packet is free the frame is dropped and its damage is
+ *          sent with the next one, the game thread never waits for the disk.
+ *          A failed write stops the capture, as every later frame would be
+ *          encoded against one the file does not have.
+ *
+ * @var budgetMicros Time a capture may take on the game thread.
+ * @var keyInterval Number of records from one keyframe to the next.
+ * @var file File frames are written to.
+ * @var mirror Writer's copy of the captured buffer.
+ * @var current Expanded pixels of the frame being encoded.
+ * @var previous Expanded pixels of the frame encoded last.
+ * @var payload Encoded frame being written.
+ * @var packets Pool of packets frames are queued in.
+ * @var freePackets Packets the game thread may fill.
+ * @var queued Packets waiting for the writer.
+ * @var mutex Guards freePackets, queued and stopping.
+ * @var wake Signalled when a packet is queued or the writer should stop.
+ * @var stopping Whether the writer should exit once the queue is empty.
+ * @var resync Whether the next frame must be sent whole.
+ * @var missed Damage of the frames dropped since the last packet.
+ * @var paletteVersion Palette version last sent to the writer.
+ * @var records Number of records written.
+ * @var stats Costs of the captures so far, bytes is kept in bytesWritten.
+ * @var bytesWritten Bytes written by the writer thread.
+ * @var failed Set once a write failed, nothing is written after it.
+ * @var writer The writer thread.
+ */
+class FrameCapture
+{
+public:
+    /**
+     * @brief Opens the frame file and starts the writer thread.
+     *
+     * @param buffer Buffer that will be captured, fixes size and format.
+     * @param path Path of the frame file, replaced if it exists.
+     * @param budgetMicros Time a capture may take on the game thread.
+     * @param keyInterval Number of records from one keyframe to the next.
+     * @param numPackets Number of frames that may wait for the writer.
+     */
+    FrameCapture(
+        data::Buffer& buffer, const std::string& path,
+        double budgetMicros = 250.0, size_t keyInterval = 300, size_t numPackets = 4
+    );
+
+    /**
+     * @brief Finishes the file, see finish.
+     */
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /**
+     * @brief Checks whether the file could be created.
+     *
+     * @return bool True if frames are being recorded, false after finish.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Queues a finished frame for writing.
+     *
+     * @param buffer Buffer holding the frame.
+     * @param damage Regions that changed since the previous frame, see
+     *               Buffer::collectDamage.
+     */
+    void capture(data::Buffer& buffer, const std::vector<data::Region>& damage);
+
+    /**
+     * @brief Writes the queued frames, stops the writer and closes the file.
+     * @details Frames captured afterwards are ignored.
+     *
+     * @return bool False if writing or closing the file failed.
+     */
+    bool finish();
+
+    /**
+     * @brief Gets the costs of the captures so far.
+     *
+     * @return CaptureStats Costs of all frames.
+     */
+    CaptureStats getStats() const;
+
+private:
+    /**
+     * @brief Damaged words of one frame.
+     *
+     * @var frame Number of the frame.
+     * @var regions Damaged regions in pixels.
+     * @var words Words of every row of every region, in order.
+     * @var palette Palette of the buffer, if hasPalette is set.
+     * @var hasPalette Whether the palette changed.
+     */
+    struct Packet {
+        size_t frame;
+        std::vector<data::Region> regions;
+        std::vector<uint32_t> words;
+        std::array<uint32_t, 256> palette;
+        bool hasPalette;
+    };
+
+    /**
+     * @brief Main loop of the writer thread.
+     */
+    void writerLoop();
+
+    /**
+     * @brief Applies, encodes and writes one packet.
+     */
+    void write(Packet& packet);
+
+    double budgetMicros;
+    size_t keyInterval;
+    FILE* file = nullptr;
+    std::unique_ptr<data::Buffer> mirror;
+    std::vector<uint32_t> current;
+    std::vector<uint32_t> previous;
+    std::vector<uint8_t> payload;
+
+    std::vector<Packet> packets;
+    std::vector<Packet*> freePackets;
+    std::vector<Packet*> queued;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    bool resync = true;
+    std::vector<data::Region> missed;
+    size_t paletteVersion = 0;
+    size_t records = 0;
+    CaptureStats stats{};
+    std::atomic<size_t> bytesWritten{0};
+    std::atomic<bool> failed{false};
+    std::thread writer;
+};
+
+} // render
@@ -0,0 +1,202 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace render {
+
+/**
+ * @brief Version of the frame file layout written by FrameCapture.
+ * @details A frame file starts with a header of the magic "SIFC", the
+ *          version and reserved field as 16-bit words and the width,
+ *          height and keyframe interval as 32-bit words. A record per
+ *          captured frame follows, made of the payload size and the frame
+ *          number as 32-bit words, a flags byte and the payload. Numbers
+ *          are little endian.
+ *
+ *          Frames are stored as 32-bit RGBA pixels, bottom row first like
+ *          data::Buffer. A payload is a delta against the previous frame,
+ *          keyframes against a frame of zeros, see encodeDelta.
+ */
+constexpr uint16_t FRAME_FILE_VERSION = 1;
+
+/**
+ * @brief Flags of a frame record.
+ *
+ * @var FRAME_KEY The frame is encoded against a frame of zeros.
+ */
+enum FrameFlags: uint8_t
+{
+    FRAME_KEY = 1
+};
+
+/**
+ * @brief Header of a frame file.
+ *
+ * @var width Width of the frames in pixels.
+ * @var height Height of the frames in pixels.
+ * @var keyInterval Number of records from one keyframe to the next.
+ */
+struct FrameFileHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t keyInterval;
+};
+
+/**
+ * @brief Location of a frame in a frame file.
+ *
+ * @var offset Offset of the payload from the start of the file.
+ * @var size Size of the payload in bytes.
+ * @var frame Number of the frame when it was captured, frames dropped
+ *      while capturing leave gaps.
+ * @var flags Flags of the frame, see FrameFlags.
+ */
+struct FrameRecord {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t frame;
+    uint8_t flags;
+};
+
+/**
+ * @brief Writes the header that starts a frame file.
+ *
+ * @param file File to write to.
+ * @param header Header to write.
+ * @return bool True if everything was written.
+ */
+bool writeFrameFileHeader(FILE* file, const FrameFileHeader& header);
+
+/**
+ * @brief Appends a frame record to a frame file.
+ *
+ * @param file File to write to.
+ * @param frame Number of the frame.
+ * @param flags Flags of the frame, see FrameFlags.
+ * @param payload Encoded frame, see encodeDelta.
+ * @return bool True if everything was written.
+ */
+bool writeFrameRecord(FILE* file, uint32_t frame, uint8_t flags, const std::vector<uint8_t>& payload);
+
+/**
+ * @brief Encodes the pixels that differ between two frames.
+ * @details The payload is a list of tokens, each a varint number of
+ *          unchanged pixels to skip and a varint run length shifted left
+ *          by one with the low bit set for a fill. A fill is followed by
+ *          the one pixel repeated for the run, any other run by its
+ *          pixels. Pixels are 32-bit little endian. previous is updated to
+ *          current as it is compared, so it is ready for the next frame.
+ *
+ * @param current Pixels of the frame to encode.
+ * @param previous Pixels of the frame encoded before, becomes current.
+ * @param count Number of pixels in a frame.
+ * @param out Encoded tokens are appended to it.
+ */
+void encodeDelta(const uint32_t* current, uint32_t* previous, size_t count, std::vector<uint8_t>& out);
+
+/**
+ * @brief Applies an encoded delta to a frame.
+ *
+ * @param data Encoded tokens, see encodeDelta.
+ * @param size Size of data in bytes.
+ * @param frame Pixels of the previous frame, become the decoded frame.
+ * @param count Number of pixels in a frame.
+ * @return bool False if the tokens are malformed or run past the frame.
+ */
+bool decodeDelta(const uint8_t* data, size_t size, uint32_t* frame, size_t count);
+
+/**
+ * @brief Writes a frame as a binary PPM image, top row first.
+ *
+ * @param path Path of the image.
+ * @param pixels RGBA pixels, bottom row first.
+ * @param width Width of the frame in pixels.
+ * @param height Height of the frame in pixels.
+ * @return bool True if the image was written.
+ */
+bool writePpm(const std::string& path, const uint32_t* pixels, size_t width, size_t height);
+
+/**
+ * @brief Writes a frame as an RGB PNG image, top row first.
+ * @details The image data is stored uncompressed, so no deflate
+ *          implementation is needed.
+ *
+ * @param path Path of the image.
+ * @param pixels RGBA pixels, bottom row first.
+ * @param width Width of the frame in pixels.
+ * @param height Height of the frame in pixels.
+ * @return bool True if the image was written.
+ */
+bool writePng(const std::string& path, const uint32_t* pixels, size_t width, size_t height);
+
+/**
+ * @brief Reads frames back out of a frame file.
+ * @details Opening scans the records once. Decoding a frame starts from
+ *          the closest keyframe before it, or continues from the frame
+ *          decoded last when that is closer.
+ *
+ * @var file The open frame file.
+ * @var header Header of the file.
+ * @var records Every record in the file, in order.
+ * @var pixels Frame decoded last.
+ * @var decoded Index of the frame in pixels, records.size() if none.
+ * @var payload Scratch space payloads are read into.
+ */
+class FrameFileReader
+{
+public:
+    FrameFileReader() = default;
+
+    /**
+     * @brief Closes the file.
+     */
+    ~FrameFileReader();
+
+    FrameFileReader(const FrameFileReader&) = delete;
+    FrameFileReader& operator=(const FrameFileReader&) = delete;
+
+    /**
+     * @brief Opens a frame file and indexes its records.
+     * @details A truncated last record, as left by a crash, is ignored.
+     *
+     * @param path Path of the file.
+     * @return bool False if the file cannot be read or is no frame file.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Gets the header of the file.
+     *
+     * @return const FrameFileHeader& Frame size and keyframe interval.
+     */
+    const FrameFileHeader& getHeader() const;
+
+    /**
+     * @brief Gets the records of the file.
+     *
+     * @return const std::vector<FrameRecord>& Every record, in order.
+     */
+    const std::vector<FrameRecord>& getRecords() const;
+
+    /**
+     * @brief Decodes a frame.
+     *
+     * @param index Index of the record to decode.
+     * @return const uint32_t* RGBA pixels bottom row first, nullptr if the
+     *         frame cannot be decoded. Valid until the next call.
+     */
+    const uint32_t* decode(size_t index);
+
+private:
+    FILE* file = nullptr;
+    FrameFileHeader header{};
+    std::vector<FrameRecord> records;
+    std::vector<uint32_t> pixels;
+    size_t decoded = 0;
+    std::vector<uint8_t> payload;
+};
+
+} // render
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "data/data.hpp"
+#include "data/static_sprite.hpp"
+#include "sim/game.hpp"
+#include "sim/shields.hpp"
+#include "sprites/aliens.hpp"
+#include "sprites/player.hpp"
+
+namespace render {
+
+/**
+ * @brief Draws the aliens, bullets and player of a game.
+ * @details Labels and the ground line are left to the caller, they change
+ *          rarely and are usually kept in a cached background.
+ *
+ * @tparam Target data::Buffer or data::DrawList.
+ * @param target Buffer or draw list to draw into.
+ * @param game Game to draw.
+ * @param color 32-bit RGBA color value for every sprite.
+ */
+template <typename Target>
+void drawGame(Target& target, const data::Game& game, uint32_t color)
+{
+    // Draw shields straight from their packed rows
+    const data::ShieldStore& shields = game.shields;
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        for (size_t bank = 0; bank < data::SHIELD_BANKS; ++bank) {
+            target.drawSprite(
+                sim::shieldBank(shields, si, bank),
+                static_cast<size_t>(shields.x[si]) + data::PACKED_MAX_WIDTH * bank,
+                static_cast<size_t>(shields.y[si]),
+                color
+            );
+        }
+    }
+
+    // Draw aliens, placed relative to the formation
+    const data::AlienStore& aliens = game.aliens;
+    for (size_t ai = 0; ai < aliens.count; ++ai) {
+        const size_t x = static_cast<size_t>(game.formation.x + aliens.x[ai]);
+        const size_t y = static_cast<size_t>(game.formation.y + aliens.y[ai]);
+        if (aliens.state[ai] == data::ALIEN_GONE) {
+            // Dead alien; don't draw
+            continue;
+        } else if (aliens.state[ai] == data::ALIEN_DYING) {
+            data::drawStatic<sprites::AlienDeathSprite>(target, x, y, color);
+        } else {
+            sprites::drawAlienSprite(target, aliens.frame[ai], x, y, color);
+        }
+    }
+
+    // Draw bullets
+    const data::BulletStore& bullets = game.bullets;
+    for (size_t bi = 0; bi < bullets.count; ++bi) {
+        data::drawStatic<sprites::BulletSprite>(
+            target, static_cast<size_t>(bullets.x[bi]), static_cast<size_t>(bullets.y[bi]), color
+        );
+    }
+
+    // Draw player
+    // Player movement is clamped to the screen, so it never needs clipping
+    data::drawStatic<sprites::PlayerSprite, data::InBounds>(target, game.player.x, game.player.y, color);
+}
+
+} // render
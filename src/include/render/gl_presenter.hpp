@@ -0,0 +1,21 @@
+#pragma once
+#include <memory>
+#include "render/presenter.hpp"
+
+namespace render {
+
+/**
+ * @brief Creates a presenter showing frames in a GLFW window through OpenGL 3.3.
+ * @details Frames are drawn with vsync. Input comes from the arrow keys,
+ *          space and escape.
+ *
+ * @param buffer Buffer that will be presented, its size and format pick
+ *               the window size and shader.
+ * @param uploadRing Whether to upload through a ring of pixel buffers, see
+ *                   TextureUploader.
+ * @return std::unique_ptr<Presenter> The presenter, nullptr if no window
+ *         or context could be created.
+ */
+std::unique_ptr<Presenter> createGlPresenter(data::Buffer& buffer, bool uploadRing);
+
+} // render
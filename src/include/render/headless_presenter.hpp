@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "render/presenter.hpp"
+
+namespace render {
+
+/**
+ * @brief Presents frames nowhere, as fast as they are produced.
+ * @details Meant for machines without a display or GPU. Input comes from
+ *          a fixed autopilot that sweeps the player across the screen and
+ *          fires at a steady rate, so the game logic gets exercised.
+ *          Frames can be written out as binary PPM images.
+ *
+ * @var dumpDir Directory frames are written to, empty to write none.
+ * @var dumpEvery Write every dumpEvery-th frame.
+ * @var frames Number of frames presented.
+ * @var pixels Scratch frame expanded to RGBA for writing.
+ */
+class HeadlessPresenter: public Presenter
+{
+public:
+    /**
+     * @brief Constructs a HeadlessPresenter.
+     *
+     * @param dumpDir Directory frames are written to, empty to write none.
+     * @param dumpEvery Write every dumpEvery-th frame.
+     */
+    HeadlessPresenter(const std::string& dumpDir = "", size_t dumpEvery = 1);
+
+    void present(data::Buffer& buffer, const std::vector<data::Region>& damage) override;
+
+    bool pollInput(sim::ControlWriter& controls) override;
+
+private:
+    /**
+     * @brief Writes a frame as a binary PPM image.
+     *
+     * @param buffer Buffer holding the frame.
+     */
+    void dump(data::Buffer& buffer);
+
+    std::string dumpDir;
+    size_t dumpEvery;
+    size_t frames = 0;
+    std::vector<uint32_t> pixels;
+};
+
+} // render
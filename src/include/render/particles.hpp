@@ -0,0 +1,155 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data/data.hpp"
+
+namespace render {
+
+/**
+ * @brief Fractional bits of particle positions and velocities.
+ */
+constexpr int PARTICLE_FRACTION_BITS = 8;
+
+/**
+ * @brief Debris scattered by impacts, one array per attribute.
+ * @details Purely an effect, the game never sees the particles. follow
+ *          picks up the impacts a game logged since the last call and
+ *          moves every particle on once per game step, so debris moves
+ *          at game speed whatever the frame rate. Positions and
+ *          velocities are fixed point with PARTICLE_FRACTION_BITS
+ *          fractional bits, a step adds the velocities to the positions,
+ *          pulls the velocities down and works out the pixel of every
+ *          particle, 8 particles at a time with vector instructions
+ *          where available. Particles that burnt out or left the screen
+ *          are replaced by the last one, so the first count entries are
+ *          always the live ones and drawing them is a single batch of
+ *          pixels. Scattering draws from a generator of its own, so the
+ *          same game always throws the same debris.
+ *
+ * @var width Width of the area particles live in.
+ * @var height Height of the area particles live in.
+ * @var capacity Most particles alive at once, more are not spawned.
+ * @var count Number of live particles.
+ * @var x X-coordinate of each particle, fixed point.
+ * @var y Y-coordinate of each particle, fixed point.
+ * @var vx Distance each particle moves right per step, fixed point.
+ * @var vy Distance each particle moves up per step, fixed point.
+ * @var life Steps each particle has left.
+ * @var pixelX Pixel column of each particle, as of the last step.
+ * @var pixelY Pixel row of each particle, as of the last step.
+ * @var directions Unit vectors particles scatter along, fixed point.
+ * @var seed State of the scatter generator.
+ * @var tick Game tick the particles were last moved to.
+ * @var impactsSeen Number of the game's impacts already scattered.
+ */
+class ParticleSystem
+{
+public:
+    /**
+     * @brief Constructs an empty ParticleSystem.
+     *
+     * @param width Width of the area, particles leaving it are dropped.
+     * @param height Height of the area.
+     * @param capacity Most particles alive at once.
+     */
+    ParticleSystem(size_t width, size_t height, size_t capacity = 32768);
+
+    /**
+     * @brief Catches up with a game.
+     * @details Scatters debris for the impacts logged since the last call
+     *          and moves the particles on by the steps the game took, at
+     *          most a few frames' worth. A game that went back in time,
+     *          rewound or started over, clears the particles.
+     *
+     * @param game Game to follow, the same one on every call.
+     */
+    void follow(const data::Game& game);
+
+    /**
+     * @brief Scatters the debris of an impact.
+     *
+     * @param impact What was hit and where.
+     */
+    void scatter(const data::Impact& impact);
+
+    /**
+     * @brief Adds a single particle.
+     *
+     * @param x X-coordinate, fixed point.
+     * @param y Y-coordinate, fixed point.
+     * @param vx Distance it moves right per step, fixed point.
+     * @param vy Distance it moves up per step, fixed point.
+     * @param life Steps it lives.
+     * @return bool false if there was no room left.
+     */
+    bool spawn(int32_t x, int32_t y, int32_t vx, int32_t vy, int32_t life);
+
+    /**
+     * @brief Moves every particle one step and drops the ones that are done.
+     */
+    void update();
+
+    /**
+     * @brief Drops every particle.
+     */
+    void clear();
+
+    /**
+     * @brief Draws every live particle as a single pixel.
+     *
+     * @param buffer Buffer to draw into.
+     * @param color 32-bit RGBA color value for the particles.
+     */
+    void draw(data::Buffer& buffer, uint32_t color) const;
+
+    /**
+     * @brief Gets the number of live particles.
+     */
+    size_t size() const;
+
+private:
+    static constexpr size_t NUM_DIRECTIONS = 64;
+
+    /**
+     * @brief Draws the next number from the scatter generator, xorshift32.
+     */
+    uint32_t nextRandom();
+
+    /**
+     * @brief Scatters particles from a point in random directions.
+     *
+     * @param x X-coordinate of the point, in pixels.
+     * @param y Y-coordinate of the point, in pixels.
+     * @param number Number of particles.
+     * @param minSpeed Slowest speed, fixed point.
+     * @param maxSpeed Fastest speed, fixed point.
+     * @param lift Added to every vertical velocity, fixed point.
+     * @param minLife Shortest life in steps.
+     * @param maxLife Longest life in steps.
+     */
+    void burst(
+        int32_t x, int32_t y, size_t number,
+        int32_t minSpeed, int32_t maxSpeed, int32_t lift,
+        int32_t minLife, int32_t maxLife
+    );
+
+    size_t width;
+    size_t height;
+    size_t capacity;
+    size_t count = 0;
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<int32_t> vx;
+    std::vector<int32_t> vy;
+    std::vector<int32_t> life;
+    std::vector<uint16_t> pixelX;
+    std::vector<uint16_t> pixelY;
+    std::array<int32_t, 2 * NUM_DIRECTIONS> directions;
+    uint32_t seed;
+    size_t tick = 0;
+    uint64_t impactsSeen = 0;
+};
+
+} // render
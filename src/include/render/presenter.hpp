@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "data/data.hpp"
+#include "sim/controls.hpp"
+
+namespace render {
+
+/**
+ * @brief Shows finished frames and collects input.
+ * @details The game rasterizes into a data::Buffer and hands every frame
+ *          to a presenter, which is the only part that knows about windows,
+ *          graphics APIs or the lack of them.
+ */
+class Presenter
+{
+public:
+    virtual ~Presenter() {}
+
+    /**
+     * @brief Shows a finished frame.
+     *
+     * @param buffer Buffer holding the frame.
+     * @param damage Regions that changed since the previous frame, see
+     *               Buffer::collectDamage.
+     */
+    virtual void present(data::Buffer& buffer, const std::vector<data::Region>& damage) = 0;
+
+    /**
+     * @brief Collects the input that came in since the last poll.
+     * @details Presses and releases are sent as they are seen, stamped
+     *          with the time they were seen.
+     *
+     * @param controls Writer the control events are sent to.
+     * @return bool False once the player asked to quit.
+     */
+    virtual bool pollInput(sim::ControlWriter& controls) = 0;
+};
+
+} // render
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include "data/data.hpp"
+
+namespace render {
+
+/**
+ * @brief Layout of the texture a buffer is presented through.
+ *
+ * @var internalFormat Internal format of the texture.
+ * @var format Format of the uploaded pixel data.
+ * @var type Type of the uploaded pixel data.
+ * @var width Width of the texture in texels.
+ * @var texelBytes Size of a texel in the uploaded data.
+ * @var argb Whether RGBA pixels are converted to ARGB while staging.
+ */
+struct TextureFormat {
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    size_t width;
+    size_t texelBytes;
+    bool argb;
+};
+
+/**
+ * @brief Picks the texture layout that stores a buffer without conversion.
+ * @details Compact formats upload their words as integer textures. RGBA
+ *          buffers ask the driver which layout it stores GL_RGBA8 in and
+ *          use GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV unless it prefers
+ *          the buffer's own layout, so the driver never has to swizzle.
+ *
+ * @param buffer Buffer to upload.
+ * @param native Whether to negotiate the driver's layout for RGBA
+ *               buffers instead of uploading them as they are.
+ * @return TextureFormat Texture description for the buffer's pixel format.
+ */
+TextureFormat textureFormatFor(data::Buffer& buffer, bool native);
+
+/**
+ * @brief Enumeration of the ways a TextureUploader gets pixels to GL.
+ *
+ * @var UPLOAD_DIRECT glTexSubImage2D straight from the buffer.
+ * @var UPLOAD_STREAMED Ring of pixel buffer slots mapped every frame.
+ * @var UPLOAD_PERSISTENT Ring of pixel buffer slots mapped once.
+ */
+enum UploadMode: uint8_t
+{
+    UPLOAD_DIRECT     = 0,
+    UPLOAD_STREAMED   = 1,
+    UPLOAD_PERSISTENT = 2
+};
+
+/**
+ * @brief Timings of the frames uploaded so far.
+ * @details Times are CPU time spent in upload, which is where a stalled
+ *          upload shows up.
+ *
+ * @var frames Number of frames that uploaded anything.
+ * @var bytes Total number of bytes uploaded.
+ * @var lastMicros Time of the most recent upload.
+ * @var totalMicros Time of all uploads.
+ * @var maxMicros Time of the slowest upload.
+ * @var busySlots Uploads that went direct because the next slot was
+ *      still in use by the GPU.
+ */
+struct UploadStats {
+    size_t frames;
+    size_t bytes;
+    double lastMicros;
+    double totalMicros;
+    double maxMicros;
+    size_t busySlots;
+};
+
+/**
+ * @brief Uploads changed regions of a buffer into the bound texture.
+ * @details The ring modes stage every frame in the next of a few slots of
+ *          one pixel unpack buffer and fence it. A slot is only written
+ *          again once its fence signalled, which is checked without
+ *          waiting, so the CPU never blocks on the GPU still reading it.
+ *          With ARB_buffer_storage the slots are mapped persistently,
+ *          otherwise each slot is mapped unsynchronized when it is used.
+ *
+ * @var texture Layout of the texture, see textureFormatFor.
+ * @var mode How pixels get to GL, see UploadMode.
+ * @var slotBytes Size of one slot, large enough for the whole buffer.
+ * @var unpackBuffer Pixel unpack buffer holding all slots.
+ * @var mapped Persistent mapping of unpackBuffer.
+ * @var fences Fence of the last upload from each slot.
+ * @var slot Slot the next frame is staged in.
+ * @var scratch Client memory frames are staged in without a free slot.
+ * @var stats Timings of the uploads so far.
+ */
+class TextureUploader
+{
+public:
+    /**
+     * @brief Creates the slots of the ring, if any.
+     * @details Needs a current GL context. Falls back to UPLOAD_STREAMED
+     *          when persistent mapping is not supported.
+     *
+     * @param buffer Buffer that will be uploaded.
+     * @param texture Layout of the texture, see textureFormatFor.
+     * @param ring Whether to stage uploads in a ring of slots.
+     * @param numSlots Number of slots in the ring.
+     */
+    TextureUploader(data::Buffer& buffer, const TextureFormat& texture, bool ring, size_t numSlots = 3);
+
+    /**
+     * @brief Deletes the unpack buffer and the pending fences.
+     */
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /**
+     * @brief Gets how pixels get to GL.
+     *
+     * @return UploadMode The mode picked at construction.
+     */
+    UploadMode getMode() const;
+
+    /**
+     * @brief Gets the timings of the uploads so far.
+     *
+     * @return const UploadStats& Timings of all frames.
+     */
+    const UploadStats& getStats() const;
+
+    /**
+     * @brief Uploads regions of the buffer into the bound texture.
+     *
+     * @param buffer Buffer to upload from.
+     * @param regions Regions of the buffer in pixels, see Buffer::collectDamage.
+     */
+    void upload(data::Buffer& buffer, const std::vector<data::Region>& regions);
+
+private:
+    /**
+     * @brief Uploads regions straight from the buffer's memory.
+     */
+    void uploadDirect(data::Buffer& buffer, const std::vector<data::Region>& regions);
+
+    /**
+     * @brief Stages regions in the current slot and uploads them from there.
+     * @details Stages in client memory instead when there is no ring or
+     *          the slot is still busy.
+     *
+     * @return size_t Number of bytes staged.
+     */
+    size_t uploadStaged(data::Buffer& buffer, const std::vector<data::Region>& regions);
+
+    TextureFormat texture;
+    UploadMode mode;
+    size_t slotBytes = 0;
+    GLuint unpackBuffer = 0;
+    uint8_t* mapped = nullptr;
+    std::vector<GLsync> fences;
+    size_t slot = 0;
+    std::vector<uint8_t> scratch;
+    UploadStats stats{};
+};
+
+} // render
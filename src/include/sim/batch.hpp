@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "data/data.hpp"
+#include "sim/collision_grid.hpp"
+#include "util/thread_pool.hpp"
+
+namespace sim {
+
+/**
+ * @brief Gives the input of one step of one game in a batch.
+ *
+ * @param index Number of the game in the batch.
+ * @param game State of the game before the step.
+ * @return data::Input Controls held during the step.
+ */
+using InputSource = std::function<data::Input(size_t index, const data::Game& game)>;
+
+/**
+ * @brief Input of a simple autopilot that differs from game to game.
+ * @details Sweeps the player back and forth and fires at a steady rate,
+ *          with a period and rate picked from the game's number, so the
+ *          games of a batch play differently but the same on every run.
+ *
+ * @param index Number of the game in the batch.
+ * @param game State of the game before the step.
+ * @return data::Input Controls held during the step.
+ */
+data::Input autopilotInput(size_t index, const data::Game& game);
+
+/**
+ * @brief Steps many independent games, spread across a thread pool.
+ * @details Every game has its own state, collision grid and optionally a
+ *          buffer it is drawn into after every step. Games never touch
+ *          each other, so they step in parallel without locks, one pool
+ *          task per game, and the pool's work stealing evens out games
+ *          that take longer. Runs are deterministic whatever the number
+ *          of threads as long as the input source is.
+ *
+ * @var input Source of every game's input.
+ * @var instances Every game of the batch.
+ * @var clearColor Color buffers are cleared with.
+ * @var color Color sprites are drawn with.
+ * @var frames Number of game frames stepped so far, over all games.
+ */
+class Batch
+{
+public:
+    /**
+     * @brief Constructs a batch of new games.
+     *
+     * @param numGames Number of games.
+     * @param width Width of every game area.
+     * @param height Height of every game area.
+     * @param render Whether every game is drawn into its own buffer.
+     * @param format Pixel format of the buffers.
+     */
+    Batch(
+        size_t numGames, size_t width, size_t height,
+        bool render = false, data::PixelFormat format = data::FORMAT_RGBA32
+    );
+
+    /**
+     * @brief Sets where the games get their input from.
+     *
+     * @param source Called once per game and step, from pool threads.
+     *               Calls for different games may run at the same time.
+     */
+    void setInputSource(InputSource source);
+
+    /**
+     * @brief Restarts every game.
+     */
+    void reset();
+
+    /**
+     * @brief Advances every game by a number of steps.
+     *
+     * @param steps Steps every game takes.
+     * @param pool Pool the games are spread across, null runs them on
+     *             the calling thread.
+     */
+    void run(size_t steps, util::ThreadPool* pool);
+
+    /**
+     * @brief Gets the number of games.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the state of a game.
+     *
+     * @param index Number of the game.
+     */
+    const data::Game& getGame(size_t index) const;
+
+    /**
+     * @brief Gets the buffer a game is drawn into.
+     *
+     * @param index Number of the game.
+     * @return const data::Buffer* The buffer, null without rendering.
+     */
+    const data::Buffer* getBuffer(size_t index) const;
+
+    /**
+     * @brief Gets the number of game frames stepped so far, over all games.
+     */
+    size_t getFrames() const;
+
+private:
+    /**
+     * @brief One game of the batch, on its own cache lines.
+     */
+    struct alignas(64) Instance {
+        data::Game game;
+        CollisionGrid grid;
+        std::unique_ptr<data::Buffer> buffer;
+    };
+
+    /**
+     * @brief Steps one game and draws it if it has a buffer.
+     */
+    void stepInstance(size_t index, size_t steps);
+
+    InputSource input;
+    std::vector<Instance> instances;
+    uint32_t clearColor;
+    uint32_t color;
+    size_t frames = 0;
+};
+
+} // sim
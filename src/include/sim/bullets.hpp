@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "data/data.hpp"
+
+namespace sim {
+
+/**
+ * @brief Puts a new bullet in flight.
+ * @details Takes the most recently freed slot, or the next slot never
+ *          used if none is free. Costs O(1) and allocates nothing.
+ *
+ * @param bullets Bullets of the game.
+ * @param x X-coordinate of the bullet.
+ * @param y Y-coordinate of the bullet's bottom row.
+ * @param dir Distance the bullet moves up per step, negative moves down.
+ * @param owner Who fires the bullet.
+ * @return data::BulletHandle Handle of the bullet, NO_BULLET if
+ *         GAME_MAX_BULLETS are in flight.
+ */
+data::BulletHandle spawnBullet(data::BulletStore& bullets, int16_t x, int16_t y, int8_t dir, data::BulletOwner owner);
+
+/**
+ * @brief Takes a bullet out of flight and frees its slot.
+ * @details The last bullet moves into entry bi, so a loop removing
+ *          bullets handles entry bi again instead of advancing.
+ *
+ * @param bullets Bullets of the game.
+ * @param bi Entry of the bullet, below bullets.count.
+ */
+void removeBullet(data::BulletStore& bullets, size_t bi);
+
+/**
+ * @brief Gets the handle of a bullet in flight.
+ *
+ * @param bullets Bullets of the game.
+ * @param bi Entry of the bullet, below bullets.count.
+ * @return data::BulletHandle Handle of the bullet.
+ */
+data::BulletHandle bulletHandle(const data::BulletStore& bullets, size_t bi);
+
+/**
+ * @brief Looks up the entry of a bullet from its handle.
+ *
+ * @param bullets Bullets of the game.
+ * @param handle Handle from spawnBullet or bulletHandle.
+ * @return size_t Entry of the bullet, bullets.count if it is spent.
+ */
+size_t findBullet(const data::BulletStore& bullets, data::BulletHandle handle);
+
+/**
+ * @brief Moves every bullet and drops the ones that left an area.
+ * @details Moving is a single pass over the packed positions, without
+ *          branches, so it vectorizes. Bullets whose bottom row ends up
+ *          outside [bottom, top) are removed in a second pass.
+ *
+ * @param bullets Bullets of the game.
+ * @param bottom Lowest bottom row a bullet may have.
+ * @param top Bottom row at which bullets are gone.
+ */
+void moveBullets(data::BulletStore& bullets, ptrdiff_t bottom, ptrdiff_t top);
+
+} // sim
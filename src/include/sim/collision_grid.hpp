@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+/**
+ * @brief Uniform grid of square cells telling which objects may touch an area.
+ * @details Every object is listed in each cell its bounding box overlaps.
+ *          Objects are added, moved and removed one at a time, moving only
+ *          touches the cells if the object crossed into other cells, so
+ *          keeping the grid up to date costs nothing for objects that sit
+ *          still. Positions may have wrapped below 0 like everywhere else,
+ *          anything outside the area lands in the border cells.
+ *
+ * @var cellSize Width and height of a cell in pixels.
+ * @var cols Number of cell columns.
+ * @var rows Number of cell rows.
+ * @var cells Objects listed in each cell, row after row.
+ * @var spans Cells each object is listed in.
+ * @var stamps Query an object was last visited in.
+ * @var stamp Number of the current query.
+ * @var count Number of objects in the grid.
+ */
+class CollisionGrid
+{
+public:
+    /**
+     * @brief Constructs an empty CollisionGrid.
+     *
+     * @param cellSize Width and height of a cell in pixels.
+     */
+    explicit CollisionGrid(size_t cellSize = 16);
+
+    /**
+     * @brief Removes all objects and sizes the grid for an area.
+     *
+     * @param width Width of the area in pixels.
+     * @param height Height of the area in pixels.
+     * @param capacity Objects are numbered from 0 up to capacity.
+     */
+    void reset(size_t width, size_t height, size_t capacity);
+
+    /**
+     * @brief Adds an object, or moves it if it is already in the grid.
+     *
+     * @param id Number of the object.
+     * @param x X-coordinate of the object's left column.
+     * @param y Y-coordinate of the object's bottom row.
+     * @param width Width of the object.
+     * @param height Height of the object.
+     */
+    void insert(size_t id, size_t x, size_t y, size_t width, size_t height);
+
+    /**
+     * @brief Removes an object, if it is in the grid.
+     *
+     * @param id Number of the object.
+     */
+    void remove(size_t id);
+
+    /**
+     * @brief Checks whether an object is in the grid.
+     *
+     * @param id Number of the object.
+     * @return bool True if the object was inserted and not removed since.
+     */
+    bool contains(size_t id) const;
+
+    /**
+     * @brief Gets the number of objects in the grid.
+     *
+     * @return size_t Number of objects.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Visits every object listed in the cells an area overlaps.
+     * @details Each object is visited once, even if it shares several
+     *          cells with the area. Objects may be visited that do not
+     *          overlap the area itself, the caller does the exact test.
+     *          The grid must not change during the query.
+     *
+     * @tparam Visit Callable taking the object's number.
+     * @param x X-coordinate of the area's left column.
+     * @param y Y-coordinate of the area's bottom row.
+     * @param width Width of the area.
+     * @param height Height of the area.
+     * @param visit Called with every candidate.
+     */
+    template<typename Visit>
+    void query(size_t x, size_t y, size_t width, size_t height, Visit visit)
+    {
+        Span span = cover(x, y, width, height);
+        if (++stamp == 0) {
+            // Stamps wrapped, forget every earlier query
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+        for (size_t ri = span.y0; ri <= span.y1; ++ri) {
+            for (size_t ci = span.x0; ci <= span.x1; ++ci) {
+                for (uint32_t id : cells[ri * cols + ci]) {
+                    if (stamps[id] != stamp) {
+                        stamps[id] = stamp;
+                        visit(static_cast<size_t>(id));
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Inclusive range of cells, x0 > x1 if the range is empty.
+     */
+    struct Span {
+        uint16_t x0;
+        uint16_t y0;
+        uint16_t x1;
+        uint16_t y1;
+    };
+
+    /**
+     * @brief Gets the cells a box overlaps, clamped to the grid.
+     */
+    Span cover(size_t x, size_t y, size_t width, size_t height) const;
+
+    /**
+     * @brief Lists or unlists an object in the cells of a span.
+     */
+    void link(size_t id, const Span& span);
+    void unlink(size_t id, const Span& span);
+
+    size_t cellSize;
+    size_t cols = 0;
+    size_t rows = 0;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<Span> spans;
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+    size_t count = 0;
+};
+
+} // sim
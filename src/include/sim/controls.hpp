@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "data/data.hpp"
+#include "util/spsc_queue.hpp"
+
+namespace sim {
+
+/**
+ * @brief Enumeration of the controls a player holds or presses.
+ *
+ * @var CONTROL_LEFT Moves the player left while held.
+ * @var CONTROL_RIGHT Moves the player right while held.
+ * @var CONTROL_FIRE Fires once per press.
+ * @var CONTROL_REWIND Runs time backwards while held.
+ */
+enum Control: uint8_t
+{
+    CONTROL_LEFT   = 0,
+    CONTROL_RIGHT  = 1,
+    CONTROL_FIRE   = 2,
+    CONTROL_REWIND = 3
+};
+
+constexpr size_t NUM_CONTROLS = 4;
+
+/**
+ * @brief A control pressed or released, stamped with when it was seen.
+ *
+ * @var time Steady clock time in nanoseconds, see inputClock.
+ * @var control Control that changed (see Control enum).
+ * @var pressed Whether it was pressed or released.
+ */
+struct ControlEvent {
+    int64_t time;
+    uint8_t control;
+    bool pressed;
+};
+
+/**
+ * @brief When an event was seen and the step that took it.
+ *
+ * @var time Steady clock time in nanoseconds the event was seen.
+ * @var step Number of the step, counted from 1, that took the event.
+ */
+struct InputStamp {
+    int64_t time;
+    size_t step;
+};
+
+/**
+ * @brief Events queued from the render thread to the simulation thread.
+ */
+using ControlQueue = util::SpscQueue<ControlEvent, 256>;
+
+/**
+ * @brief Stamps queued back from the simulation thread to the render thread.
+ */
+using StampQueue = util::SpscQueue<InputStamp, 1024>;
+
+/**
+ * @brief Gets the time events are stamped with.
+ *
+ * @return int64_t Steady clock time in nanoseconds.
+ */
+int64_t inputClock();
+
+/**
+ * @brief Writes control events into a queue. Writer thread only.
+ * @details Keeps which controls it has sent as held, so whole states of
+ *          the controls can be sent as the presses and releases that
+ *          lead to them. A full queue drops the event and counts it.
+ *
+ * @var queue Queue the events go to.
+ * @var held Whether each control was last sent as pressed.
+ * @var dropped Number of events the full queue refused.
+ */
+class ControlWriter
+{
+public:
+    /**
+     * @brief Constructs a ControlWriter.
+     *
+     * @param queue Queue the events go to, must outlive the writer.
+     */
+    explicit ControlWriter(ControlQueue& queue);
+
+    /**
+     * @brief Sends a press or release of a control.
+     *
+     * @param control Control that changed.
+     * @param pressed Whether it was pressed or released.
+     * @param time When it was seen, see inputClock.
+     */
+    void send(Control control, bool pressed, int64_t time);
+
+    /**
+     * @brief Sends the events that take the controls to a state.
+     * @details Movement and rewind are pressed or released as they differ
+     *          from what was sent before, fire is pressed once if set.
+     *          Taken by a ControlState on the other side, the step gets
+     *          exactly input's controls.
+     *
+     * @param input State to send, quit is ignored.
+     * @param time When it was seen, see inputClock.
+     */
+    void send(const data::Input& input, int64_t time);
+
+    /**
+     * @brief Gets the number of events dropped because the queue was full.
+     */
+    size_t getDropped() const;
+
+private:
+    ControlQueue& queue;
+    bool held[NUM_CONTROLS] = {};
+    size_t dropped = 0;
+};
+
+/**
+ * @brief Turns control events back into the controls of steps.
+ * @details A control counts for a step if it is held once the step's
+ *          events are applied or if it was pressed in between, so a press
+ *          and release between two steps still acts for one step. Every
+ *          fire press fires once, presses beyond one per step wait for
+ *          the following steps, up to MAX_PENDING_FIRES of them.
+ *
+ * @var held Whether each control is held.
+ * @var pressed Whether each control was pressed since the last step.
+ * @var fires Fire presses not taken by a step yet.
+ */
+class ControlState
+{
+public:
+    static constexpr uint8_t MAX_PENDING_FIRES = 4;
+
+    /**
+     * @brief Applies a press or release.
+     *
+     * @param event Event to apply.
+     */
+    void apply(const ControlEvent& event);
+
+    /**
+     * @brief Gets the controls of the next step and starts a new one.
+     *
+     * @return data::Input Controls of the step, quit is never set.
+     */
+    data::Input take();
+
+private:
+    bool held[NUM_CONTROLS] = {};
+    bool pressed[NUM_CONTROLS] = {};
+    uint8_t fires = 0;
+};
+
+/**
+ * @brief Distribution of latencies, in a fixed number of buckets.
+ * @details Buckets are log-linear, 16 per power of two, so any recorded
+ *          value is known to within 1/16th. Recording allocates nothing.
+ *
+ * @var buckets Number of values in each bucket.
+ * @var count Number of values recorded.
+ * @var total Sum of every value recorded.
+ * @var max Largest value recorded.
+ */
+class LatencyStats
+{
+public:
+    /**
+     * @brief Records a latency.
+     *
+     * @param nanos Latency in nanoseconds, negative values count as 0.
+     */
+    void record(int64_t nanos);
+
+    /**
+     * @brief Gets the number of latencies recorded.
+     */
+    size_t getCount() const;
+
+    /**
+     * @brief Gets the mean of every latency recorded.
+     *
+     * @return double Mean in microseconds, 0 if none was recorded.
+     */
+    double getMeanMicros() const;
+
+    /**
+     * @brief Gets the latency a share of the recorded ones are at or below.
+     *
+     * @param p Share between 0 and 1, 0.99 for the 99th percentile.
+     * @return double Upper edge of the bucket holding it, capped at the
+     *         largest latency, in microseconds, 0 if none was recorded.
+     */
+    double getPercentileMicros(double p) const;
+
+private:
+    static constexpr size_t SUB_BUCKETS = 16;
+    static constexpr size_t NUM_BUCKETS = 61 * SUB_BUCKETS;
+
+    uint32_t buckets[NUM_BUCKETS] = {};
+    size_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+};
+
+} // sim
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data/data.hpp"
+#include "sim/collision_grid.hpp"
+
+namespace sim {
+
+/**
+ * @brief Enumeration of the controls an agent can hold for a step.
+ *
+ * @var ACTION_NOOP Do nothing.
+ * @var ACTION_LEFT Move left.
+ * @var ACTION_RIGHT Move right.
+ * @var ACTION_FIRE Fire without moving.
+ * @var ACTION_LEFT_FIRE Move left and fire.
+ * @var ACTION_RIGHT_FIRE Move right and fire.
+ * @var NUM_ACTIONS Number of actions.
+ */
+enum Action: uint8_t
+{
+    ACTION_NOOP       = 0,
+    ACTION_LEFT       = 1,
+    ACTION_RIGHT      = 2,
+    ACTION_FIRE       = 3,
+    ACTION_LEFT_FIRE  = 4,
+    ACTION_RIGHT_FIRE = 5,
+    NUM_ACTIONS       = 6
+};
+
+/**
+ * @brief Enumeration of the pixel observations an Env can hand out.
+ *
+ * @var OBSERVATION_NONE No pixels, only the feature vector. Nothing is drawn.
+ * @var OBSERVATION_FRAME The frame buffer itself, in the configured format.
+ * @var OBSERVATION_PACKED One bit per block of downsample x downsample
+ *      pixels, set when any pixel of the block is lit.
+ */
+enum ObservationMode: uint8_t
+{
+    OBSERVATION_NONE   = 0,
+    OBSERVATION_FRAME  = 1,
+    OBSERVATION_PACKED = 2
+};
+
+/**
+ * @brief Number of entries of the feature vector.
+ */
+constexpr size_t FEATURE_COLUMNS = 16;
+constexpr size_t NUM_FEATURES = 6 + FEATURE_COLUMNS;
+
+/**
+ * @brief Settings of an Env.
+ *
+ * @var observation Pixels handed out with every step.
+ * @var format Pixel format of OBSERVATION_FRAME. OBSERVATION_PACKED
+ *      always draws in FORMAT_MONO1.
+ * @var downsample Size of the blocks OBSERVATION_PACKED reduces to a bit.
+ * @var frameSkip Game steps an action is held for, their rewards add up.
+ * @var maxSteps Game steps after which an episode ends, 0 for no limit.
+ * @var maxNoopSteps reset idles for up to this many steps, picked from
+ *      the seed, so episodes do not all start from the same state.
+ */
+struct EnvConfig {
+    ObservationMode observation = OBSERVATION_FRAME;
+    data::PixelFormat format = data::FORMAT_RGBA32;
+    size_t downsample = 2;
+    size_t frameSkip = 1;
+    size_t maxSteps = 0;
+    size_t maxNoopSteps = 30;
+};
+
+/**
+ * @brief A view of the pixels of an observation, valid until the next
+ *        step or reset.
+ * @details Rows are stored bottom up, stride words apart. RGBA32 rows
+ *          hold a pixel per word, INDEXED8 rows four palette indices per
+ *          word and MONO1 rows 32 pixels per word, pixel xi in bit xi % 32.
+ *
+ * @var pixels First word of the bottom row, null without pixels.
+ * @var width Width in pixels.
+ * @var height Height in pixels.
+ * @var stride Number of 32-bit words per row.
+ * @var format Layout of the pixels.
+ */
+struct Observation {
+    const uint32_t* pixels;
+    size_t width;
+    size_t height;
+    size_t stride;
+    data::PixelFormat format;
+};
+
+/**
+ * @brief Result of reset or step, valid until the next step or reset.
+ *
+ * @var reward Points scored during the step.
+ * @var done Whether the episode is over, further steps need a reset.
+ * @var observation Pixels after the step.
+ * @var features NUM_FEATURES values after the step, each within [-1, 1].
+ */
+struct StepResult {
+    float reward;
+    bool done;
+    Observation observation;
+    const float* features;
+};
+
+/**
+ * @brief The game behind a reset and step interface, for agents and tests.
+ * @details An Env owns its game and buffer and allocates nothing after
+ *          construction. Observations point into memory the Env owns, so
+ *          handing them out copies nothing. Episodes are deterministic
+ *          for a seed and a sequence of actions. Envs share no state, any
+ *          number of them can run on different threads.
+ *
+ *          The features are, in order: the player's x, the share of
+ *          aliens alive, the share of bullet slots in flight, the lowest
+ *          living alien's bottom row, the horizontal distance from the
+ *          player to the closest living alien and that alien's bottom
+ *          row, then for each of FEATURE_COLUMNS columns of the screen
+ *          the bottom row of its lowest living alien, 1 for none.
+ *          Positions are divided by the game's width or height.
+ *
+ * @var config Settings the Env was created with.
+ * @var game State of the game.
+ * @var grid Living aliens of game, see buildAlienGrid.
+ * @var buffer Frame the game is drawn into, unused without pixels.
+ * @var packed Words of the downsampled observation.
+ * @var dirtyBegin First changed block of each packed row.
+ * @var dirtyEnd One past the last changed block of each packed row.
+ * @var rowOr Rows of a block ORed together.
+ * @var compactMasks Masks of the steps of compactBlocks.
+ * @var features Feature vector of the latest state.
+ * @var steps Game steps taken in this episode.
+ * @var clearColor Color the background is drawn in.
+ * @var color Color the sprites are drawn in.
+ */
+class Env
+{
+public:
+    /**
+     * @brief Constructs an Env, reset with seed 0.
+     *
+     * @param config Settings of the Env.
+     */
+    explicit Env(const EnvConfig& config = EnvConfig{});
+
+    /**
+     * @brief Starts a new episode.
+     *
+     * @param seed Picks the player's start column and the idle steps.
+     * @return StepResult The first observation, with no reward.
+     */
+    StepResult reset(uint64_t seed);
+
+    /**
+     * @brief Holds an action for config.frameSkip game steps.
+     *
+     * @param action Controls to hold, values past NUM_ACTIONS act as ACTION_NOOP.
+     * @return StepResult Reward, end of episode and observation.
+     */
+    StepResult step(uint8_t action);
+
+    /**
+     * @brief Gets the state of the game.
+     */
+    const data::Game& getGame() const;
+
+private:
+    /**
+     * @brief Draws the game and fills the observation and features.
+     */
+    StepResult observe(float reward);
+
+    /**
+     * @brief Downsamples the damaged parts of the mono buffer into packed.
+     */
+    void pack(const std::vector<data::Region>& damage);
+
+    /**
+     * @brief Reduces each block of a word of mono pixels to a bit.
+     * @details Only for power of two blocks. Bit bi of the result is set
+     *          when any pixel of block bi is lit.
+     */
+    uint32_t compactBlocks(uint32_t bits) const;
+
+    /**
+     * @brief Computes the feature vector of the game.
+     */
+    void computeFeatures();
+
+    /**
+     * @brief Checks whether the episode is over.
+     */
+    bool isDone() const;
+
+    EnvConfig config;
+    data::Game game;
+    CollisionGrid grid;
+    data::Buffer buffer;
+    std::vector<uint32_t> packed;
+    std::vector<size_t> dirtyBegin;
+    std::vector<size_t> dirtyEnd;
+    std::vector<uint32_t> rowOr;
+    std::array<uint32_t, 6> compactMasks{};
+    std::array<float, NUM_FEATURES> features;
+    size_t steps = 0;
+    uint32_t clearColor;
+    uint32_t color;
+};
+
+} // sim
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include "data/data.hpp"
+#include "sim/collision_grid.hpp"
+
+namespace sim {
+
+/**
+ * @brief Sets up a new game with the full alien grid and the player.
+ *
+ * @param game Game to set up, every field is overwritten.
+ * @param width Width of the game area.
+ * @param height Height of the game area.
+ */
+void newGame(data::Game& game, size_t width, size_t height);
+
+/**
+ * @brief Lists the living aliens of a game in a collision grid.
+ * @details Needed once for a new game and again whenever the game is
+ *          replaced by a copy, step keeps the grid up to date otherwise.
+ *          Aliens are listed at their offsets in the formation, so the
+ *          grid does not change when the formation marches.
+ *
+ * @param grid Grid to fill, emptied first.
+ * @param game Game whose aliens are listed.
+ */
+void buildAlienGrid(CollisionGrid& grid, const data::Game& game);
+
+/**
+ * @brief Gets the box around the living aliens of a game.
+ * @details Follows from the formation's origin and extents alone.
+ *
+ * @param game Game whose aliens are boxed.
+ * @return data::Region Box in screen coordinates, empty if none live.
+ */
+data::Region formationBounds(const data::Game& game);
+
+/**
+ * @brief Gets the alien that fires from a column of the formation.
+ * @details The lowest living alien of the column, looked up without
+ *          scanning the column.
+ *
+ * @param game Game whose formation is looked at.
+ * @param column Column of the formation.
+ * @return size_t Number of the alien, game.aliens.count if none lives.
+ */
+size_t columnShooter(const data::Game& game, size_t column);
+
+/**
+ * @brief Advances the game by one fixed step.
+ * @details Everything that moves does so by a fixed amount per step, so
+ *          the game runs at the same speed whatever rate it is stepped at.
+ *          The formation marches a step whenever its timer runs out and
+ *          fires whenever its fire timer does, see data::AlienFire.
+ *          Player bullets are only tested against the aliens listed in
+ *          the grid cells they overlap, and only once they reach the box
+ *          of the living aliens, alien bullets only against the player.
+ *          Every alien's animation moves on a tick and the frame it
+ *          shows is stored with it, see data::AlienStore::frame.
+ *
+ * @param game Game to advance.
+ * @param input Controls held during the step.
+ * @param grid Living aliens of the game, see buildAlienGrid.
+ */
+void step(data::Game& game, const data::Input& input, CollisionGrid& grid);
+
+/**
+ * @brief Blends the positions of two snapshots of a game.
+ * @details Everything but positions comes from current. The formation
+ *          and the player move linearly between the snapshots, a drop of
+ *          the formation snaps to current. Bullets are matched to
+ *          previous by handle and blended the same way. A bullet fired
+ *          after previous is drawn at its current height and moved with
+ *          the blended player or formation that fired it.
+ *
+ * @param previous Older snapshot.
+ * @param current Newer snapshot.
+ * @param alpha Position between the snapshots, 0 is previous, 1 is current.
+ * @param out Blended game.
+ */
+void interpolate(const data::Game& previous, const data::Game& current, double alpha, data::Game& out);
+
+} // sim
@@ -0,0 +1,228 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "data/data.hpp"
+
+namespace sim {
+
+/**
+ * @brief Version of the replay file layout written by InputRecorder.
+ * @details A replay file starts with a header of the magic "SIRP", the
+ *          version and reserved field as 16-bit words and the width,
+ *          height, hash interval and REPLAY_STATE_SIZE as 32-bit words.
+ *          Records follow, each a varint of the steps since the previous
+ *          record shifted left by one, with the low bit set for a hash
+ *          record. An input record is followed by a byte of moveDir + 1 in
+ *          the low two bits, fire in bit 2 and rewind in bit 3, the
+ *          controls from its step on. A hash record is followed by the
+ *          64-bit hashGame of the state after its step. Numbers are little
+ *          endian. Version 1 files hashed an older data::Game and version
+ *          2 files rewound through a shorter history, both are rejected.
+ */
+constexpr uint16_t REPLAY_FILE_VERSION = 3;
+
+/**
+ * @brief Number of bytes of game state hashGame covers, all but the
+ *        impact log.
+ * @details Recorded hashes only verify against a state of the same layout,
+ *          so a file whose header holds a different size is rejected on
+ *          open instead of diverging on its first hash.
+ */
+constexpr uint32_t REPLAY_STATE_SIZE = sizeof(data::Game) - sizeof(data::ImpactLog);
+
+/**
+ * @brief Header of a replay file.
+ *
+ * @var width Width of the game.
+ * @var height Height of the game.
+ * @var hashInterval Number of steps from one state hash to the next.
+ */
+struct ReplayHeader {
+    uint32_t width;
+    uint32_t height;
+    uint32_t hashInterval;
+};
+
+/**
+ * @brief Controls that changed at a step.
+ *
+ * @var step Index of the first step taken with input.
+ * @var input Controls from step on.
+ */
+struct InputEvent {
+    uint64_t step;
+    data::Input input;
+};
+
+/**
+ * @brief Hash of the game after a step.
+ *
+ * @var step Index of the step.
+ * @var hash hashGame of the state after it.
+ */
+struct StateHash {
+    uint64_t step;
+    uint64_t hash;
+};
+
+/**
+ * @brief Hashes the state of a game that steps depend on.
+ * @details A data::Game has no padding, so equal states hash equal. The
+ *          impact log only feeds effects and is left out wherever it
+ *          sits, so changing what effects are logged keeps recorded hashes
+ *          valid.
+ *
+ * @param game Game to hash.
+ * @return uint64_t Hash of game.
+ */
+uint64_t hashGame(const data::Game& game);
+
+/**
+ * @brief Records the controls every step of a game takes into a replay file.
+ * @details Only changes of the controls are stored, along with a hash of
+ *          the state every hashInterval steps, so a replay can be checked
+ *          step by step. Writes go through stdio and only happen on the
+ *          thread that steps the game.
+ *
+ * @var file The open replay file.
+ * @var header Header of the file.
+ * @var last Controls of the previous step.
+ * @var steps Number of steps recorded.
+ * @var recordStep Step of the last record written.
+ * @var lastHash Hash of the state after the last step.
+ * @var hashed Whether the last step's hash was written.
+ */
+class InputRecorder
+{
+public:
+    InputRecorder() = default;
+
+    /**
+     * @brief Closes the file.
+     */
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /**
+     * @brief Creates a replay file and writes its header.
+     *
+     * @param path Path of the file.
+     * @param header Size of the game and hash interval, 0 hashes every step.
+     * @return bool False if the file cannot be written.
+     */
+    bool open(const std::string& path, const ReplayHeader& header);
+
+    /**
+     * @brief Records a step.
+     *
+     * @param input Controls the step was taken with.
+     * @param game State after the step.
+     */
+    void record(const data::Input& input, const data::Game& game);
+
+    /**
+     * @brief Writes the hash of the last step and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether steps are being recorded.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Gets the number of steps recorded.
+     */
+    uint64_t getSteps() const;
+
+private:
+    /**
+     * @brief Writes a record, closes the file on failure.
+     *
+     * @param step Step of the record.
+     * @param hash Whether it is a hash record.
+     * @param payload Bytes following the record.
+     * @param size Number of bytes of payload.
+     */
+    void write(uint64_t step, bool hash, const uint8_t* payload, size_t size);
+
+    FILE* file = nullptr;
+    ReplayHeader header{};
+    data::Input last{};
+    uint64_t steps = 0;
+    uint64_t recordStep = 0;
+    uint64_t lastHash = 0;
+    bool hashed = false;
+};
+
+/**
+ * @brief Reads a replay file and hands its controls back out step by step.
+ * @details The whole file is read and decoded on open. input keeps a
+ *          cursor, it is fastest when steps go up one at a time.
+ *
+ * @var header Header of the file.
+ * @var events Every change of the controls, in order.
+ * @var hashes Every state hash, in order.
+ * @var steps Number of steps recorded.
+ * @var nextEvent First event after the last step asked for.
+ */
+class InputReplay
+{
+public:
+    /**
+     * @brief Reads a replay file.
+     * @details A truncated last record, as left by a crash, is ignored.
+     *
+     * @param path Path of the file.
+     * @return bool False if the file cannot be read, is no replay file or
+     *         was recorded with another version or state layout.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Gets the header of the file.
+     */
+    const ReplayHeader& getHeader() const;
+
+    /**
+     * @brief Gets the number of steps recorded.
+     */
+    uint64_t getSteps() const;
+
+    /**
+     * @brief Gets the state hashes of the file.
+     *
+     * @return const std::vector<StateHash>& Every hash, in order.
+     */
+    const std::vector<StateHash>& getHashes() const;
+
+    /**
+     * @brief Gets the controls of a step.
+     *
+     * @param step Index of the step.
+     * @return data::Input Controls the step was recorded with.
+     */
+    data::Input input(uint64_t step);
+
+    /**
+     * @brief Gets the hash recorded for a step.
+     *
+     * @param step Index of the step.
+     * @return const StateHash* The hash, nullptr if there is none.
+     */
+    const StateHash* findHash(uint64_t step) const;
+
+private:
+    ReplayHeader header{};
+    std::vector<InputEvent> events;
+    std::vector<StateHash> hashes;
+    uint64_t steps = 0;
+    size_t nextEvent = 0;
+};
+
+} // sim
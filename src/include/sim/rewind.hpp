@@ -0,0 +1,156 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data/data.hpp"
+
+namespace sim {
+
+/**
+ * @brief Memory used by a RewindBuffer.
+ *
+ * @var snapshots Number of states held.
+ * @var payloadBytes Bytes the encoded states take up.
+ * @var capacityBytes Bytes reserved for encoded states.
+ * @var totalBytes Everything the buffer allocated.
+ */
+struct RewindStats {
+    size_t snapshots;
+    size_t payloadBytes;
+    size_t capacityBytes;
+    size_t totalBytes;
+};
+
+/**
+ * @brief Keeps the latest states of a game in a fixed amount of memory.
+ * @details Every pushed state is XORed with the one before it, 64 bits at
+ *          a time, and only the words that changed are stored. Every
+ *          keyInterval-th state is a keyframe, XORed with zeros, so a
+ *          restore decodes at most keyInterval states. A data::Game holds
+ *          the whole state, animations and death timers included, and has
+ *          no padding, so equal states encode to nothing.
+ *
+ *          Encoded states live in a byte ring allocated once. When a new
+ *          state does not fit, or the entry ring is full, the oldest
+ *          states are dropped a keyframe interval at a time, so the ring
+ *          never holds deltas without their keyframe.
+ *
+ *          An encoded state is a list of tokens, each a varint number of
+ *          unchanged words to skip, a varint number of changed words and
+ *          the XOR of those words.
+ *
+ * @var keyInterval Number of states from one keyframe to the next.
+ * @var bytes Ring of encoded states.
+ * @var entries Ring of the locations of the states, oldest first.
+ * @var first Index in entries of the oldest state.
+ * @var count Number of states held.
+ * @var head Offset in bytes the next state is written to.
+ * @var payload Bytes taken up by the states held.
+ * @var sinceKey States pushed since the last keyframe.
+ * @var latest Newest state, the base of the next delta.
+ * @var scratch Encoded state before it is copied into the ring.
+ */
+class RewindBuffer
+{
+public:
+    /**
+     * @brief Constructs a RewindBuffer.
+     *
+     * @details The key interval is shrunk until two intervals of full
+     *          states fit in maxBytes, so a new state always finds room
+     *          after the oldest interval is dropped.
+     *
+     * @param maxSnapshots States held at least once that many were
+     *        pushed, as long as they fit in maxBytes. Up to keyInterval
+     *        more are held before the oldest interval is dropped.
+     * @param maxBytes Bytes reserved for encoded states, raised only when
+     *        below two full states.
+     * @param keyInterval Most states from one keyframe to the next.
+     */
+    RewindBuffer(size_t maxSnapshots, size_t maxBytes, size_t keyInterval = 60);
+
+    /**
+     * @brief Drops every state.
+     */
+    void clear();
+
+    /**
+     * @brief Stores a state as the newest.
+     *
+     * @param game State to store.
+     */
+    void push(const data::Game& game);
+
+    /**
+     * @brief Decodes a stored state.
+     *
+     * @param back Number of states back from the newest, 0 for the newest.
+     * @param game Set to the state.
+     * @return bool False if fewer than back + 1 states are held.
+     */
+    bool restore(size_t back, data::Game& game) const;
+
+    /**
+     * @brief Drops the newest state and hands out the one before it.
+     * @details The state handed out becomes the newest, so pushing after
+     *          a pop continues from it.
+     *
+     * @param game Set to the new newest state.
+     * @return bool False, leaving everything as is, if fewer than two
+     *         states are held.
+     */
+    bool pop(data::Game& game);
+
+    /**
+     * @brief Gets the number of states held.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the memory in use and reserved.
+     */
+    RewindStats getStats() const;
+
+private:
+    /**
+     * @brief Location of an encoded state.
+     *
+     * @var offset Offset of the state in bytes.
+     * @var size Size of the state in bytes.
+     * @var key Whether the state is a keyframe.
+     */
+    struct Entry {
+        size_t offset;
+        uint32_t size;
+        bool key;
+    };
+
+    /**
+     * @brief Gets the entry of the index-th oldest state.
+     */
+    const Entry& entry(size_t index) const;
+
+    /**
+     * @brief Makes room for size bytes at head, dropping the oldest
+     *        states as needed.
+     */
+    void reserve(size_t size);
+
+    /**
+     * @brief Drops the oldest keyframe and the deltas that depend on it.
+     */
+    void dropOldest();
+
+    size_t keyInterval;
+    std::vector<uint8_t> bytes;
+    std::vector<Entry> entries;
+    size_t first = 0;
+    size_t count = 0;
+    size_t head = 0;
+    size_t payload = 0;
+    size_t sinceKey = 0;
+    data::Game latest{};
+    std::vector<uint8_t> scratch;
+};
+
+} // sim
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include "data/collision_mask.hpp"
+#include "data/data.hpp"
+
+namespace sim {
+
+/**
+ * @brief Puts up the four shields undamaged, spread across the screen.
+ *
+ * @param shields Shields to set up.
+ * @param width Width of the game area.
+ * @param y Y-coordinate of the shields' bottom row.
+ */
+void resetShields(data::ShieldStore& shields, size_t width, size_t y);
+
+/**
+ * @brief Gets a bank of a shield as a sprite, to draw or test it.
+ * @details The sprite points into shields and changes with it.
+ *
+ * @param shields Shields of the game.
+ * @param si Number of the shield.
+ * @param bank Number of the bank, see data::ShieldStore.
+ * @return data::PackedSprite The bank, drawn PACKED_MAX_WIDTH * bank
+ *         pixels right of the shield.
+ */
+data::PackedSprite shieldBank(const data::ShieldStore& shields, size_t si, size_t bank);
+
+/**
+ * @brief Finds the shield a sprite touches with a lit pixel.
+ * @details The same narrow phase as masksOverlap, with the shield's
+ *          packed rows in place of a second mask: every row of the mask
+ *          is shifted into place and ANDed with the shield's row.
+ *
+ * @param shields Shields of the game.
+ * @param mask Lit pixels of the sprite to test, such as BULLET_MASK.
+ * @param x X-coordinate of the sprite's left column.
+ * @param y Y-coordinate of the sprite's bottom row.
+ * @return size_t Number of the shield, SHIELD_COUNT if none is hit.
+ */
+size_t hitShield(const data::ShieldStore& shields, const data::CollisionMask& mask, size_t x, size_t y);
+
+/**
+ * @brief Clears the pixels of a shield under the lit pixels of a sprite.
+ * @details Each row takes one AND with the shifted, inverted sprite row.
+ *
+ * @param shields Shields of the game.
+ * @param si Number of the shield.
+ * @param sprite Pixels to clear, such as sprites::SHIELD_CRATER.
+ * @param x X-coordinate of the sprite's left column.
+ * @param y Y-coordinate of the sprite's bottom row.
+ */
+void erodeShield(data::ShieldStore& shields, size_t si, const data::PackedSprite& sprite, size_t x, size_t y);
+
+/**
+ * @brief Clears every shield pixel within a box.
+ *
+ * @param shields Shields of the game.
+ * @param box Area to clear.
+ */
+void clearShields(data::ShieldStore& shields, const data::Region& box);
+
+} // sim
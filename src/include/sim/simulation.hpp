@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include "data/data.hpp"
+#include "sim/collision_grid.hpp"
+#include "sim/controls.hpp"
+#include "sim/replay.hpp"
+#include "sim/rewind.hpp"
+#include "util/triple_buffer.hpp"
+
+namespace sim {
+
+/**
+ * @brief A published state of the game.
+ *
+ * @var game State of the game after a step.
+ * @var time When the step was due, steps are stamped with their place
+ *      on the fixed schedule rather than when they finished.
+ * @var step Number of the step, counted from 1, 0 for the initial state.
+ */
+struct Snapshot {
+    data::Game game;
+    std::chrono::steady_clock::time_point time;
+    size_t step;
+};
+
+/**
+ * @brief Steps a game at a fixed rate and hands its states to the renderer.
+ * @details Once started, a thread steps the game on a fixed schedule and
+ *          publishes a Snapshot after every step through a triple buffer.
+ *          The render thread never waits for the simulation and the
+ *          simulation never waits for a frame, a slow frame only means
+ *          some snapshots are never drawn. The renderer draws one step in
+ *          the past, blending the two latest snapshots it has seen, so
+ *          motion stays smooth at any refresh rate.
+ *
+ *          Without start the game only advances through step, once per
+ *          call, which keeps headless runs deterministic and uncapped.
+ *
+ *          Controls reach the simulation as timestamped presses and
+ *          releases through a lock-free queue, drained at the start of
+ *          every step, so none are lost or merged between steps. The
+ *          stamps of the events a step took travel back to the renderer,
+ *          which records the time from each event to the swap of the
+ *          first frame showing its step.
+ *
+ * @var stepDuration Time between two steps.
+ * @var game State the simulation thread steps, owned by it while running.
+ * @var grid Living aliens of game, see buildAlienGrid.
+ * @var snapshots Hands snapshots from the simulation to the renderer.
+ * @var controlQueue Control events from the renderer.
+ * @var controls Writes into controlQueue, render thread only.
+ * @var controlState Controls held, simulation side.
+ * @var stamps Stamps of the events taken, back to the renderer.
+ * @var latency Time from events to the frames showing them.
+ * @var recorder Records the controls of every step, if set.
+ * @var rewind Latest states, steps taken while rewind is held go back
+ *      through them instead of forward.
+ * @var running Whether the simulation thread should keep going.
+ * @var thread The simulation thread.
+ * @var previous Second latest snapshot the renderer has seen.
+ * @var current Latest snapshot the renderer has seen.
+ * @var blended Game handed out by frame.
+ * @var steps Number of steps taken.
+ * @var droppedSteps Steps skipped after the thread fell far behind.
+ */
+class Simulation
+{
+public:
+    /**
+     * @brief Constructs a Simulation.
+     *
+     * @param initial State to start stepping from.
+     * @param rate Steps per second when running on the simulation thread.
+     */
+    Simulation(const data::Game& initial, double rate = 60.0);
+
+    /**
+     * @brief Stops the simulation thread, if running.
+     */
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * @brief Starts stepping the game on its own thread.
+     */
+    void start();
+
+    /**
+     * @brief Stops and joins the simulation thread.
+     */
+    void stop();
+
+    /**
+     * @brief Gets the writer presenters send control events to. Render thread only.
+     *
+     * @return ControlWriter& Writer into the queue the next step drains.
+     */
+    ControlWriter& getControls();
+
+    /**
+     * @brief Hands a whole state of the controls to the simulation.
+     * @details Sent as the presses and releases that lead to it, so the
+     *          next step takes exactly these controls unless other events
+     *          follow. Replays set every step's controls this way.
+     *
+     * @param input Controls for the next step.
+     */
+    void setInput(const data::Input& input);
+
+    /**
+     * @brief Records the controls every following step takes.
+     * @details Only valid while the simulation thread is not running. The
+     *          recorder is written from whichever thread steps the game.
+     *
+     * @param recorder Open recorder, nullptr to stop recording.
+     */
+    void setRecorder(InputRecorder* recorder);
+
+    /**
+     * @brief Keeps the latest states, so holding rewind can step back.
+     * @details Only valid while the simulation thread is not running.
+     *          The buffer is cleared and filled from whichever thread
+     *          steps the game.
+     *
+     * @param rewind Buffer to keep states in, nullptr to keep none.
+     */
+    void setRewind(RewindBuffer* rewind);
+
+    /**
+     * @brief Takes one step on the calling thread and publishes it.
+     * @details Only valid while the simulation thread is not running.
+     */
+    void step();
+
+    /**
+     * @brief Gets the game state to draw now. Render thread only.
+     * @details Blends the two latest snapshots while the simulation thread
+     *          runs, otherwise returns the latest step.
+     *
+     * @return const data::Game& Game to draw, valid until the next call.
+     */
+    const data::Game& frame();
+
+    /**
+     * @brief Records the latency of the events the last frame showed. Render thread only.
+     * @details To be called once the frame handed out by frame() was
+     *          swapped to the screen.
+     */
+    void presented();
+
+    /**
+     * @brief Gets the time from control events to the frames showing them.
+     *
+     * @return const LatencyStats& Latencies recorded by presented.
+     */
+    const LatencyStats& getInputLatency() const;
+
+    /**
+     * @brief Gets the number of steps taken.
+     *
+     * @return size_t Steps taken on either thread.
+     */
+    size_t getSteps() const;
+
+    /**
+     * @brief Gets the number of steps given up on after falling behind.
+     *
+     * @return size_t Steps skipped by the simulation thread.
+     */
+    size_t getDroppedSteps() const;
+
+private:
+    /**
+     * @brief Steps the game and publishes the result.
+     *
+     * @param time Time the step was due.
+     */
+    void advance(std::chrono::steady_clock::time_point time);
+
+    /**
+     * @brief Main loop of the simulation thread.
+     */
+    void run();
+
+    std::chrono::steady_clock::duration stepDuration;
+    data::Game game;
+    CollisionGrid grid;
+    util::TripleBuffer<Snapshot> snapshots;
+    ControlQueue controlQueue;
+    ControlWriter controls{controlQueue};
+    ControlState controlState;
+    StampQueue stamps;
+    LatencyStats latency;
+    InputRecorder* recorder = nullptr;
+    RewindBuffer* rewind = nullptr;
+    std::atomic<bool> running{false};
+    std::thread thread;
+    Snapshot previous;
+    Snapshot current;
+    data::Game blended;
+    std::atomic<size_t> steps{0};
+    std::atomic<size_t> droppedSteps{0};
+};
+
+} // sim
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include "data/collision_mask.hpp"
 #include "data/data.hpp"
+#include "data/draw_list.hpp"
 
 namespace sprites {
-constexpr uint8_t ALIEN_SPRITE_1[] = {
+inline constexpr uint8_t ALIEN_SPRITE_1[] = {
     0,0,0,1,1,0,0,0, // ...@@...
     0,0,1,1,1,1,0,0, // ..@@@@..
     0,1,1,1,1,1,1,0, // .@@@@@@.
@@ -15,7 +17,7 @@ constexpr uint8_t ALIEN_SPRITE_1[] = {
     0,1,0,0,0,0,1,0  // .@....@.
 };
 
-constexpr uint8_t ALIEN_SPRITE_2[] = {
+inline constexpr uint8_t ALIEN_SPRITE_2[] = {
     0,0,0,1,1,0,0,0, // ...@@...
     0,0,1,1,1,1,0,0, // ..@@@@..
     0,1,1,1,1,1,1,0, // .@@@@@@.
@@ -26,7 +28,7 @@ constexpr uint8_t ALIEN_SPRITE_2[] = {
     1,0,1,0,0,1,0,1  // @.@..@.@
 };
 
-constexpr uint8_t ALIEN_SPRITE_3[] = {
+inline constexpr uint8_t ALIEN_SPRITE_3[] = {
     0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
     0,0,0,1,0,0,0,1,0,0,0, // ...@...@...
     0,0,1,1,1,1,1,1,1,0,0, // ..@@@@@@@..
@@ -37,7 +39,7 @@ constexpr uint8_t ALIEN_SPRITE_3[] = {
     0,0,0,1,1,0,1,1,0,0,0  // ...@@.@@...
 };
 
-constexpr uint8_t ALIEN_SPRITE_4[] = {
+inline constexpr uint8_t ALIEN_SPRITE_4[] = {
     0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
     1,0,0,1,0,0,0,1,0,0,1, // @..@...@..@
     1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
@@ -48,7 +50,7 @@ constexpr uint8_t ALIEN_SPRITE_4[] = {
     0,1,0,0,0,0,0,0,0,1,0  // .@.......@.
 };
 
-constexpr uint8_t ALIEN_SPRITE_5[] = {
+inline constexpr uint8_t ALIEN_SPRITE_5[] = {
     0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
     0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
     1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
@@ -59,7 +61,7 @@ constexpr uint8_t ALIEN_SPRITE_5[] = {
     1,1,0,0,0,0,0,0,0,0,1,1  // @@........@@
 };
 
-constexpr uint8_t ALIEN_SPRITE_6[] = {
+inline constexpr uint8_t ALIEN_SPRITE_6[] = {
     0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
     0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
     1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
@@ -70,7 +72,7 @@ constexpr uint8_t ALIEN_SPRITE_6[] = {
     0,0,1,1,0,0,0,0,1,1,0,0  // ..@@....@@..
 };
 
-constexpr uint8_t ALIEN_DEATH[] = {
+inline constexpr uint8_t ALIEN_DEATH[] = {
     0,1,0,0,1,0,0,0,1,0,0,1,0, // .@..@...@..@.
     0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
     0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
@@ -80,11 +82,58 @@ constexpr uint8_t ALIEN_DEATH[] = {
     0,1,0,0,1,0,0,0,1,0,0,1,0  // .@..@...@..@.
 };
 
+inline constexpr auto ALIEN_SPRITE_1_PACKED = data::packSprite<8, 8>(ALIEN_SPRITE_1);
+inline constexpr auto ALIEN_SPRITE_2_PACKED = data::packSprite<8, 8>(ALIEN_SPRITE_2);
+inline constexpr auto ALIEN_SPRITE_3_PACKED = data::packSprite<11, 8>(ALIEN_SPRITE_3);
+inline constexpr auto ALIEN_SPRITE_4_PACKED = data::packSprite<11, 8>(ALIEN_SPRITE_4);
+inline constexpr auto ALIEN_SPRITE_5_PACKED = data::packSprite<12, 8>(ALIEN_SPRITE_5);
+inline constexpr auto ALIEN_SPRITE_6_PACKED = data::packSprite<12, 8>(ALIEN_SPRITE_6);
+inline constexpr auto ALIEN_DEATH_PACKED = data::packSprite<13, 7>(ALIEN_DEATH);
+
+using AlienSprite1 = data::StaticSprite<8, 8, ALIEN_SPRITE_1>;
+using AlienSprite2 = data::StaticSprite<8, 8, ALIEN_SPRITE_2>;
+using AlienSprite3 = data::StaticSprite<11, 8, ALIEN_SPRITE_3>;
+using AlienSprite4 = data::StaticSprite<11, 8, ALIEN_SPRITE_4>;
+using AlienSprite5 = data::StaticSprite<12, 8, ALIEN_SPRITE_5>;
+using AlienSprite6 = data::StaticSprite<12, 8, ALIEN_SPRITE_6>;
+using AlienDeathSprite = data::StaticSprite<13, 7, ALIEN_DEATH>;
+
+/**
+ * @brief Animation of each alien type, frames index ALIEN_SPRITES.
+ */
+inline constexpr data::Animation ALIEN_ANIMATIONS[3] = {
+    data::makeAnimation({0, 1}, 10),
+    data::makeAnimation({2, 3}, 10),
+    data::makeAnimation({4, 5}, 10),
+};
+
+/**
+ * @brief Draws an alien frame with its specialized draw routine.
+ *
+ * @tparam Target data::Buffer or data::DrawList.
+ * @param target Buffer or draw list to draw into.
+ * @param frame Index of the frame, in the same order as ALIEN_SPRITES.
+ * @param x X-coordinate position to draw the alien.
+ * @param y Y-coordinate position to draw the alien.
+ * @param color 32-bit RGBA color value for the alien pixels.
+ */
+template <typename Target>
+inline void drawAlienSprite(Target& target, size_t frame, size_t x, size_t y, uint32_t color)
+{
+    switch (frame) {
+        case 0: data::drawStatic<AlienSprite1>(target, x, y, color); break;
+        case 1: data::drawStatic<AlienSprite2>(target, x, y, color); break;
+        case 2: data::drawStatic<AlienSprite3>(target, x, y, color); break;
+        case 3: data::drawStatic<AlienSprite4>(target, x, y, color); break;
+        case 4: data::drawStatic<AlienSprite5>(target, x, y, color); break;
+        case 5: data::drawStatic<AlienSprite6>(target, x, y, color); break;
+    }
+}
+
 extern const data::Sprite ALIEN_SPRITES[6];
 extern const data::Sprite ALIEN_DEATH_SPRITE;
-extern data::SpriteAnimation ALIEN_ANIMATIONS[3];
-
-void initializeAliens();
-void cleanupAliens();
+extern const data::PackedSprite ALIEN_SPRITES_PACKED[6];
+extern const data::PackedSprite ALIEN_DEATH_SPRITE_PACKED;
+extern const data::CollisionMask ALIEN_MASKS[6];
 
 } // sprites
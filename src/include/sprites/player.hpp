@@ -1,10 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include "data/collision_mask.hpp"
 #include "data/data.hpp"
+#include "data/static_sprite.hpp"
 
 namespace sprites {
-constexpr uint8_t PLAYER[] = {
+inline constexpr uint8_t PLAYER[] = {
         0,0,0,0,0,1,0,0,0,0,0, // .....@.....
         0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
         0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
@@ -14,12 +16,22 @@ constexpr uint8_t PLAYER[] = {
         1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
     };
 
-constexpr uint8_t BULLET[] = {
+inline constexpr uint8_t BULLET[] = {
         1, // @
         1, // @
         1  // @
     };
 
+inline constexpr auto PLAYER_PACKED = data::packSprite<11, 7>(PLAYER);
+inline constexpr auto BULLET_PACKED = data::packSprite<1, 3>(BULLET);
+
+using PlayerSprite = data::StaticSprite<11, 7, PLAYER>;
+using BulletSprite = data::StaticSprite<1, 3, BULLET>;
+
 extern const data::Sprite PLAYER_SPRITE;
 extern const data::Sprite BULLET_SPRITE;
+extern const data::PackedSprite PLAYER_SPRITE_PACKED;
+extern const data::PackedSprite BULLET_SPRITE_PACKED;
+extern const data::CollisionMask PLAYER_MASK;
+extern const data::CollisionMask BULLET_MASK;
 } // sprites
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include "data/data.hpp"
+
+namespace sprites {
+inline constexpr uint8_t SHIELD[] = {
+    0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0, // ....@@@@@@@@@@@@@@....
+    0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0, // ...@@@@@@@@@@@@@@@@...
+    0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0, // ..@@@@@@@@@@@@@@@@@@..
+    0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@@@@@@@@@@@.
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+    1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1, // @@@@@@@........@@@@@@@
+    1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1, // @@@@@@..........@@@@@@
+    1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1, // @@@@@............@@@@@
+    1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1  // @@@@@............@@@@@
+};
+
+// Pixels a hit blows out of a shield, centered on the bullet
+inline constexpr uint8_t SHIELD_CRATER[] = {
+    1,0,0,0,1,0,0,1, // @...@..@
+    0,0,1,0,0,0,1,0, // ..@...@.
+    0,1,1,1,1,1,1,0, // .@@@@@@.
+    1,1,1,1,1,1,1,1, // @@@@@@@@
+    1,1,1,1,1,1,1,1, // @@@@@@@@
+    0,1,1,1,1,1,1,0, // .@@@@@@.
+    0,0,1,0,0,1,0,0, // ..@..@..
+    1,0,0,1,0,0,0,1  // @..@...@
+};
+
+inline constexpr auto SHIELD_PACKED = data::packBanks<data::SHIELD_WIDTH, data::SHIELD_HEIGHT>(SHIELD);
+inline constexpr auto SHIELD_CRATER_PACKED = data::packSprite<8, 8>(SHIELD_CRATER);
+
+extern const data::PackedSprite SHIELD_CRATER_SPRITE_PACKED;
+} // sprites
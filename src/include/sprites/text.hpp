@@ -4,7 +4,7 @@
 #include "data/data.hpp"
 
 namespace sprites {
-constexpr uint8_t TEXT_SP[] = {
+inline constexpr uint8_t TEXT_SP[] = {
         0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
         0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
         0,1,0,1,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
@@ -76,7 +76,11 @@ constexpr uint8_t TEXT_SP[] = {
         0,0,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
     };
 
+inline constexpr auto TEXT_SP_PACKED = data::packSprite<5, 7, 65>(TEXT_SP);
+
 extern const data::Sprite TEXT_SPRITESHEET;
 extern const data::Sprite NUMBER_SPRITESHEET;
+extern const data::PackedSprite TEXT_SPRITESHEET_PACKED;
+extern const data::PackedSprite NUMBER_SPRITESHEET_PACKED;
 } // sprites
 
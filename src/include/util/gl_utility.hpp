@@ -0,0 +1,31 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace util {
+
+/**
+ * @brief Validates a shader and prints any compilation errors.
+ *
+ * @param shader OpenGL shader ID to validate.
+ * @param file Optional filename for error reporting (default: 0).
+ */
+void validateShader(GLuint shader, const char* file = 0);
+
+/**
+ * @brief Validates an OpenGL shader program and reports linking errors.
+ *
+ * @param program OpenGL program ID to validate.
+ * @return bool True if program is valid, false if linking errors occurred.
+ */
+bool validateProgram(GLuint program);
+
+/**
+ * @brief GLFW error callback that prints error messages to stderr.
+ *
+ * @param error Error code from GLFW.
+ * @param description Human-readable error description.
+ */
+void errorCallback(int error, const char* description);
+
+} // util
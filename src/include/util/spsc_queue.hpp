@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace util {
+
+/**
+ * @brief Queues values from one writer thread to one reader thread without locks.
+ * @details A ring of Capacity slots with a running count of values pushed
+ *          and one of values popped. Each side only ever stores its own
+ *          count, with release, and loads the other's with acquire, so a
+ *          popped value was fully written before it is read. The counts
+ *          sit on their own cache lines so the two sides do not contend.
+ *          Each side keeps a copy of the other's count and only reloads
+ *          it when the ring looks full or empty. Nothing is allocated
+ *          after construction, a full ring refuses values instead of
+ *          growing.
+ *
+ * @tparam T Type of the values, copied into a slot by the writer.
+ * @tparam Capacity Number of slots, a power of two.
+ *
+ * @var slots Storage of the queued values.
+ * @var pushed Number of values pushed, written by the writer.
+ * @var poppedSeen Writer's copy of popped.
+ * @var popped Number of values popped, written by the reader.
+ * @var pushedSeen Reader's copy of pushed.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Queues a value. Writer thread only.
+     *
+     * @param value Value to queue.
+     * @return bool False, queuing nothing, if the ring is full.
+     */
+    bool push(const T& value)
+    {
+        const size_t head = pushed.load(std::memory_order_relaxed);
+        if (head - poppedSeen == Capacity) {
+            poppedSeen = popped.load(std::memory_order_acquire);
+            if (head - poppedSeen == Capacity) {
+                return false;
+            }
+        }
+        slots[head & (Capacity - 1)] = value;
+        pushed.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest queued value. Reader thread only.
+     *
+     * @param value Set to the value, left as is if none is queued.
+     * @return bool False if the ring is empty.
+     */
+    bool pop(T& value)
+    {
+        const size_t tail = popped.load(std::memory_order_relaxed);
+        if (tail == pushedSeen) {
+            pushedSeen = pushed.load(std::memory_order_acquire);
+            if (tail == pushedSeen) {
+                return false;
+            }
+        }
+        value = slots[tail & (Capacity - 1)];
+        popped.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Gets the oldest queued value without taking it. Reader thread only.
+     *
+     * @return const T* The value, nullptr if the ring is empty. Valid
+     *         until the next pop.
+     */
+    const T* peek()
+    {
+        const size_t tail = popped.load(std::memory_order_relaxed);
+        if (tail == pushedSeen) {
+            pushedSeen = pushed.load(std::memory_order_acquire);
+            if (tail == pushedSeen) {
+                return nullptr;
+            }
+        }
+        return &slots[tail & (Capacity - 1)];
+    }
+
+private:
+    static constexpr size_t LINE = 64;
+
+    T slots[Capacity]{};
+    alignas(LINE) std::atomic<size_t> pushed{0};
+    size_t poppedSeen = 0;
+    alignas(LINE) std::atomic<size_t> popped{0};
+    size_t pushedSeen = 0;
+};
+
+} // util
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief A fixed set of worker threads that run indexed tasks in parallel.
+ * @details The calling thread takes part in every parallelFor, so a pool of
+ *          N threads starts N - 1 workers. Every thread owns a range of
+ *          indices and takes tasks from its front, a thread whose range
+ *          runs dry steals the back half of another thread's range.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param numThreads Number of threads including the caller, 0 picks
+     *                   the number of hardware threads.
+     */
+    explicit ThreadPool(size_t numThreads = 0);
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Gets the number of threads tasks run on.
+     *
+     * @return size_t Number of workers plus the calling thread.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Runs task(i) for every i in [0, count) and waits for all of them.
+     * @details Indices start out split evenly across the threads, threads
+     *          that finish early steal from the others, so uneven tasks
+     *          balance without every task touching a shared counter. Must
+     *          not be called from inside a task.
+     *
+     * @param count Number of tasks, below 2^32.
+     * @param task Task to run for every index.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    /**
+     * @brief Indices a thread has left, begin in the high and end in the
+     *        low 32 bits so both change in one atomic operation.
+     */
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    /**
+     * @brief Main loop of a worker thread.
+     *
+     * @param self Index of the thread's range, the caller owns range 0.
+     */
+    void workerLoop(size_t self);
+
+    /**
+     * @brief Runs tasks of the current batch until none are left to take or steal.
+     */
+    void runTasks(size_t self);
+
+    /**
+     * @brief Takes the first index of a thread's own range.
+     */
+    bool take(size_t self, size_t& index);
+
+    /**
+     * @brief Moves the back half of another thread's range to a thread's own.
+     */
+    bool steal(size_t self);
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<Range[]> ranges;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* task = nullptr;
+    size_t busy = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+} // util
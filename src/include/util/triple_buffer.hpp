@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * @brief Hands the latest value from one writer thread to one reader thread without locks.
+ * @details Three slots rotate between the writer, the reader and a shared
+ *          middle slot. Publishing swaps the written slot into the middle,
+ *          taking a new slot out of a single atomic exchange, and so does
+ *          fetching on the reader side. Neither side ever waits for the
+ *          other, a reader that falls behind simply skips values.
+ *
+ * @tparam T Type of the values, copied into a slot by the writer.
+ *
+ * @var slots Storage of the three values.
+ * @var middle Index of the shared slot, DIRTY is set while it holds a
+ *      value the reader has not fetched yet.
+ * @var back Slot owned by the writer.
+ * @var front Slot owned by the reader.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * @brief Constructs a TripleBuffer with every slot holding a value.
+     *
+     * @param initial Value the reader sees before anything is published.
+     */
+    explicit TripleBuffer(const T& initial = T())
+        : slots{initial, initial, initial}
+    {
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * @brief Gets the slot the writer fills next. Writer thread only.
+     *
+     * @return T& Slot to write, holds an older value.
+     */
+    T& write()
+    {
+        return slots[back];
+    }
+
+    /**
+     * @brief Makes the written slot the latest value. Writer thread only.
+     */
+    void publish()
+    {
+        back = middle.exchange(back | DIRTY, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * @brief Takes the latest published value, if there is a new one. Reader thread only.
+     *
+     * @return bool True if read() now returns a newer value.
+     */
+    bool fetch()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & DIRTY)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    /**
+     * @brief Gets the value taken by the last fetch. Reader thread only.
+     *
+     * @return const T& The value, stays unchanged until the next fetch.
+     */
+    const T& read() const
+    {
+        return slots[front];
+    }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t DIRTY = 0x4;
+
+    T slots[3];
+    std::atomic<uint8_t> middle{1};
+    uint8_t back = 0;
+    uint8_t front = 2;
+};
+
+} // util
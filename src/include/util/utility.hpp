@@ -1,7 +1,7 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <GLFW/glfw3.h>
 #include "data/data.hpp"
 
 namespace util {
@@ -16,24 +16,10 @@ namespace util {
  */
 uint32_t rgbToUint32(uint8_t r, uint8_t g, uint8_t b);
 
-/**
- * @brief Validates a shader and prints any compilation errors.
- *
- * @param shader OpenGL shader ID to validate.
- * @param file Optional filename for error reporting (default: 0).
- */
-void validateShader(GLuint shader, const char* file = 0);
-
-/**
- * @brief Validates an OpenGL shader program and reports linking errors.
- *
- * @param program OpenGL program ID to validate.
- * @return bool True if program is valid, false if linking errors occurred.
- */
-bool validateProgram(GLuint program);
-
 /**
  * @brief Checks if two sprites overlap based on their positions and dimensions.
+ * @details Compares bounding boxes only, see data::masksOverlap for the
+ *          exact test of lit pixels.
  *
  * @param spA First sprite to check.
  * @param xA X-coordinate of first sprite.
@@ -49,11 +35,16 @@ bool spriteOverlapCheck(
 );
 
 /**
- * @brief GLFW error callback that prints error messages to stderr.
+ * @brief Hashes a block of memory into 64 bits.
+ * @details Not cryptographic. Four independent lanes each take a 64-bit
+ *          word at a time, so large blocks like a frame hash at several
+ *          bytes per cycle.
  *
- * @param error Error code from GLFW.
- * @param description Human-readable error description.
+ * @param data First byte of the block.
+ * @param size Size of the block in bytes.
+ * @param seed Starting value, hashes chain by passing the last as seed.
+ * @return uint64_t Hash of the block.
  */
-void errorCallback(int error, const char* description);
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
 
 } // util
@@ -1,373 +1,362 @@
+#include <chrono>
 #include <cstdio>
 #include <cstdint>
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-#include "sprites/aliens.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
 #include "sprites/player.hpp"
 #include "sprites/text.hpp"
 #include "data/data.hpp"
+#include "data/draw_list.hpp"
+#include "data/font.hpp"
+#include "render/frame_capture.hpp"
+#include "render/game_view.hpp"
+#include "render/headless_presenter.hpp"
+#include "render/particles.hpp"
+#include "sim/game.hpp"
+#include "sim/replay.hpp"
+#include "sim/rewind.hpp"
+#include "sim/simulation.hpp"
+#include "util/thread_pool.hpp"
 #include "util/utility.hpp"
+#ifdef SPACEINVADERS_WITH_GL
+#include "render/gl_presenter.hpp"
+#endif
 
-bool gameRunning = false;
-int moveDir = 0;
-bool firePressed = 0;
-size_t score = 0;
-
-void keyCallback([[maybe_unused]] GLFWwindow* window,
-                 int key,
-                 [[maybe_unused]] int scancode,
-                 int action,
-                 [[maybe_unused]] int mods)
-{
-    switch (key) {
-        case GLFW_KEY_ESCAPE:
-            if (action == GLFW_PRESS) {
-                gameRunning = false;
-            }
-            break;
-        case GLFW_KEY_RIGHT:
-            if (action == GLFW_PRESS) {
-                moveDir += 1;
-            } else if (action == GLFW_RELEASE) {
-                moveDir -= 1;
-            }
-            break;
-        case GLFW_KEY_LEFT:
-            if (action == GLFW_PRESS) {
-                moveDir -= 1;
-            } else if (action == GLFW_RELEASE) {
-                moveDir += 1;
-            }
-            break;
-        case GLFW_KEY_SPACE:
-            if (action == GLFW_RELEASE) {
-                firePressed = true;
-            }
-            break;
-        default:
-            break;
-    }
-}
-
-int main()
+int main(int argc, char** argv)
 {
     const size_t bufferWidth = 224;
     const size_t bufferHeight = 256;
-
-    glfwSetErrorCallback(util::errorCallback);
-
-    if (!glfwInit()) {
-        return -1;
+    // Holding rewind goes back 10 seconds at the default step rate. The
+    // budget fits them with room to spare, RewindBench shows the use.
+    // Recordings replay the same only with the same limits.
+    const size_t rewindSteps = 600;
+    const size_t rewindBytes = 256 * 1024;
+
+    data::PixelFormat bufferFormat = data::FORMAT_RGBA32;
+    size_t numThreads = 1;
+    [[maybe_unused]] bool uploadRing = true;
+#ifdef SPACEINVADERS_WITH_GL
+    bool headless = false;
+#else
+    bool headless = true;
+#endif
+    size_t maxFrames = 0;
+    std::string dumpDir;
+    size_t dumpEvery = 1;
+    double simRate = 60.0;
+    std::string capturePath;
+    double captureBudget = 250.0;
+    bool realtime = false;
+    std::string recordPath;
+    std::string replayPath;
+    std::string hashLogPath;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--format=rgba32") == 0) {
+            bufferFormat = data::FORMAT_RGBA32;
+        } else if (strcmp(argv[i], "--format=indexed8") == 0) {
+            bufferFormat = data::FORMAT_INDEXED8;
+        } else if (strcmp(argv[i], "--format=mono1") == 0) {
+            bufferFormat = data::FORMAT_MONO1;
+        } else if (strcmp(argv[i], "--upload=direct") == 0) {
+            uploadRing = false;
+        } else if (strcmp(argv[i], "--upload=ring") == 0) {
+            uploadRing = true;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            numThreads = strtoul(argv[i] + 10, NULL, 10);
+        } else if (strncmp(argv[i], "--sim-rate=", 11) == 0) {
+            simRate = strtod(argv[i] + 11, NULL);
+            if (simRate <= 0.0) {
+                fprintf(stderr, "Simulation rate must be positive.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (strncmp(argv[i], "--capture=", 10) == 0) {
+            capturePath = argv[i] + 10;
+        } else if (strncmp(argv[i], "--capture-budget=", 17) == 0) {
+            captureBudget = strtod(argv[i] + 17, NULL);
+        } else if (strncmp(argv[i], "--record=", 9) == 0) {
+            recordPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+            replayPath = argv[i] + 9;
+        } else if (strncmp(argv[i], "--hash-log=", 11) == 0) {
+            hashLogPath = argv[i] + 11;
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            maxFrames = strtoul(argv[i] + 9, NULL, 10);
+        } else if (strncmp(argv[i], "--dump=", 7) == 0) {
+            dumpDir = argv[i] + 7;
+        } else if (strncmp(argv[i], "--dump-every=", 13) == 0) {
+            dumpEvery = strtoul(argv[i] + 13, NULL, 10);
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [--format=rgba32|indexed8|mono1] [--threads=N] [--upload=direct|ring]\n"
+                    "       [--sim-rate=HZ] [--headless] [--realtime] [--frames=N] [--dump=DIR] [--dump-every=N]\n"
+                    "       [--capture=FILE] [--capture-budget=US] [--record=FILE] [--replay=FILE] [--hash-log=FILE]\n",
+                    argv[0]);
+            return -1;
+        }
     }
 
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    // Replays run headless and uncapped, one recorded step per frame,
+    // until the recording ends
+    sim::InputReplay replay;
+    const bool replaying = !replayPath.empty();
+    if (replaying) {
+        if (!replay.open(replayPath)) {
+            return -1;
+        }
+        if (replay.getHeader().width != bufferWidth || replay.getHeader().height != bufferHeight) {
+            fprintf(stderr, "Replay is of a %ux%u game, expected %zux%zu.\n",
+                    replay.getHeader().width, replay.getHeader().height, bufferWidth, bufferHeight);
+            return -1;
+        }
+        headless = true;
+        realtime = false;
+        maxFrames = replay.getSteps();
+    }
 
-    GLFWwindow* window = glfwCreateWindow(2 * bufferWidth, 2* bufferHeight, "Space Invaders", NULL, NULL);
-    if (!window) {
-        glfwTerminate();
-        return -1;
+    // Headless runs would never end without a frame limit
+    if (headless && !maxFrames) {
+        maxFrames = 10000;
     }
 
-    glfwSetKeyCallback(window, keyCallback);
+    printf("Sprite blitter: %s\n", data::blit::isaName());
 
-    glfwMakeContextCurrent(window);
+    uint32_t clearColor = util::rgbToUint32(0, 128, 0);
 
-    GLenum err = glewInit();
-    if (err != GLEW_OK) {
-        fprintf(stderr, "Error initializing GLEW.\n");
-        glfwTerminate();
-        return -1;
-    }
-    int glVersion[2] = {-1, 1};
-    glGetIntegerv(GL_MAJOR_VERSION, &glVersion[0]);
-    glGetIntegerv(GL_MINOR_VERSION, &glVersion[1]);
-    printf("Using OpenGL: %d.%d\n", glVersion[0], glVersion[1]);
-    printf("Renderer used: %s\n", glGetString(GL_RENDERER));
-    printf("Shading Language: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
-
-    glfwSwapInterval(1);
-
-    glClearColor(1.0, 0.0, 0.0, 1.0);
-
-    // Create graphics buffer
-    data::Buffer buffer(bufferWidth, bufferHeight);
-
-    buffer.clear(0);
-
-    // Create texture for presenting buffer to OpenGL
-    GLuint bufferTexture;
-    glGenTextures(1, &bufferTexture);
-    glBindTexture(GL_TEXTURE_2D, bufferTexture);
-    glTexImage2D(
-        GL_TEXTURE_2D, 0, GL_RGB8,
-        buffer.getWidth(), buffer.getHeight(), 0,
-        GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.getData()
-    );
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Create vao for generating fullscreen triangle
-    GLuint fullscreenTriangleVao;
-    glGenVertexArrays(1, &fullscreenTriangleVao);
-
-    // Create shader for displaying buffer
-    const char* vertexShader =
-        "\n"
-        "#version 330\n"
-        "\n"
-        "noperspective out vec2 TexCoord;\n"
-        "\n"
-        "void main(void){\n"
-        "\n"
-        "    TexCoord.x = (gl_VertexID == 2) ? 2.0 : 0.0;\n"
-        "    TexCoord.y = (gl_VertexID == 1) ? 2.0 : 0.0;\n"
-        "    \n"
-        "    gl_Position = vec4(2.0 * TexCoord - 1.0, 0.0, 1.0);\n"
-        "}\n";
-    const char* fragmentShader =
-        "\n"
-        "#version 330\n"
-        "\n"
-        "uniform sampler2D buffer;\n"
-        "noperspective in vec2 TexCoord;\n"
-        "\n"
-        "out vec3 outColor;\n"
-        "\n"
-        "void main(void) {\n"
-        "    outColor = texture(buffer, TexCoord).rgb;\n"
-        "}\n";
-
-    GLuint shaderId = glCreateProgram();
-    // Create vertex shader
-    {
-        GLuint shaderVp = glCreateShader(GL_VERTEX_SHADER);
-
-        glShaderSource(shaderVp, 1, &vertexShader, 0);
-        glCompileShader(shaderVp);
-        util::validateShader(shaderVp, vertexShader);
-        glAttachShader(shaderId, shaderVp);
-
-        glDeleteShader(shaderVp);
-    }
+    // Create graphics buffer, compact formats keep the background at index 0
+    data::Buffer buffer(bufferWidth, bufferHeight, bufferFormat);
+    buffer.setPalette({clearColor, util::rgbToUint32(128, 0, 0)});
 
-    // Create fragment shader
-    {
-        GLuint shaderFp = glCreateShader(GL_FRAGMENT_SHADER);
+    buffer.clear(clearColor);
 
-        glShaderSource(shaderFp, 1, &fragmentShader, 0);
-        glCompileShader(shaderFp);
-        util::validateShader(shaderFp, fragmentShader);
-        glAttachShader(shaderId, shaderFp);
+    const char* formatNames[] = {"RGBA32", "indexed 8bpp", "1bpp"};
+    printf("Framebuffer: %s, %zu bytes\n",
+           formatNames[buffer.getFormat()],
+           buffer.getStride() * buffer.getHeight() * sizeof(uint32_t));
 
-        glDeleteShader(shaderFp);
+    // Frames are recorded into a draw list and rasterized in bands, on a
+    // pool when more than one thread is requested. 0 uses every core.
+    data::DrawList drawList(buffer);
+    std::unique_ptr<util::ThreadPool> pool;
+    if (numThreads != 1) {
+        pool = std::make_unique<util::ThreadPool>(numThreads);
     }
-
-    glLinkProgram(shaderId);
-
-    if (!util::validateProgram(shaderId)) {
-        fprintf(stderr, "Error while validating shader.\n");
-        glfwTerminate();
-        glDeleteVertexArrays(1, &fullscreenTriangleVao);
-        return -1;
+    printf("Raster threads: %zu\n", pool ? pool->size() : 1);
+
+    // Frames go to a window, or nowhere as fast as they are made
+    std::unique_ptr<render::Presenter> presenter;
+    if (headless) {
+        presenter = std::make_unique<render::HeadlessPresenter>(dumpDir, dumpEvery);
+        printf("Presenter: headless%s\n", dumpDir.empty() ? "" : ", dumping frames");
+    } else {
+#ifdef SPACEINVADERS_WITH_GL
+        presenter = render::createGlPresenter(buffer, uploadRing);
+#endif
+        if (!presenter) {
+            fprintf(stderr, "Error creating window, --headless runs without one.\n");
+            return -1;
+        }
     }
 
-    glUseProgram(shaderId);
-
-    GLint location = glGetUniformLocation(shaderId, "buffer");
-    glUniform1i(location, 0);
-
-    // OpenGL setup
-    glDisable(GL_DEPTH_TEST);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(fullscreenTriangleVao);
-
-    // Prepare game
-    sprites::initializeAliens();
-
-    data::Game game;
-    game.width = bufferWidth;
-    game.height = bufferHeight;
-    game.numAliens = 55;
-    game.numBullets = 0;
-    game.aliens = new data::Alien[game.numAliens];
-
-    game.player.x = 112 - 5;
-    game.player.y = 32;
-
-    game.player.life = 3;
-
-    for (size_t yi = 0; yi < 5; ++yi) {
-        for (size_t xi = 0; xi < 11; ++xi) {
-            data::Alien& alien = game.aliens[yi * 11 + xi];
-            alien.type = (5 - yi) / 2 + 1;
+    // Frames are recorded on a writer thread, the game thread only hands
+    // it the damaged parts of each frame
+    std::unique_ptr<render::FrameCapture> capture;
+    if (!capturePath.empty()) {
+        capture = std::make_unique<render::FrameCapture>(buffer, capturePath, captureBudget);
+        if (!capture->isOpen()) {
+            return -1;
+        }
+        printf("Capture: %s\n", capturePath.c_str());
+    }
 
-            const data::Sprite& sprite = sprites::ALIEN_SPRITES[2 * (alien.type - 1)];
+    // Steps are recorded as they are taken, on the simulation thread
+    // when there is one
+    sim::InputRecorder recorder;
+    if (!recordPath.empty()) {
+        if (!recorder.open(recordPath, {bufferWidth, bufferHeight, 1})) {
+            return -1;
+        }
+        printf("Recording: %s\n", recordPath.c_str());
+    }
 
-            alien.x = 16 * xi + 20 + (sprites::ALIEN_DEATH_SPRITE.width - sprite.width) / 2;
-            alien.y = 17 * yi + 128;
+    // Every frame's game and framebuffer hashes, for diffing runs
+    FILE* hashLog = nullptr;
+    if (!hashLogPath.empty()) {
+        hashLog = fopen(hashLogPath.c_str(), "w");
+        if (!hashLog) {
+            fprintf(stderr, "Error creating %s.\n", hashLogPath.c_str());
+            return -1;
         }
     }
 
-    uint8_t* deathCounters = new uint8_t[game.numAliens];
-    for (size_t i = 0; i < game.numAliens; ++i) {
-        deathCounters[i] = 10;
+    // Prepare game
+    data::Game initial;
+    sim::newGame(initial, bufferWidth, bufferHeight);
+
+    // The game steps at a fixed rate on its own thread and frames blend
+    // its latest snapshots, so game speed does not depend on the display.
+    // Headless runs step once per frame instead unless asked not to.
+    sim::Simulation simulation(initial, simRate);
+    if (recorder.isOpen()) {
+        simulation.setRecorder(&recorder);
+    }
+    sim::RewindBuffer rewind(rewindSteps, rewindBytes);
+    simulation.setRewind(&rewind);
+    const bool threaded = !headless || realtime;
+    if (threaded) {
+        simulation.start();
+        printf("Simulation: %.0f steps/s on its own thread\n", simRate);
+    } else if (replaying) {
+        printf("Simulation: replaying %llu steps of %s\n",
+               static_cast<unsigned long long>(replay.getSteps()), replayPath.c_str());
+    } else {
+        printf("Simulation: one step per frame\n");
     }
 
-    uint32_t clearColor = util::rgbToUint32(0, 128, 0);
+    data::Font font(sprites::TEXT_SPRITESHEET_PACKED, 65, ' ');
+    data::NumberLabel scoreLabel(
+        font,
+        4 + 2 * sprites::NUMBER_SPRITESHEET.width,
+        initial.height - 2 * sprites::NUMBER_SPRITESHEET.height - 12
+    );
 
-    gameRunning = true;
+    // Debris of every hit, drawn over the sprites
+    render::ParticleSystem particles(bufferWidth, bufferHeight);
 
-    int playerMoveDir = 0;
+    size_t frames = 0;
+    bool quit = false;
+    bool diverged = false;
+    auto start = std::chrono::steady_clock::now();
     // Game loop
-    while (!glfwWindowShouldClose(window) & gameRunning) {
-        buffer.clear(clearColor);
-
-        buffer.drawText(
-            sprites::TEXT_SPRITESHEET, "SCORE",
-            4, game.height - sprites::TEXT_SPRITESHEET.height - 7,
-            util::rgbToUint32(128, 0, 0)
-        );
-
-        buffer.drawNumber(
-            sprites::NUMBER_SPRITESHEET, score,
-            4 + 2 * sprites::NUMBER_SPRITESHEET.width, game.height - 2 * sprites::NUMBER_SPRITESHEET.height - 12,
-            util::rgbToUint32(128, 0, 0)
-        );
-
-        buffer.drawText(
-            sprites::TEXT_SPRITESHEET, "CREDIT 00",
-            164, 7,
-            util::rgbToUint32(128, 0, 0)
-        );
-
-        // Line at bottom
-        for (size_t i = 0; i < game.width; ++i) {
-            buffer.getVector()[game.width * 16 + i] = util::rgbToUint32(128, 0, 0);
+    while (!quit && (!maxFrames || frames < maxFrames)) {
+        // Input is polled right before the frame is made, so a step taken
+        // now already has it. Replays set each step's recorded controls.
+        if (replaying) {
+            simulation.setInput(replay.input(simulation.getSteps()));
+        } else {
+            quit = !presenter->pollInput(simulation.getControls());
+        }
+        if (!threaded) {
+            simulation.step();
         }
 
-        // Draw aliens
-        for (size_t ai = 0; ai < game.numAliens; ++ai) {
-            if (!deathCounters[ai]) {
-                // Dead alien; don't draw
-                continue;
-            }
-
-            const data::Alien& alien = game.aliens[ai];
-            if (alien.type == data::ALIEN_DEAD) {
-                buffer.drawSprite(sprites::ALIEN_DEATH_SPRITE, alien.x, alien.y, util::rgbToUint32(128, 0, 0));
-            } else {
-                const data::SpriteAnimation& animation = sprites::ALIEN_ANIMATIONS[alien.type - 1];
-                size_t current_frame = animation.time / animation.frameDuration;
-                const data::Sprite& sprite = *animation.frames[current_frame];
-                buffer.drawSprite(sprite, alien.x, alien.y, util::rgbToUint32(128, 0, 0));
+        // The first step whose state differs from the recording pins down
+        // where a replay went its own way
+        if (replaying) {
+            size_t step = simulation.getSteps() - 1;
+            const sim::StateHash* expected = replay.findHash(step);
+            uint64_t hash = sim::hashGame(simulation.frame());
+            if (expected && expected->hash != hash) {
+                fprintf(stderr, "Replay diverged at step %zu: recorded %016llx, replayed %016llx.\n",
+                        step, static_cast<unsigned long long>(expected->hash),
+                        static_cast<unsigned long long>(hash));
+                diverged = true;
+                break;
             }
         }
 
-        // Draw bullets
-        for (size_t bi = 0; bi < game.numBullets; ++bi) {
-            const data::Bullet& bullet = game.bullets[bi];
-            const data::Sprite& sprite = sprites::BULLET_SPRITE;
-            buffer.drawSprite(sprite, bullet.x, bullet.y, util::rgbToUint32(128, 0, 0));
-        }
+        const data::Game& game = simulation.frame();
 
-        // Draw player
-        buffer.drawSprite(sprites::PLAYER_SPRITE, game.player.x, game.player.y, util::rgbToUint32(128, 0, 0));
+        // The labels, score and ground line form a cached background layer.
+        // Most frames only restore what the sprites covered, the score
+        // label redraws the digits that changed and caches just those.
+        if (buffer.hasBackground()) {
+            buffer.restoreDamaged();
+        } else {
+            buffer.clear(clearColor);
 
-        // Update animations
-        for (size_t i = 0; i < 3; ++i) {
-            ++sprites::ALIEN_ANIMATIONS[i].time;
-            if (sprites::ALIEN_ANIMATIONS[i].time == sprites::ALIEN_ANIMATIONS[i].numFrames * sprites::ALIEN_ANIMATIONS[i].frameDuration) {
-                sprites::ALIEN_ANIMATIONS[i].time = 0;
-            }
-        }
+            font.drawText(
+                buffer, "SCORE",
+                4, game.height - sprites::TEXT_SPRITESHEET.height - 7,
+                util::rgbToUint32(128, 0, 0)
+            );
 
-        glTexSubImage2D(
-            GL_TEXTURE_2D, 0, 0, 0,
-            buffer.getWidth(), buffer.getHeight(),
-            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
-            buffer.getData()
-        );
+            font.drawText(buffer, "CREDIT 00", 164, 7, util::rgbToUint32(128, 0, 0));
 
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            // Line at bottom
+            buffer.fillRect(0, 16, game.width, 1, util::rgbToUint32(128, 0, 0));
 
-        glfwSwapBuffers(window);
+            scoreLabel.invalidate();
+        }
 
-        // Update deathCounters
-        for (size_t ai = 0; ai < game.numAliens; ++ai) {
-            const data::Alien& alien = game.aliens[ai];
-            if (alien.type == data::ALIEN_DEAD && deathCounters[ai]) {
-                --deathCounters[ai];
-            }
+        data::Region scoreChanged = scoreLabel.draw(buffer, game.score, util::rgbToUint32(128, 0, 0), clearColor);
+        if (!buffer.hasBackground()) {
+            buffer.cacheBackground();
+        } else if (scoreChanged.width) {
+            buffer.cacheBackground(scoreChanged);
         }
+        drawList.reset();
 
-        // Set direction of bullets
-        for (size_t bi = 0; bi < game.numBullets;) {
-            game.bullets[bi].y += game.bullets[bi].dir;
-            if (game.bullets[bi].y >= game.height || game.bullets[bi].y < sprites::BULLET_SPRITE.height) {
-                game.bullets[bi] = game.bullets[game.numBullets - 1];
-                --game.numBullets;
-                continue;
-            }
-            // Check for alien collision
-            for (size_t ai = 0; ai < game.numAliens; ++ai) {
-                const data::Alien& alien = game.aliens[ai];
-                if (alien.type == data::ALIEN_DEAD) {
-                    continue;
-                }
-                const data::SpriteAnimation& animation = sprites::ALIEN_ANIMATIONS[alien.type - 1];
-                size_t current_frame = animation.time / animation.frameDuration;
-                const data::Sprite& alien_sprite = *animation.frames[current_frame];
-                bool overlap = util::spriteOverlapCheck(
-                    sprites::BULLET_SPRITE, game.bullets[bi].x, game.bullets[bi].y,
-                    alien_sprite, alien.x, alien.y
-                );
-                if (overlap) {
-                    score += 10 * (4 - game.aliens[ai].type);
-                    game.aliens[ai].type = data::ALIEN_DEAD;
-                    game.aliens[ai].x -= (sprites::ALIEN_DEATH_SPRITE.width - alien_sprite.width) / 2;
-                    game.bullets[bi] = game.bullets[game.numBullets - 1];
-                    --game.numBullets;
-                    continue;
-                }
-            }
+        render::drawGame(drawList, game, util::rgbToUint32(128, 0, 0));
 
-            ++bi;
-        }
+        drawList.execute(pool.get());
 
-        playerMoveDir = 2 * moveDir;
+        particles.follow(game);
+        particles.draw(buffer, util::rgbToUint32(128, 0, 0));
 
-        if (playerMoveDir != 0) {
-            if (game.player.x + sprites::PLAYER_SPRITE.width + playerMoveDir >= game.width) {
-                game.player.x = game.width - sprites::PLAYER_SPRITE.width;
-            } else if ((int)game.player.x + playerMoveDir <= 0) {
-                game.player.x = 0;
-            } else {
-                game.player.x += playerMoveDir;
-            }
+        const std::vector<data::Region>& damage = buffer.collectDamage();
+        if (capture) {
+            capture->capture(buffer, damage);
         }
-
-        if (firePressed && game.numBullets < GAME_MAX_BULLETS) {
-            game.bullets[game.numBullets].x = game.player.x + sprites::PLAYER_SPRITE.width / 2;
-            game.bullets[game.numBullets].y = game.player.y + sprites::PLAYER_SPRITE.height;
-            game.bullets[game.numBullets].dir = 2;
-            ++game.numBullets;
+        presenter->present(buffer, damage);
+        simulation.presented();
+        if (hashLog) {
+            fprintf(hashLog, "%zu %016llx %016llx\n", frames,
+                    static_cast<unsigned long long>(sim::hashGame(game)),
+                    static_cast<unsigned long long>(util::hash64(
+                        buffer.getData(), buffer.getStride() * buffer.getHeight() * sizeof(uint32_t))));
         }
-        firePressed = false;
+        ++frames;
+    }
+    simulation.stop();
+    recorder.close();
+    if (hashLog) {
+        fclose(hashLog);
+    }
 
-        glfwPollEvents();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("Ran %zu frames in %.2f s, %.0f frames/s\n", frames, seconds, frames / seconds);
+    printf("Simulated %zu steps, %zu dropped\n", simulation.getSteps(), simulation.getDroppedSteps());
+    const sim::LatencyStats& latency = simulation.getInputLatency();
+    if (latency.getCount()) {
+        printf("Input to swap: %zu events, %.0f us mean, %.0f us p50, %.0f us p90, %.0f us p99, %.0f us max, %zu dropped\n",
+               latency.getCount(), latency.getMeanMicros(),
+               latency.getPercentileMicros(0.5), latency.getPercentileMicros(0.9),
+               latency.getPercentileMicros(0.99), latency.getPercentileMicros(1.0),
+               simulation.getControls().getDropped());
+    }
+    sim::RewindStats rewindStats = rewind.getStats();
+    printf("Rewind: %zu states in %.1f KiB, %.1f KiB reserved, %.1f KiB in all\n",
+           rewindStats.snapshots, rewindStats.payloadBytes / 1024.0,
+           rewindStats.capacityBytes / 1024.0, rewindStats.totalBytes / 1024.0);
+    if (!recordPath.empty()) {
+        printf("Recorded %llu steps\n", static_cast<unsigned long long>(recorder.getSteps()));
+    }
+    if (replaying && !diverged) {
+        printf("Replay matched %zu recorded states\n", replay.getHashes().size());
+    }
+
+    if (capture) {
+        if (!capture->finish()) {
+            fprintf(stderr, "Capture to %s failed, the file ends early.\n", capturePath.c_str());
+        }
+        render::CaptureStats captureStats = capture->getStats();
+        printf("Captured %zu frames: %.1f us average, %.1f us max, %zu over %.0f us, %zu dropped, %.1f KiB\n",
+               captureStats.frames,
+               captureStats.frames ? captureStats.totalMicros / captureStats.frames : 0.0,
+               captureStats.maxMicros,
+               captureStats.overBudget, captureBudget,
+               captureStats.dropped,
+               captureStats.bytes / 1024.0);
     }
-    glfwDestroyWindow(window);
-    glfwTerminate();
 
-    glDeleteVertexArrays(1, &fullscreenTriangleVao);
-    sprites::cleanupAliens();
-    delete[] game.aliens;
-    delete[] deathCounters;
+    presenter.reset();
 
-    return 0;
+    return diverged ? 1 : 0;
 }
@@ -0,0 +1,225 @@
+#include "render/particles.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace render {
+
+namespace {
+
+const uint32_t PARTICLE_SEED = 0x2545F491;
+
+// Pulls every particle down by 6/256 of a pixel per step, per step
+const int32_t GRAVITY = 6;
+
+// Following more steps at once than this only moves the particles this far
+const size_t MAX_CATCH_UP = 8;
+
+/**
+ * @brief Converts a distance in pixels into fixed point.
+ */
+constexpr int32_t fixed(double pixels)
+{
+    return static_cast<int32_t>(pixels * (1 << PARTICLE_FRACTION_BITS));
+}
+
+/**
+ * @brief Gets the pixel a fixed point coordinate falls on.
+ * @details Coordinates left of or below the screen end up far beyond its
+ *          other side, so a single unsigned compare culls both.
+ */
+uint16_t pixelOf(int32_t coordinate)
+{
+    const int32_t pixel = std::clamp(coordinate >> PARTICLE_FRACTION_BITS, -32768, 32767);
+    return static_cast<uint16_t>(pixel);
+}
+
+} // namespace
+
+ParticleSystem::ParticleSystem(size_t width, size_t height, size_t capacity)
+    : width(width), height(height), capacity(capacity),
+      x(capacity), y(capacity), vx(capacity), vy(capacity), life(capacity),
+      pixelX(capacity), pixelY(capacity),
+      seed(PARTICLE_SEED)
+{
+    for (size_t di = 0; di < NUM_DIRECTIONS; ++di) {
+        const double angle = 2.0 * std::acos(-1.0) * di / NUM_DIRECTIONS;
+        directions[2 * di] = static_cast<int32_t>(std::lround(std::cos(angle) * (1 << PARTICLE_FRACTION_BITS)));
+        directions[2 * di + 1] = static_cast<int32_t>(std::lround(std::sin(angle) * (1 << PARTICLE_FRACTION_BITS)));
+    }
+}
+
+void ParticleSystem::follow(const data::Game& game)
+{
+    const data::ImpactLog& impacts = game.impacts;
+    if (game.tick < tick || impacts.count < impactsSeen) {
+        clear();
+        tick = game.tick;
+        impactsSeen = impacts.count;
+        return;
+    }
+
+    // Impacts the ring already overwrote are lost, the rest are scattered
+    // oldest first
+    uint64_t first = impactsSeen;
+    if (impacts.count - first > data::IMPACT_LOG_SIZE) {
+        first = impacts.count - data::IMPACT_LOG_SIZE;
+    }
+    for (uint64_t ii = first; ii < impacts.count; ++ii) {
+        scatter(impacts.entries[ii % data::IMPACT_LOG_SIZE]);
+    }
+    impactsSeen = impacts.count;
+
+    const size_t steps = std::min(game.tick - tick, MAX_CATCH_UP);
+    for (size_t si = 0; si < steps; ++si) {
+        update();
+    }
+    tick = game.tick;
+}
+
+void ParticleSystem::scatter(const data::Impact& impact)
+{
+    // Debris bounces back the way the bullet came from
+    const int32_t back = impact.dir > 0 ? -fixed(0.5) : impact.dir < 0 ? fixed(0.5) : 0;
+    switch (impact.kind) {
+        case data::IMPACT_ALIEN:
+            burst(impact.x, impact.y, 24 + 8 * impact.type, fixed(0.25), fixed(1.5), 0, 16, 40);
+            break;
+        case data::IMPACT_SHIELD:
+            burst(impact.x, impact.y, 10, fixed(0.125), fixed(0.75), back, 8, 24);
+            break;
+        case data::IMPACT_PLAYER:
+            burst(impact.x, impact.y, 64, fixed(0.25), fixed(2.0), fixed(0.5), 24, 60);
+            break;
+    }
+}
+
+bool ParticleSystem::spawn(int32_t x, int32_t y, int32_t vx, int32_t vy, int32_t life)
+{
+    if (count == capacity) {
+        return false;
+    }
+    this->x[count] = x;
+    this->y[count] = y;
+    this->vx[count] = vx;
+    this->vy[count] = vy;
+    this->life[count] = life;
+    pixelX[count] = pixelOf(x);
+    pixelY[count] = pixelOf(y);
+    ++count;
+    return true;
+}
+
+void ParticleSystem::update()
+{
+    size_t pi = 0;
+#if defined(__SSE2__)
+    // SSE2 is part of x86-64, so no runtime check is needed. Two vectors
+    // of 4 particles are moved at once so their pixels pack into a
+    // single vector of 8, saturating far off the screen.
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i gravity = _mm_set1_epi32(GRAVITY);
+    for (; pi + 8 <= count; pi += 8) {
+        __m128i px[2];
+        __m128i py[2];
+        for (size_t half = 0; half < 2; ++half) {
+            const size_t at = pi + 4 * half;
+            __m128i* lx = reinterpret_cast<__m128i*>(x.data() + at);
+            __m128i* ly = reinterpret_cast<__m128i*>(y.data() + at);
+            __m128i* lvx = reinterpret_cast<__m128i*>(vx.data() + at);
+            __m128i* lvy = reinterpret_cast<__m128i*>(vy.data() + at);
+            __m128i* llife = reinterpret_cast<__m128i*>(life.data() + at);
+
+            __m128i speedY = _mm_sub_epi32(_mm_loadu_si128(lvy), gravity);
+            __m128i posX = _mm_add_epi32(_mm_loadu_si128(lx), _mm_loadu_si128(lvx));
+            __m128i posY = _mm_add_epi32(_mm_loadu_si128(ly), speedY);
+            _mm_storeu_si128(lvy, speedY);
+            _mm_storeu_si128(lx, posX);
+            _mm_storeu_si128(ly, posY);
+            _mm_storeu_si128(llife, _mm_sub_epi32(_mm_loadu_si128(llife), one));
+
+            px[half] = _mm_srai_epi32(posX, PARTICLE_FRACTION_BITS);
+            py[half] = _mm_srai_epi32(posY, PARTICLE_FRACTION_BITS);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixelX.data() + pi), _mm_packs_epi32(px[0], px[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixelY.data() + pi), _mm_packs_epi32(py[0], py[1]));
+    }
+#endif
+    for (; pi < count; ++pi) {
+        vy[pi] -= GRAVITY;
+        x[pi] += vx[pi];
+        y[pi] += vy[pi];
+        --life[pi];
+        pixelX[pi] = pixelOf(x[pi]);
+        pixelY[pi] = pixelOf(y[pi]);
+    }
+
+    // Burnt out and off screen particles are replaced by the last one,
+    // which is looked at next without advancing pi
+    for (pi = 0; pi < count;) {
+        if (life[pi] > 0 && pixelX[pi] < width && pixelY[pi] < height) {
+            ++pi;
+            continue;
+        }
+        --count;
+        x[pi] = x[count];
+        y[pi] = y[count];
+        vx[pi] = vx[count];
+        vy[pi] = vy[count];
+        life[pi] = life[count];
+        pixelX[pi] = pixelX[count];
+        pixelY[pi] = pixelY[count];
+    }
+}
+
+void ParticleSystem::clear()
+{
+    count = 0;
+}
+
+void ParticleSystem::draw(data::Buffer& buffer, uint32_t color) const
+{
+    if (count) {
+        buffer.plotPoints(pixelX.data(), pixelY.data(), count, color);
+    }
+}
+
+size_t ParticleSystem::size() const
+{
+    return count;
+}
+
+uint32_t ParticleSystem::nextRandom()
+{
+    uint32_t r = seed;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    seed = r;
+    return r;
+}
+
+void ParticleSystem::burst(
+    int32_t x, int32_t y, size_t number,
+    int32_t minSpeed, int32_t maxSpeed, int32_t lift,
+    int32_t minLife, int32_t maxLife
+){
+    const int32_t centerX = fixed(x) + fixed(0.5);
+    const int32_t centerY = fixed(y) + fixed(0.5);
+    for (size_t ni = 0; ni < number; ++ni) {
+        const uint32_t r = nextRandom();
+        const size_t di = r % NUM_DIRECTIONS;
+        const int32_t speed = minSpeed + static_cast<int32_t>((r >> 8) % static_cast<uint32_t>(maxSpeed - minSpeed + 1));
+        const int32_t lifetime = minLife + static_cast<int32_t>((r >> 20) % static_cast<uint32_t>(maxLife - minLife + 1));
+        const int32_t speedX = directions[2 * di] * speed >> PARTICLE_FRACTION_BITS;
+        const int32_t speedY = (directions[2 * di + 1] * speed >> PARTICLE_FRACTION_BITS) + lift;
+        if (!spawn(centerX, centerY, speedX, speedY, lifetime)) {
+            return;
+        }
+    }
+}
+
+} // render
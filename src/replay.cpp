@@ -0,0 +1,298 @@
+#include "sim/replay.hpp"
+#include <algorithm>
+#include "util/utility.hpp"
+
+namespace sim {
+
+namespace {
+
+const char MAGIC[4] = {'S', 'I', 'R', 'P'};
+const size_t HEADER_SIZE = 24;
+
+void putU32(uint8_t* out, uint32_t value)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = value >> (8 * i);
+    }
+}
+
+uint16_t getU16(const uint8_t* in)
+{
+    return in[0] | in[1] << 8;
+}
+
+uint32_t getU32(const uint8_t* in)
+{
+    return in[0] | in[1] << 8 | in[2] << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+bool getVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t packInput(const data::Input& input)
+{
+    return (std::clamp(input.moveDir, -1, 1) + 1) | (input.fire ? 4 : 0) | (input.rewind ? 8 : 0);
+}
+
+data::Input unpackInput(uint8_t bits)
+{
+    data::Input input{};
+    input.moveDir = std::min(bits & 3, 2) - 1;
+    input.fire = bits & 4;
+    input.rewind = bits & 8;
+    return input;
+}
+
+bool sameInput(const data::Input& a, const data::Input& b)
+{
+    return packInput(a) == packInput(b);
+}
+
+} // namespace
+
+uint64_t hashGame(const data::Game& game)
+{
+    // The bytes on either side of the impact log, found from where it
+    // actually sits, so members added after it are still hashed
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&game);
+    const size_t before = static_cast<size_t>(reinterpret_cast<const uint8_t*>(&game.impacts) - bytes);
+    const size_t after = before + sizeof(game.impacts);
+    const uint64_t hash = util::hash64(bytes, before);
+    return after < sizeof(game) ? util::hash64(bytes + after, sizeof(game) - after, hash) : hash;
+}
+
+InputRecorder::~InputRecorder()
+{
+    close();
+}
+
+bool InputRecorder::open(const std::string& path, const ReplayHeader& header)
+{
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "Error creating replay file %s.\n", path.c_str());
+        return false;
+    }
+
+    this->header = header;
+    this->header.hashInterval = std::max<uint32_t>(header.hashInterval, 1);
+    last = data::Input{};
+    steps = 0;
+    recordStep = 0;
+    hashed = true;
+
+    uint8_t bytes[HEADER_SIZE] = {};
+    std::copy(MAGIC, MAGIC + 4, bytes);
+    bytes[4] = REPLAY_FILE_VERSION & 0xFF;
+    bytes[5] = REPLAY_FILE_VERSION >> 8;
+    putU32(bytes + 8, this->header.width);
+    putU32(bytes + 12, this->header.height);
+    putU32(bytes + 16, this->header.hashInterval);
+    putU32(bytes + 20, REPLAY_STATE_SIZE);
+    if (fwrite(bytes, 1, HEADER_SIZE, file) != HEADER_SIZE) {
+        fprintf(stderr, "Error writing replay file %s.\n", path.c_str());
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void InputRecorder::record(const data::Input& input, const data::Game& game)
+{
+    if (!file) {
+        return;
+    }
+
+    // The first step always stores its controls, later ones only changes
+    if (steps == 0 || !sameInput(input, last)) {
+        uint8_t bits = packInput(input);
+        write(steps, false, &bits, 1);
+        last = input;
+    }
+
+    lastHash = hashGame(game);
+    hashed = (steps + 1) % header.hashInterval == 0;
+    if (hashed) {
+        uint8_t bytes[8];
+        for (size_t i = 0; i < 8; ++i) {
+            bytes[i] = lastHash >> (8 * i);
+        }
+        write(steps, true, bytes, 8);
+    }
+    ++steps;
+}
+
+void InputRecorder::close()
+{
+    if (!file) {
+        return;
+    }
+
+    // The last step is always hashed, so a replay knows where it ends
+    if (!hashed) {
+        uint8_t bytes[8];
+        for (size_t i = 0; i < 8; ++i) {
+            bytes[i] = lastHash >> (8 * i);
+        }
+        write(steps - 1, true, bytes, 8);
+    }
+    if (file && fclose(file) != 0) {
+        fprintf(stderr, "Error closing replay file.\n");
+    }
+    file = nullptr;
+}
+
+bool InputRecorder::isOpen() const
+{
+    return file != nullptr;
+}
+
+uint64_t InputRecorder::getSteps() const
+{
+    return steps;
+}
+
+void InputRecorder::write(uint64_t step, bool hash, const uint8_t* payload, size_t size)
+{
+    uint8_t bytes[10 + 8];
+    size_t length = 0;
+    uint64_t value = (step - recordStep) << 1 | (hash ? 1 : 0);
+    while (value >= 0x80) {
+        bytes[length++] = value | 0x80;
+        value >>= 7;
+    }
+    bytes[length++] = value;
+    std::copy(payload, payload + size, bytes + length);
+    length += size;
+    recordStep = step;
+
+    if (fwrite(bytes, 1, length, file) != length) {
+        fprintf(stderr, "Error writing replay file, recording stopped.\n");
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool InputReplay::open(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        fprintf(stderr, "Error opening replay file %s.\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    if (bytes.size() < 8 || !std::equal(MAGIC, MAGIC + 4, bytes.begin())) {
+        fprintf(stderr, "%s is no replay file.\n", path.c_str());
+        return false;
+    }
+    const unsigned version = getU16(bytes.data() + 4);
+    if (version != REPLAY_FILE_VERSION) {
+        fprintf(stderr, "%s is a version %u replay file, this build reads version %u.\n",
+                path.c_str(), version, static_cast<unsigned>(REPLAY_FILE_VERSION));
+        return false;
+    }
+    if (bytes.size() < HEADER_SIZE) {
+        fprintf(stderr, "%s is no replay file.\n", path.c_str());
+        return false;
+    }
+    // Hashes of a differently laid out state can never match
+    const uint32_t stateSize = getU32(bytes.data() + 20);
+    if (stateSize != REPLAY_STATE_SIZE) {
+        fprintf(stderr, "%s hashed a %u byte game state, this build hashes %u bytes.\n",
+                path.c_str(), static_cast<unsigned>(stateSize), static_cast<unsigned>(REPLAY_STATE_SIZE));
+        return false;
+    }
+    header.width = getU32(bytes.data() + 8);
+    header.height = getU32(bytes.data() + 12);
+    header.hashInterval = getU32(bytes.data() + 16);
+
+    events.clear();
+    hashes.clear();
+    steps = 0;
+    nextEvent = 0;
+    uint64_t step = 0;
+    const uint8_t* in = bytes.data() + HEADER_SIZE;
+    const uint8_t* end = bytes.data() + bytes.size();
+    while (in < end) {
+        uint64_t value;
+        if (!getVarint(in, end, value)) {
+            break;
+        }
+        step += value >> 1;
+        if (value & 1) {
+            if (end - in < 8) {
+                break;
+            }
+            uint64_t hash = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                hash |= static_cast<uint64_t>(in[i]) << (8 * i);
+            }
+            in += 8;
+            hashes.push_back({step, hash});
+        } else {
+            if (in == end) {
+                break;
+            }
+            events.push_back({step, unpackInput(*in++)});
+        }
+        steps = step + 1;
+    }
+    return true;
+}
+
+const ReplayHeader& InputReplay::getHeader() const
+{
+    return header;
+}
+
+uint64_t InputReplay::getSteps() const
+{
+    return steps;
+}
+
+const std::vector<StateHash>& InputReplay::getHashes() const
+{
+    return hashes;
+}
+
+data::Input InputReplay::input(uint64_t step)
+{
+    // Seeking back starts over from the first event
+    if (nextEvent > 0 && events[nextEvent - 1].step > step) {
+        nextEvent = 0;
+    }
+    while (nextEvent < events.size() && events[nextEvent].step <= step) {
+        ++nextEvent;
+    }
+    return nextEvent > 0 ? events[nextEvent - 1].input : data::Input{};
+}
+
+const StateHash* InputReplay::findHash(uint64_t step) const
+{
+    auto it = std::lower_bound(
+        hashes.begin(), hashes.end(), step,
+        [](const StateHash& hash, uint64_t value) { return hash.step < value; }
+    );
+    return it != hashes.end() && it->step == step ? &*it : nullptr;
+}
+
+} // sim
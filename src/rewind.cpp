@@ -0,0 +1,250 @@
+#include "sim/rewind.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace sim {
+
+namespace {
+
+const size_t GAME_WORDS = (sizeof(data::Game) + 7) / 8;
+
+// Largest encoded state, a token of two varints for every other word
+const size_t MAX_ENCODED = GAME_WORDS * 8 + (GAME_WORDS / 2 + 1) * 2 * 3;
+
+uint64_t loadWord(const data::Game& game, size_t wi)
+{
+    uint64_t word = 0;
+    memcpy(&word, reinterpret_cast<const uint8_t*>(&game) + wi * 8,
+           std::min<size_t>(8, sizeof(data::Game) - wi * 8));
+    return word;
+}
+
+void storeWord(data::Game& game, size_t wi, uint64_t word)
+{
+    memcpy(reinterpret_cast<uint8_t*>(&game) + wi * 8, &word,
+           std::min<size_t>(8, sizeof(data::Game) - wi * 8));
+}
+
+void putVarint(std::vector<uint8_t>& out, size_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(value | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+size_t getVarint(const uint8_t*& in)
+{
+    size_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+/**
+ * @brief Encodes the words of game that differ from base, see RewindBuffer.
+ *
+ * @param game State to encode.
+ * @param base State to XOR with, nullptr for zeros.
+ * @param out Cleared and set to the tokens.
+ */
+void encode(const data::Game& game, const data::Game* base, std::vector<uint8_t>& out)
+{
+    uint64_t words[GAME_WORDS];
+    for (size_t wi = 0; wi < GAME_WORDS; ++wi) {
+        words[wi] = loadWord(game, wi) ^ (base ? loadWord(*base, wi) : 0);
+    }
+
+    out.clear();
+    size_t wi = 0;
+    while (wi < GAME_WORDS) {
+        size_t skipStart = wi;
+        while (wi < GAME_WORDS && !words[wi]) {
+            ++wi;
+        }
+        // Unchanged words at the end need no token
+        if (wi == GAME_WORDS) {
+            break;
+        }
+        size_t runStart = wi;
+        while (wi < GAME_WORDS && words[wi]) {
+            ++wi;
+        }
+
+        putVarint(out, runStart - skipStart);
+        putVarint(out, wi - runStart);
+        for (size_t ri = runStart; ri < wi; ++ri) {
+            for (size_t bi = 0; bi < 8; ++bi) {
+                out.push_back(words[ri] >> (8 * bi));
+            }
+        }
+    }
+}
+
+/**
+ * @brief XORs encoded words into a state.
+ */
+void decode(const uint8_t* in, size_t size, data::Game& game)
+{
+    const uint8_t* end = in + size;
+    size_t wi = 0;
+    while (in < end) {
+        wi += getVarint(in);
+        size_t run = getVarint(in);
+        for (size_t ri = 0; ri < run; ++ri, ++wi, in += 8) {
+            uint64_t word;
+            memcpy(&word, in, 8);
+            storeWord(game, wi, loadWord(game, wi) ^ word);
+        }
+    }
+}
+
+} // namespace
+
+RewindBuffer::RewindBuffer(size_t maxSnapshots, size_t maxBytes, size_t keyInterval)
+    : keyInterval(std::clamp<size_t>(
+          keyInterval, 1, std::max<size_t>(std::min(maxSnapshots / 2, maxBytes / (2 * MAX_ENCODED)), 1)
+      ))
+{
+    // Dropping the oldest keyframe interval from a full ring still leaves
+    // maxSnapshots states
+    entries.resize(std::max<size_t>(maxSnapshots, 1) + this->keyInterval);
+    bytes.resize(std::max(maxBytes, 2 * MAX_ENCODED));
+    scratch.reserve(MAX_ENCODED);
+}
+
+void RewindBuffer::clear()
+{
+    first = 0;
+    count = 0;
+    head = 0;
+    payload = 0;
+    sinceKey = 0;
+}
+
+void RewindBuffer::push(const data::Game& game)
+{
+    if (count == entries.size()) {
+        dropOldest();
+    }
+
+    bool key = count == 0 || sinceKey + 1 >= keyInterval;
+    encode(game, key ? nullptr : &latest, scratch);
+    reserve(scratch.size());
+    // Making room may have dropped the keyframe the delta builds on
+    if (!key && count == 0) {
+        key = true;
+        encode(game, nullptr, scratch);
+        reserve(scratch.size());
+    }
+
+    std::copy(scratch.begin(), scratch.end(), bytes.begin() + head);
+    entries[(first + count) % entries.size()] = {head, static_cast<uint32_t>(scratch.size()), key};
+    ++count;
+    head += scratch.size();
+    payload += scratch.size();
+    sinceKey = key ? 0 : sinceKey + 1;
+    latest = game;
+}
+
+bool RewindBuffer::restore(size_t back, data::Game& game) const
+{
+    if (back >= count) {
+        return false;
+    }
+    if (back == 0) {
+        game = latest;
+        return true;
+    }
+
+    size_t index = count - 1 - back;
+    size_t key = index;
+    while (!entry(key).key) {
+        --key;
+    }
+    memset(static_cast<void*>(&game), 0, sizeof(game));
+    for (size_t ei = key; ei <= index; ++ei) {
+        decode(bytes.data() + entry(ei).offset, entry(ei).size, game);
+    }
+    return true;
+}
+
+bool RewindBuffer::pop(data::Game& game)
+{
+    if (count < 2) {
+        return false;
+    }
+
+    // The state before the newest becomes the base of the next delta
+    restore(1, latest);
+    const Entry& newest = entry(count - 1);
+    head = newest.offset;
+    payload -= newest.size;
+    --count;
+
+    sinceKey = 0;
+    while (!entry(count - 1 - sinceKey).key) {
+        ++sinceKey;
+    }
+    game = latest;
+    return true;
+}
+
+size_t RewindBuffer::size() const
+{
+    return count;
+}
+
+RewindStats RewindBuffer::getStats() const
+{
+    return {
+        count, payload, bytes.size(),
+        sizeof(*this) + bytes.capacity() + entries.capacity() * sizeof(Entry) + scratch.capacity()
+    };
+}
+
+const RewindBuffer::Entry& RewindBuffer::entry(size_t index) const
+{
+    return entries[(first + index) % entries.size()];
+}
+
+void RewindBuffer::reserve(size_t size)
+{
+    while (count) {
+        size_t tail = entry(0).offset;
+        if (head > tail) {
+            // Held states are in one piece, room is after them or, by
+            // starting over at the front, before them
+            if (bytes.size() - head >= size) {
+                return;
+            }
+            if (tail >= size) {
+                head = 0;
+                return;
+            }
+        } else if (tail - head >= size) {
+            return;
+        }
+        dropOldest();
+    }
+    head = 0;
+}
+
+void RewindBuffer::dropOldest()
+{
+    do {
+        payload -= entry(0).size;
+        first = (first + 1) % entries.size();
+        --count;
+    } while (count && !entry(0).key);
+    if (!count) {
+        head = 0;
+    }
+}
+
+} // sim
@@ -0,0 +1,185 @@
+#include "sim/shields.hpp"
+#include <algorithm>
+#include "sprites/shield.hpp"
+
+namespace sim {
+
+namespace {
+
+const ptrdiff_t WIDTH = static_cast<ptrdiff_t>(data::SHIELD_WIDTH);
+const ptrdiff_t HEIGHT = static_cast<ptrdiff_t>(data::SHIELD_HEIGHT);
+
+/**
+ * @brief Gathers a row of a shield from its banks.
+ */
+uint32_t loadRow(const data::ShieldStore& shields, size_t si, size_t row)
+{
+    uint32_t bits = 0;
+    for (size_t bank = 0; bank < data::SHIELD_BANKS; ++bank) {
+        bits |= static_cast<uint32_t>(shields.rows[si][bank][row]) << (data::PACKED_MAX_WIDTH * bank);
+    }
+    return bits;
+}
+
+/**
+ * @brief Spreads a row of a shield over its banks.
+ */
+void storeRow(data::ShieldStore& shields, size_t si, size_t row, uint32_t bits)
+{
+    for (size_t bank = 0; bank < data::SHIELD_BANKS; ++bank) {
+        shields.rows[si][bank][row] = static_cast<uint16_t>(bits >> (data::PACKED_MAX_WIDTH * bank));
+    }
+}
+
+/**
+ * @brief Moves a packed sprite row to a column of a shield row.
+ *
+ * @param bits Packed row, bit xi for pixel xi.
+ * @param dx Column of the shield pixel 0 lands on, may be negative.
+ */
+uint32_t placeRow(uint16_t bits, ptrdiff_t dx)
+{
+    if (dx >= 32 || dx <= -static_cast<ptrdiff_t>(data::PACKED_MAX_WIDTH)) {
+        return 0;
+    }
+    return dx >= 0 ? static_cast<uint32_t>(static_cast<uint64_t>(bits) << dx) : bits >> -dx;
+}
+
+/**
+ * @brief Moves a row of a collision mask to a column of a shield row.
+ *
+ * @param row Words of the mask row, followed by a clear word.
+ * @param words Number of words holding the pixels of the row.
+ * @param dx Column of the shield pixel 0 lands on, may be negative.
+ */
+uint32_t placeMaskRow(const uint64_t* row, size_t words, ptrdiff_t dx)
+{
+    if (dx >= 32) {
+        return 0;
+    }
+    if (dx >= 0) {
+        return static_cast<uint32_t>(row[0] << dx);
+    }
+    const size_t skip = static_cast<size_t>(-dx);
+    const size_t word = skip / 64;
+    const unsigned shift = static_cast<unsigned>(skip % 64);
+    if (word >= words) {
+        return 0;
+    }
+    uint64_t bits = row[word] >> shift;
+    if (shift) {
+        bits |= row[word + 1] << (64 - shift);
+    }
+    return static_cast<uint32_t>(bits);
+}
+
+/**
+ * @brief Rows of a sprite that fall on a shield.
+ *
+ * @var offset Shield row of sprite row 0, rows are stored top first.
+ * @var first First sprite row on the shield.
+ * @var last One past the last sprite row on the shield.
+ */
+struct RowSpan {
+    ptrdiff_t offset;
+    ptrdiff_t first;
+    ptrdiff_t last;
+};
+
+/**
+ * @brief Gets the rows of a sprite at a position that fall on a shield.
+ */
+RowSpan rowSpan(const data::ShieldStore& shields, size_t si, size_t spriteHeight, ptrdiff_t y)
+{
+    const ptrdiff_t height = static_cast<ptrdiff_t>(spriteHeight);
+    const ptrdiff_t offset = shields.y[si] + HEIGHT - y - height;
+    return {offset, std::max<ptrdiff_t>(0, -offset), std::min(height, HEIGHT - offset)};
+}
+
+/**
+ * @brief Checks whether a box overlaps the box of a shield.
+ */
+bool overlapsShield(const data::ShieldStore& shields, size_t si, ptrdiff_t x, ptrdiff_t y, size_t width, size_t height)
+{
+    return x < shields.x[si] + WIDTH && x + static_cast<ptrdiff_t>(width) > shields.x[si]
+        && y < shields.y[si] + HEIGHT && y + static_cast<ptrdiff_t>(height) > shields.y[si];
+}
+
+} // namespace
+
+void resetShields(data::ShieldStore& shields, size_t width, size_t y)
+{
+    // Each shield is centered in its share of the screen
+    const size_t spacing = width / data::SHIELD_COUNT;
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        shields.x[si] = static_cast<int16_t>(spacing * si + (spacing - data::SHIELD_WIDTH) / 2);
+        shields.y[si] = static_cast<int16_t>(y);
+        for (size_t bank = 0; bank < data::SHIELD_BANKS; ++bank) {
+            std::copy_n(sprites::SHIELD_PACKED.data() + bank * data::SHIELD_HEIGHT, data::SHIELD_HEIGHT,
+                        shields.rows[si][bank]);
+        }
+    }
+}
+
+data::PackedSprite shieldBank(const data::ShieldStore& shields, size_t si, size_t bank)
+{
+    size_t width = std::min(data::PACKED_MAX_WIDTH, data::SHIELD_WIDTH - data::PACKED_MAX_WIDTH * bank);
+    return {{width, data::SHIELD_HEIGHT}, shields.rows[si][bank]};
+}
+
+size_t hitShield(const data::ShieldStore& shields, const data::CollisionMask& mask, size_t x, size_t y)
+{
+    // Positions may have wrapped below 0, treat them as signed
+    const ptrdiff_t sx = static_cast<ptrdiff_t>(x);
+    const ptrdiff_t sy = static_cast<ptrdiff_t>(y);
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        if (!overlapsShield(shields, si, sx, sy, mask.width, mask.height)) {
+            continue;
+        }
+        // Mask rows count from the bottom, shield rows from the top
+        const ptrdiff_t bottom = std::max<ptrdiff_t>(sy, shields.y[si]);
+        const ptrdiff_t top = std::min<ptrdiff_t>(sy + static_cast<ptrdiff_t>(mask.height), shields.y[si] + HEIGHT);
+        const ptrdiff_t dx = sx - shields.x[si];
+        for (ptrdiff_t yy = bottom; yy < top; ++yy) {
+            const size_t row = static_cast<size_t>(shields.y[si] + HEIGHT - 1 - yy);
+            if (loadRow(shields, si, row) & placeMaskRow(mask.getRow(static_cast<size_t>(yy - sy)), mask.getWords(), dx)) {
+                return si;
+            }
+        }
+    }
+    return data::SHIELD_COUNT;
+}
+
+void erodeShield(data::ShieldStore& shields, size_t si, const data::PackedSprite& sprite, size_t x, size_t y)
+{
+    const ptrdiff_t sy = static_cast<ptrdiff_t>(y);
+    const RowSpan span = rowSpan(shields, si, sprite.height, sy);
+    const ptrdiff_t dx = static_cast<ptrdiff_t>(x) - shields.x[si];
+    for (ptrdiff_t yi = span.first; yi < span.last; ++yi) {
+        size_t row = static_cast<size_t>(span.offset + yi);
+        storeRow(shields, si, row, loadRow(shields, si, row) & ~placeRow(sprite.rows[yi], dx));
+    }
+}
+
+void clearShields(data::ShieldStore& shields, const data::Region& box)
+{
+    const ptrdiff_t bx = static_cast<ptrdiff_t>(box.x);
+    const ptrdiff_t by = static_cast<ptrdiff_t>(box.y);
+    for (size_t si = 0; si < data::SHIELD_COUNT; ++si) {
+        if (!overlapsShield(shields, si, bx, by, box.width, box.height)) {
+            continue;
+        }
+        // Columns of the box as a mask of a shield row
+        ptrdiff_t from = std::max<ptrdiff_t>(bx - shields.x[si], 0);
+        ptrdiff_t to = std::min<ptrdiff_t>(bx + static_cast<ptrdiff_t>(box.width) - shields.x[si], WIDTH);
+        uint32_t mask = static_cast<uint32_t>(((uint64_t{1} << to) - 1) & ~((uint64_t{1} << from) - 1));
+
+        const RowSpan span = rowSpan(shields, si, box.height, by);
+        for (ptrdiff_t yi = span.first; yi < span.last; ++yi) {
+            size_t row = static_cast<size_t>(span.offset + yi);
+            storeRow(shields, si, row, loadRow(shields, si, row) & ~mask);
+        }
+    }
+}
+
+} // sim
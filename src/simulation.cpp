@@ -0,0 +1,180 @@
+#include "sim/simulation.hpp"
+#include <algorithm>
+#include "sim/game.hpp"
+
+namespace sim {
+
+namespace {
+
+// Falling further behind than this skips steps instead of catching up
+const int MAX_LAG_STEPS = 8;
+
+} // namespace
+
+Simulation::Simulation(const data::Game& initial, double rate)
+    : stepDuration(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / rate))),
+      game(initial),
+      snapshots(Snapshot{initial, std::chrono::steady_clock::now(), 0}),
+      previous(snapshots.read()),
+      current(snapshots.read()),
+      blended(initial)
+{
+    buildAlienGrid(grid, game);
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start()
+{
+    if (running.exchange(true)) {
+        return;
+    }
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+ControlWriter& Simulation::getControls()
+{
+    return controls;
+}
+
+void Simulation::setInput(const data::Input& input)
+{
+    controls.send(input, inputClock());
+}
+
+void Simulation::setRecorder(InputRecorder* recorder)
+{
+    this->recorder = recorder;
+}
+
+void Simulation::setRewind(RewindBuffer* rewind)
+{
+    this->rewind = rewind;
+    if (rewind) {
+        rewind->clear();
+        rewind->push(game);
+    }
+}
+
+void Simulation::step()
+{
+    advance(std::chrono::steady_clock::now());
+}
+
+const data::Game& Simulation::frame()
+{
+    if (snapshots.fetch()) {
+        previous = current;
+        current = snapshots.read();
+    }
+    if (!running) {
+        return current.game;
+    }
+
+    // Draw one step in the past, so there are two snapshots to blend
+    // between unless the simulation itself is late
+    auto renderTime = std::chrono::steady_clock::now() - stepDuration;
+    double alpha = 1.0;
+    if (current.time > previous.time) {
+        alpha = std::chrono::duration<double>(renderTime - previous.time)
+              / std::chrono::duration<double>(current.time - previous.time);
+        alpha = std::clamp(alpha, 0.0, 1.0);
+    }
+    interpolate(previous.game, current.game, alpha, blended);
+    return blended;
+}
+
+void Simulation::presented()
+{
+    const int64_t now = inputClock();
+    while (const InputStamp* stamp = stamps.peek()) {
+        if (stamp->step > current.step) {
+            break;
+        }
+        latency.record(now - stamp->time);
+        InputStamp taken;
+        stamps.pop(taken);
+    }
+}
+
+const LatencyStats& Simulation::getInputLatency() const
+{
+    return latency;
+}
+
+size_t Simulation::getSteps() const
+{
+    return steps;
+}
+
+size_t Simulation::getDroppedSteps() const
+{
+    return droppedSteps;
+}
+
+void Simulation::advance(std::chrono::steady_clock::time_point time)
+{
+    // Every event queued since the last step counts for this one. Stamps
+    // that do not fit the queue back go unmeasured.
+    const size_t step = steps + 1;
+    ControlEvent event;
+    while (controlQueue.pop(event)) {
+        controlState.apply(event);
+        stamps.push({event.time, step});
+    }
+    const data::Input input = controlState.take();
+
+    // Rewinding goes back a state per step until the oldest kept
+    if (input.rewind && rewind) {
+        if (rewind->pop(game)) {
+            buildAlienGrid(grid, game);
+        }
+    } else {
+        sim::step(game, input, grid);
+        if (rewind) {
+            rewind->push(game);
+        }
+    }
+    if (recorder) {
+        recorder->record(input, game);
+    }
+
+    Snapshot& snapshot = snapshots.write();
+    snapshot.game = game;
+    snapshot.time = time;
+    snapshot.step = step;
+    snapshots.publish();
+    ++steps;
+}
+
+void Simulation::run()
+{
+    auto next = std::chrono::steady_clock::now();
+    while (running) {
+        advance(next);
+        next += stepDuration;
+
+        // Late steps run back to back until the schedule is met again,
+        // unless the thread was stalled for long
+        auto now = std::chrono::steady_clock::now();
+        if (now - next > MAX_LAG_STEPS * stepDuration) {
+            droppedSteps += (now - next) / stepDuration;
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+} // sim
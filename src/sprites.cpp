@@ -1,11 +1,10 @@
 #include "sprites/aliens.hpp"
 #include "sprites/player.hpp"
+#include "sprites/shield.hpp"
 #include "sprites/text.hpp"
 
 namespace sprites {
 
-static data::Sprite** animationFrames[3] = {nullptr, nullptr, nullptr};
-
 const data::Sprite ALIEN_SPRITES[6] {
     // Alien 1
     {
@@ -44,10 +43,28 @@ const data::Sprite ALIEN_DEATH_SPRITE {
     const_cast<uint8_t*>(ALIEN_DEATH)
 };
 
-data::SpriteAnimation ALIEN_ANIMATIONS[3] = {
-     {true, 2, 10, 0, nullptr},
-     {true, 2, 10, 0, nullptr},
-     {true, 2, 10, 0, nullptr},
+const data::PackedSprite ALIEN_SPRITES_PACKED[6] {
+    {{8, 8}, ALIEN_SPRITE_1_PACKED.data()},
+    {{8, 8}, ALIEN_SPRITE_2_PACKED.data()},
+    {{11, 8}, ALIEN_SPRITE_3_PACKED.data()},
+    {{11, 8}, ALIEN_SPRITE_4_PACKED.data()},
+    {{12, 8}, ALIEN_SPRITE_5_PACKED.data()},
+    {{12, 8}, ALIEN_SPRITE_6_PACKED.data()},
+};
+
+const data::PackedSprite ALIEN_DEATH_SPRITE_PACKED {
+    {13, 7}, // width, height
+    ALIEN_DEATH_PACKED.data()
+};
+
+// Built from the sprites above, which are constant initialized
+const data::CollisionMask ALIEN_MASKS[6] {
+    data::CollisionMask(ALIEN_SPRITES[0]),
+    data::CollisionMask(ALIEN_SPRITES[1]),
+    data::CollisionMask(ALIEN_SPRITES[2]),
+    data::CollisionMask(ALIEN_SPRITES[3]),
+    data::CollisionMask(ALIEN_SPRITES[4]),
+    data::CollisionMask(ALIEN_SPRITES[5]),
 };
 
 const data::Sprite PLAYER_SPRITE{
@@ -60,6 +77,24 @@ const data::Sprite BULLET_SPRITE{
     const_cast<uint8_t*>(BULLET)
 };
 
+const data::PackedSprite PLAYER_SPRITE_PACKED{
+    {11, 7}, // width, height
+    PLAYER_PACKED.data()
+};
+
+const data::PackedSprite BULLET_SPRITE_PACKED{
+    {1, 3}, // width, height
+    BULLET_PACKED.data()
+};
+
+const data::PackedSprite SHIELD_CRATER_SPRITE_PACKED{
+    {8, 8}, // width, height
+    SHIELD_CRATER_PACKED.data()
+};
+
+const data::CollisionMask PLAYER_MASK(PLAYER_SPRITE);
+const data::CollisionMask BULLET_MASK(BULLET_SPRITE);
+
 const data::Sprite TEXT_SPRITESHEET{
     {5, 7}, // width, height
     const_cast<uint8_t*>(TEXT_SP)
@@ -70,22 +105,14 @@ const data::Sprite NUMBER_SPRITESHEET{
     const_cast<uint8_t*>(TEXT_SP + 16 * 35)
 };
 
-void initializeAliens()
-{
-    for (size_t i = 0; i < 3; ++i) {
-        animationFrames[i] = new data::Sprite*[2];
-        animationFrames[i][0] = const_cast<data::Sprite*>(&ALIEN_SPRITES[2 * i]);
-        animationFrames[i][1] = const_cast<data::Sprite*>(&ALIEN_SPRITES[2 * i + 1]);
-        ALIEN_ANIMATIONS[i].frames = animationFrames[i];
-    }
-}
-
-void cleanupAliens()
-{
-    for (size_t i = 0; i < 3; ++i) {
-        delete[] animationFrames[i];
-        animationFrames[i] = nullptr;
-    }
-}
+const data::PackedSprite TEXT_SPRITESHEET_PACKED{
+    {5, 7}, // width, height
+    TEXT_SP_PACKED.data()
+};
+
+const data::PackedSprite NUMBER_SPRITESHEET_PACKED{
+    {5, 7}, // width, height
+    TEXT_SP_PACKED.data() + 16 * 7
+};
 
 } // sprites
@@ -0,0 +1,269 @@
+#include "render/texture_upload.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace render {
+
+namespace {
+
+/**
+ * @brief Columns of texels a region of the buffer covers.
+ *
+ * @var first First texel column.
+ * @var count Number of texel columns.
+ */
+struct TexelRange {
+    size_t first;
+    size_t count;
+};
+
+TexelRange texelRange(data::Buffer& buffer, const data::Region& region)
+{
+    if (buffer.getFormat() == data::FORMAT_MONO1) {
+        // 32 pixels per texel
+        size_t firstWord = region.x / 32;
+        size_t lastWord = (region.x + region.width + 31) / 32;
+        return {firstWord, lastWord - firstWord};
+    }
+    return {region.x, region.width};
+}
+
+size_t alignUp(size_t bytes, size_t alignment)
+{
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+TextureFormat textureFormatFor(data::Buffer& buffer, bool native)
+{
+    switch (buffer.getFormat()) {
+        case data::FORMAT_INDEXED8:
+            return {GL_R8UI, GL_RED_INTEGER, GL_UNSIGNED_BYTE, buffer.getWidth(), 1, false};
+        case data::FORMAT_MONO1:
+            // 32 pixels per texel, the shader picks out the bit
+            return {GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, buffer.getStride(), 4, false};
+        case data::FORMAT_RGBA32:
+        default:
+            break;
+    }
+
+    TextureFormat rgba{GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.getWidth(), 4, false};
+    if (!native) {
+        return rgba;
+    }
+
+    GLint format = GL_BGRA;
+    GLint type = GL_UNSIGNED_INT_8_8_8_8_REV;
+    if (GLEW_VERSION_4_3 || GLEW_ARB_internalformat_query2) {
+        glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_FORMAT, 1, &format);
+        glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_TEXTURE_IMAGE_TYPE, 1, &type);
+    }
+    if (format == GL_RGBA && type == GL_UNSIGNED_INT_8_8_8_8) {
+        return rgba;
+    }
+    // Everything else is closest to BGRA, which desktop drivers store natively
+    return {GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, buffer.getWidth(), 4, true};
+}
+
+TextureUploader::TextureUploader(
+    data::Buffer& buffer, const TextureFormat& texture,
+    bool ring, size_t numSlots
+)
+    : texture(texture), mode(UPLOAD_DIRECT)
+{
+    slotBytes = alignUp(texture.width * buffer.getHeight() * texture.texelBytes, 256);
+    if (!ring) {
+        return;
+    }
+
+    const size_t totalBytes = slotBytes * numSlots;
+    fences.assign(numSlots, nullptr);
+
+    glGenBuffers(1, &unpackBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, flags);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes, flags));
+        if (mapped) {
+            mode = UPLOAD_PERSISTENT;
+        } else {
+            // Storage is immutable, start over with a fresh buffer
+            glDeleteBuffers(1, &unpackBuffer);
+            glGenBuffers(1, &unpackBuffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        }
+    }
+    if (!mapped) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+        mode = UPLOAD_STREAMED;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureUploader::~TextureUploader()
+{
+    for (GLsync fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    if (unpackBuffer) {
+        glDeleteBuffers(1, &unpackBuffer);
+    }
+}
+
+UploadMode TextureUploader::getMode() const
+{
+    return mode;
+}
+
+const UploadStats& TextureUploader::getStats() const
+{
+    return stats;
+}
+
+void TextureUploader::upload(data::Buffer& buffer, const std::vector<data::Region>& regions)
+{
+    if (regions.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    size_t bytes = 0;
+    if (mode == UPLOAD_DIRECT && !texture.argb) {
+        uploadDirect(buffer, regions);
+        for (const data::Region& region : regions) {
+            bytes += texelRange(buffer, region).count * texture.texelBytes * region.height;
+        }
+    } else {
+        bytes = uploadStaged(buffer, regions);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double micros = std::chrono::duration<double, std::micro>(end - start).count();
+    ++stats.frames;
+    stats.bytes += bytes;
+    stats.lastMicros = micros;
+    stats.totalMicros += micros;
+    stats.maxMicros = std::max(stats.maxMicros, micros);
+}
+
+void TextureUploader::uploadDirect(data::Buffer& buffer, const std::vector<data::Region>& regions)
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, buffer.getStride() * 4 / texture.texelBytes);
+    for (const data::Region& region : regions) {
+        TexelRange range = texelRange(buffer, region);
+        const uint8_t* row = reinterpret_cast<const uint8_t*>(buffer.getData() + region.y * buffer.getStride());
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, range.first, region.y, range.count, region.height,
+            texture.format, texture.type, row + range.first * texture.texelBytes
+        );
+    }
+}
+
+size_t TextureUploader::uploadStaged(data::Buffer& buffer, const std::vector<data::Region>& regions)
+{
+    // Regions are staged with tightly packed rows, each starting on a word
+    size_t bytes = 0;
+    for (const data::Region& region : regions) {
+        bytes += alignUp(texelRange(buffer, region).count * texture.texelBytes * region.height, 4);
+    }
+
+    // Merged regions may overlap, if they add up to more than a slot the
+    // whole buffer goes up instead
+    std::vector<data::Region> whole;
+    if (bytes > slotBytes) {
+        whole.push_back({{0, 0}, {buffer.getWidth(), buffer.getHeight()}});
+        bytes = alignUp(texture.width * texture.texelBytes * buffer.getHeight(), 4);
+    }
+    const std::vector<data::Region>& staged = whole.empty() ? regions : whole;
+
+    // Direct uploads of converted pixels are staged in client memory
+    bool inSlot = mode != UPLOAD_DIRECT;
+    if (inSlot && fences[slot]) {
+        if (glClientWaitSync(fences[slot], 0, 0) == GL_TIMEOUT_EXPIRED) {
+            // The GPU still reads this slot, stage in client memory this
+            // time and let the driver copy it rather than waiting
+            ++stats.busySlots;
+            inSlot = false;
+        } else {
+            glDeleteSync(fences[slot]);
+            fences[slot] = nullptr;
+        }
+    }
+
+    uint8_t* dst = nullptr;
+    uintptr_t base = 0;
+    if (inSlot) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        base = slot * slotBytes;
+        if (mode == UPLOAD_PERSISTENT) {
+            dst = mapped + base;
+        } else {
+            const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            dst = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, base, bytes, access));
+            if (!dst) {
+                // Mapping failed, stage in client memory as for a busy slot
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                inSlot = false;
+            }
+        }
+    }
+    if (!inSlot) {
+        scratch.resize(bytes);
+        dst = scratch.data();
+        base = reinterpret_cast<uintptr_t>(dst);
+    }
+
+    size_t offset = 0;
+    for (const data::Region& region : staged) {
+        TexelRange range = texelRange(buffer, region);
+        const size_t rowBytes = range.count * texture.texelBytes;
+        for (size_t yi = region.y; yi < region.y + region.height; ++yi, offset += rowBytes) {
+            const uint32_t* row = buffer.getData() + yi * buffer.getStride();
+            const uint8_t* src = reinterpret_cast<const uint8_t*>(row) + range.first * texture.texelBytes;
+            if (texture.argb) {
+                data::blit::copyToArgb(
+                    reinterpret_cast<const uint32_t*>(src), range.count,
+                    reinterpret_cast<uint32_t*>(dst + offset)
+                );
+            } else {
+                std::memcpy(dst + offset, src, rowBytes);
+            }
+        }
+        offset = alignUp(offset, 4);
+    }
+
+    if (inSlot && mode == UPLOAD_STREAMED) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    offset = 0;
+    for (const data::Region& region : staged) {
+        TexelRange range = texelRange(buffer, region);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, range.first, region.y, range.count, region.height,
+            texture.format, texture.type, reinterpret_cast<const void*>(base + offset)
+        );
+        offset += alignUp(range.count * texture.texelBytes * region.height, 4);
+    }
+
+    if (inSlot) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot = (slot + 1) % fences.size();
+    }
+    return bytes;
+}
+
+} // render
@@ -0,0 +1,147 @@
+#include "util/thread_pool.hpp"
+#include <algorithm>
+
+namespace util {
+
+namespace {
+
+uint64_t packRange(uint64_t begin, uint64_t end)
+{
+    return begin << 32 | end;
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t numThreads)
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ranges = std::make_unique<Range[]>(numThreads);
+    for (size_t i = 1; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(size_t numTasks, const std::function<void(size_t)>& fn)
+{
+    if (workers.empty() || numTasks <= 1) {
+        for (size_t i = 0; i < numTasks; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        const size_t numThreads = size();
+        for (size_t i = 0; i < numThreads; ++i) {
+            ranges[i].bounds.store(
+                packRange(numTasks * i / numThreads, numTasks * (i + 1) / numThreads),
+                std::memory_order_relaxed
+            );
+        }
+        busy = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t self)
+{
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runTasks(self);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTasks(size_t self)
+{
+    size_t index;
+    while (take(self, index) || (steal(self) && take(self, index))) {
+        (*task)(index);
+    }
+}
+
+bool ThreadPool::take(size_t self, size_t& index)
+{
+    std::atomic<uint64_t>& bounds = ranges[self].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    while (true) {
+        uint64_t begin = current >> 32;
+        uint64_t end = current & 0xFFFFFFFF;
+        if (begin >= end) {
+            return false;
+        }
+        // A thief may shrink the range at the same time, retry on its value
+        if (bounds.compare_exchange_weak(current, packRange(begin + 1, end), std::memory_order_acq_rel)) {
+            index = static_cast<size_t>(begin);
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(size_t self)
+{
+    const size_t numThreads = size();
+    for (size_t offset = 1; offset < numThreads; ++offset) {
+        std::atomic<uint64_t>& bounds = ranges[(self + offset) % numThreads].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        while (true) {
+            uint64_t begin = current >> 32;
+            uint64_t end = current & 0xFFFFFFFF;
+            if (begin >= end) {
+                break;
+            }
+            // The victim keeps the front half, a single index is taken whole
+            uint64_t middle = begin + (end - begin) / 2;
+            if (bounds.compare_exchange_weak(current, packRange(begin, middle), std::memory_order_acq_rel)) {
+                // Nobody steals from an empty range, so the own range can
+                // simply be replaced
+                ranges[self].bounds.store(packRange(middle, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // util
@@ -1,41 +1,37 @@
 #include "util/utility.hpp"
-#include <cstdio>
+#include <cstring>
 
 namespace util {
 
-uint32_t rgbToUint32(uint8_t r, uint8_t g, uint8_t b)
+namespace {
+
+const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+uint64_t readWord(const uint8_t* in)
 {
-    // Setting alpha to full opacity ----------|
-    //                                         v
-    return (r << 24) | (g << 16) | (b << 8) | 0xFF;
+    uint64_t word;
+    memcpy(&word, in, sizeof(word));
+    return word;
 }
 
-void validateShader(GLuint shader, const char* file)
+uint64_t rotate(uint64_t value, unsigned bits)
 {
-    static const unsigned int BUFFER_SIZE = 512;
-    char buffer[BUFFER_SIZE];
-    GLsizei length = 0;
-
-    glGetShaderInfoLog(shader, BUFFER_SIZE, &length, buffer);
+    return (value << bits) | (value >> (64 - bits));
+}
 
-    if (length > 0) {
-        printf("Shader %d(%s) compile error: %s\n",
-               shader, (file ? file : ""), buffer);
-    }
+uint64_t mixWord(uint64_t lane, uint64_t word)
+{
+    return rotate(lane + word * PRIME_2, 31) * PRIME_1;
 }
 
-bool validateProgram(GLuint program)
+} // namespace
+
+uint32_t rgbToUint32(uint8_t r, uint8_t g, uint8_t b)
 {
-    static const GLsizei BUFFER_SIZE = 512;
-    GLchar buffer[BUFFER_SIZE];
-    GLsizei length = 0;
-
-    glGetProgramInfoLog(program, BUFFER_SIZE, &length, buffer);
-    if (length > 0) {
-        printf("Program %d link error: %s\n", program, buffer);
-        return false;
-    }
-    return true;
+    // Setting alpha to full opacity ----------|
+    //                                         v
+    return (r << 24) | (g << 16) | (b << 8) | 0xFF;
 }
 
 bool spriteOverlapCheck(
@@ -43,15 +39,38 @@ bool spriteOverlapCheck(
     const data::Sprite& spB, size_t xB, size_t yB
 ){
     if (xA < xB + spB.width && xA + spA.width > xB
-        && yA < yB + spB.height && yA + spB.height > yB) {
+        && yA < yB + spB.height && yA + spA.height > yB) {
         return true;
     }
     return false;
 }
 
-void errorCallback(int error, const char* description)
+uint64_t hash64(const void* data, size_t size, uint64_t seed)
 {
-    fprintf(stderr, "Error %d: %s\n", error, description);
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    const uint8_t* end = in + size;
+    uint64_t lanes[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+    for (; end - in >= 32; in += 32) {
+        for (size_t li = 0; li < 4; ++li) {
+            lanes[li] = mixWord(lanes[li], readWord(in + 8 * li));
+        }
+    }
+
+    uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+    hash += size;
+    for (; end - in >= 8; in += 8) {
+        hash = rotate(hash ^ mixWord(0, readWord(in)), 27) * PRIME_1 + PRIME_2;
+    }
+    for (; in < end; ++in) {
+        hash = rotate(hash ^ (*in * PRIME_1), 11) * PRIME_2;
+    }
+
+    // Spread every input bit over the whole result
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_1;
+    return hash ^ (hash >> 32);
 }
 
 } // util
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "sim/batch.hpp"
+#include "util/thread_pool.hpp"
+
+namespace {
+
+void printUsage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [--games=N] [--frames=N] [--threads=N] [--lockstep] [--render]\n"
+            "          [--format=rgba32|indexed8|mono1] [--scaling]\n"
+            "Steps N independent games with autopilot input and reports game\n"
+            "frames per second. --lockstep advances all games one step at a\n"
+            "time, --scaling repeats the run on 1, 2, 4, ... threads.\n",
+            name);
+}
+
+/**
+ * @brief Result of one batch run.
+ *
+ * @var seconds Wall time the run took.
+ * @var checksum Sum over every game of its score times 31 plus its
+ *      living aliens, equal for equal runs.
+ */
+struct RunResult {
+    double seconds;
+    size_t checksum;
+};
+
+RunResult runBatch(
+    size_t numGames, size_t frames, size_t numThreads,
+    bool lockstep, bool render, data::PixelFormat format
+){
+    sim::Batch batch(numGames, 224, 256, render, format);
+    std::unique_ptr<util::ThreadPool> pool;
+    if (numThreads != 1) {
+        pool = std::make_unique<util::ThreadPool>(numThreads);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (lockstep) {
+        for (size_t fi = 0; fi < frames; ++fi) {
+            batch.run(1, pool.get());
+        }
+    } else {
+        batch.run(frames, pool.get());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    size_t checksum = 0;
+    for (size_t gi = 0; gi < batch.size(); ++gi) {
+        checksum += batch.getGame(gi).score * 31 + batch.getGame(gi).aliens.numAlive;
+    }
+    return {std::chrono::duration<double>(end - start).count(), checksum};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t numGames = 1024;
+    size_t frames = 1000;
+    size_t numThreads = 0;
+    bool lockstep = false;
+    bool render = false;
+    bool scaling = false;
+    data::PixelFormat format = data::FORMAT_RGBA32;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--games=", 8) == 0) {
+            numGames = strtoul(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            frames = strtoul(argv[i] + 9, NULL, 10);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            numThreads = strtoul(argv[i] + 10, NULL, 10);
+        } else if (strcmp(argv[i], "--lockstep") == 0) {
+            lockstep = true;
+        } else if (strcmp(argv[i], "--render") == 0) {
+            render = true;
+        } else if (strcmp(argv[i], "--format=rgba32") == 0) {
+            format = data::FORMAT_RGBA32;
+        } else if (strcmp(argv[i], "--format=indexed8") == 0) {
+            format = data::FORMAT_INDEXED8;
+        } else if (strcmp(argv[i], "--format=mono1") == 0) {
+            format = data::FORMAT_MONO1;
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (!numGames || !frames) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    printf("%zu games, %zu frames each%s%s\n", numGames, frames,
+           lockstep ? ", lockstep" : "", render ? ", rendered" : "");
+    printf("%8s %16s %10s %10s\n", "threads", "game frames/s", "speedup", "checksum");
+
+    size_t first = scaling ? 1 : numThreads;
+    double baseline = 0.0;
+    size_t checksum = 0;
+    for (size_t threads = first; threads <= numThreads; threads = threads < numThreads ? std::min(2 * threads, numThreads) : numThreads + 1) {
+        RunResult result = runBatch(numGames, frames, threads, lockstep, render, format);
+        double rate = numGames * frames / result.seconds;
+        if (baseline == 0.0) {
+            baseline = rate;
+            checksum = result.checksum;
+        }
+        printf("%8zu %16.0f %9.2fx %10zu\n", threads, rate, rate / baseline, result.checksum);
+        if (result.checksum != checksum) {
+            fprintf(stderr, "Games played differently on %zu threads.\n", threads);
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "render/frame_file.hpp"
+
+namespace {
+
+void printUsage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s FILE [OUT_DIR] [--frame=N] [--every=N] [--png]\n"
+            "Prints a summary of a frame capture. With OUT_DIR, writes every\n"
+            "stored frame, every Nth stored frame or only captured frame N\n"
+            "as PPM or PNG images.\n",
+            name);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    std::string outDir;
+    long frame = -1;
+    size_t every = 1;
+    bool png = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--frame=", 8) == 0) {
+            frame = strtol(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--every=", 8) == 0) {
+            every = strtoul(argv[i] + 8, NULL, 10);
+        } else if (strcmp(argv[i], "--png") == 0) {
+            png = true;
+        } else if (argv[i][0] != '-' && path.empty()) {
+            path = argv[i];
+        } else if (argv[i][0] != '-' && outDir.empty()) {
+            outDir = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (path.empty() || !every) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    render::FrameFileReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "Error reading frame file %s.\n", path.c_str());
+        return -1;
+    }
+
+    const render::FrameFileHeader& header = reader.getHeader();
+    const std::vector<render::FrameRecord>& records = reader.getRecords();
+    size_t keyframes = 0;
+    size_t payloadBytes = 0;
+    for (const render::FrameRecord& record : records) {
+        keyframes += record.flags & render::FRAME_KEY ? 1 : 0;
+        payloadBytes += record.size;
+    }
+    size_t span = records.empty() ? 0 : records.back().frame + 1;
+    printf("%s: %ux%u, %zu frames stored of the first %zu captured, %zu keyframes, %.1f bytes per frame\n",
+           path.c_str(), header.width, header.height,
+           records.size(), span, keyframes,
+           records.empty() ? 0.0 : static_cast<double>(payloadBytes) / records.size());
+
+    if (outDir.empty()) {
+        return 0;
+    }
+
+    size_t first = 0;
+    size_t last = records.size();
+    if (frame >= 0) {
+        // Dropped frames leave gaps, look the frame up by its number
+        first = 0;
+        while (first < records.size() && records[first].frame < static_cast<size_t>(frame)) {
+            ++first;
+        }
+        if (first == records.size() || records[first].frame != static_cast<size_t>(frame)) {
+            fprintf(stderr, "Frame %ld was not stored.\n", frame);
+            return -1;
+        }
+        last = first + 1;
+    }
+
+    size_t written = 0;
+    for (size_t i = first; i < last; i += every) {
+        const uint32_t* pixels = reader.decode(i);
+        if (!pixels) {
+            fprintf(stderr, "Error decoding frame %zu.\n", i);
+            return -1;
+        }
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/frame_%06u.%s", outDir.c_str(), records[i].frame, png ? "png" : "ppm");
+        bool ok = png
+            ? render::writePng(file, pixels, header.width, header.height)
+            : render::writePpm(file, pixels, header.width, header.height);
+        if (!ok) {
+            fprintf(stderr, "Error writing %s.\n", file);
+            return -1;
+        }
+        ++written;
+    }
+    printf("Wrote %zu images to %s\n", written, outDir.c_str());
+    return 0;
+}